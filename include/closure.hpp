@@ -0,0 +1,50 @@
+#ifndef HEADER_GUARD_CLOSURE_HPP_INCLUDED
+#define HEADER_GUARD_CLOSURE_HPP_INCLUDED
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+
+#include <expression.hpp>
+
+// Вычислитель на основе замыканий: выражение один раз переводится в набор небольших функций,
+// специализированных по типу узла и виду операндов (число, переменная или другой узел).
+// Числа и номера переменных хранятся прямо в замыкании, поэтому операции вида "x * 2"
+// вычисляются одним прямым вызовом без виртуальной диспетчеризации и поиска в std::map.
+// Замыкания лежат в одном массиве; общие подвыражения переводятся один раз.
+template <typename Value_t> class ClosureEvaluator {
+public:
+    ClosureEvaluator(const Expression<Value_t> &expr);
+
+    // Вычисление по контексту.
+    Value_t eval(std::map<std::string, Value_t> &context) const;
+    // Вычисление по значениям переменных в порядке variables();
+    // регистры берутся из буфера потока, который не освобождается между вызовами.
+    Value_t eval(const Value_t *variables) const;
+    // То же с буфером вызывающего: registers - массив размера size().
+    Value_t eval(const Value_t *variables, Value_t *registers) const;
+
+    // Таблица переменных.
+    const std::vector<std::string> &variables() const;
+    // Количество замыканий.
+    size_t size() const;
+
+    // Замыкание одного узла.
+    struct Closure {
+        // Функция, вычисляющая узел; registers - уже вычисленные значения предыдущих замыканий.
+        Value_t (*call)(const Value_t *registers, const Closure &self, const Value_t *variables);
+        // Номера замыканий (регистров) или переменных операндов.
+        uint32_t left;
+        uint32_t right;
+        // Числовые операнды.
+        Value_t leftValue;
+        Value_t rightValue;
+    };
+
+private:
+    std::vector<Closure> closures_;
+    std::vector<std::string> variables_;
+};
+
+#endif // HEADER_GUARD_CLOSURE_HPP_INCLUDED
\ No newline at end of file
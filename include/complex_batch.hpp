@@ -0,0 +1,60 @@
+#ifndef HEADER_GUARD_COMPLEX_BATCH_HPP_INCLUDED
+#define HEADER_GUARD_COMPLEX_BATCH_HPP_INCLUDED
+
+#include <string>
+#include <vector>
+#include <map>
+#include <complex>
+
+#include <expression.hpp>
+#include <tape.hpp>
+
+// Режим вычисления комплексных операций.
+enum ComplexMode {
+    // Семантика std::complex, включая обработку NaN и бесконечностей.
+    COMPLEX_STRICT = 0,
+    // Прямые формулы без обработки особых значений.
+    COMPLEX_FAST = 1
+};
+
+// Набор комплексных чисел, хранящий действительные и мнимые части в отдельных массивах.
+template <typename Real_t> struct ComplexBatch {
+    std::vector<Real_t> re;
+    std::vector<Real_t> im;
+
+    // Количество чисел в наборе.
+    size_t size() const;
+    // Изменение количества чисел в наборе.
+    void resize(size_t count);
+};
+
+// Пакетный вычислитель комплекснозначных выражений над множеством точек.
+// Вычисление производится блоками точек, каждая инструкция ленты
+// обрабатывает весь блок за один проход.
+template <typename Real_t> class ComplexBatchEvaluator {
+public:
+    // Количество точек в одном блоке вычисления.
+    static constexpr size_t BLOCK_SIZE = 256;
+
+    // Создание вычислителя для выражения.
+    ComplexBatchEvaluator(const Expression<std::complex<long double>> &expr, ComplexMode mode = COMPLEX_STRICT);
+
+    // Вычисление выражения во всех точках.
+    // Все наборы значений переменных должны иметь одинаковый размер.
+    void eval(const std::map<std::string, ComplexBatch<Real_t>> &inputs, ComplexBatch<Real_t> &result);
+
+private:
+    // Лента вычислений выражения.
+    Tape<std::complex<long double>> tape_;
+    // Режим вычисления комплексных операций.
+    ComplexMode mode_;
+    // Рабочие массивы действительных и мнимых частей для каждой инструкции.
+    std::vector<Real_t> registersRe_;
+    std::vector<Real_t> registersIm_;
+
+    // Вычисление блока точек [offset, offset + count).
+    void evalBlock(const std::vector<const ComplexBatch<Real_t>*> &variables,
+                   size_t offset, size_t count, ComplexBatch<Real_t> &result);
+};
+
+#endif // HEADER_GUARD_COMPLEX_BATCH_HPP_INCLUDED
\ No newline at end of file
@@ -0,0 +1,94 @@
+#ifndef HEADER_GUARD_DIFF_CACHE_HPP_INCLUDED
+#define HEADER_GUARD_DIFF_CACHE_HPP_INCLUDED
+
+#include <string>
+#include <list>
+#include <unordered_map>
+#include <filesystem>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+
+#include <expression.hpp>
+
+// Уровень упрощения результата дифференцирования.
+enum SimplifyLevel {
+    // Производная без упрощения.
+    SIMPLIFY_NONE = 0,
+    // Производная, упрощённая функцией prettify.
+    SIMPLIFY_PRETTIFY = 1
+};
+
+// Счётчики обращений к кешу производных.
+struct DiffCacheStats {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t stores;
+    uint64_t evictions;
+    // Текущий суммарный размер записей кеша в байтах.
+    uint64_t bytes;
+};
+
+// Постоянный кеш производных в локальном каталоге.
+//
+// Ключ записи - структурный хеш исходного выражения, переменная дифференцирования
+// и уровень упрощения. Запись хранит исходное выражение, производную, переменную
+// и уровень упрощения в двоичном формате; все они сверяются при чтении, поэтому
+// коллизии хеша не приводят к неверному результату. При превышении допустимого размера
+// удаляются записи, к которым дольше всего не было обращений.
+template <typename Value_t> class DiffCache {
+public:
+    // Допустимый размер кеша по умолчанию.
+    static constexpr uint64_t DEFAULT_CAPACITY = 64ULL << 20;
+
+    // Открытие (и при необходимости создание) каталога кеша.
+    DiffCache(const std::string &directory, uint64_t capacity = DEFAULT_CAPACITY);
+
+    // Взятие производной с использованием кеша.
+    Expression<Value_t> diff(const Expression<Value_t> &expr, const std::string &by,
+                             SimplifyLevel level = SIMPLIFY_PRETTIFY);
+    // Упрощённая производная через кеш; при промахе упрощается уже найденная
+    // производная derivative без упрощения, а не берётся производная заново.
+    Expression<Value_t> prettify(const Expression<Value_t> &expr, const std::string &by,
+                                 const Expression<Value_t> &derivative);
+
+    // Счётчики обращений к кешу.
+    DiffCacheStats stats() const;
+
+private:
+    // Запись в индексе кеша.
+    struct Entry {
+        std::list<std::string>::iterator position;
+        uint64_t size;
+    };
+
+    // Каталог кеша.
+    std::filesystem::path directory_;
+    // Допустимый суммарный размер записей.
+    uint64_t capacity_;
+
+    // Индекс записей: порядок от недавно использованных к давно использованным.
+    mutable std::mutex mutex_;
+    std::list<std::string> recency_;
+    std::unordered_map<std::string, Entry> entries_;
+    uint64_t bytes_;
+
+    // Счётчики обращений.
+    std::atomic<uint64_t> hits_;
+    std::atomic<uint64_t> misses_;
+    std::atomic<uint64_t> stores_;
+    std::atomic<uint64_t> evictions_;
+
+    // Имя записи для выражения, переменной и уровня упрощения.
+    static std::string entry_key(const Expression<Value_t> &expr, const std::string &by, SimplifyLevel level);
+    // Поиск производной в кеше.
+    bool lookup(const std::string &key, const Expression<Value_t> &expr, const std::string &by,
+                SimplifyLevel level, Expression<Value_t> &result);
+    // Сохранение производной в кеш.
+    void store(const std::string &key, const Expression<Value_t> &expr, const std::string &by,
+               SimplifyLevel level, const Expression<Value_t> &result);
+    // Удаление давно использованных записей сверх допустимого размера.
+    void evict();
+};
+
+#endif // HEADER_GUARD_DIFF_CACHE_HPP_INCLUDED
\ No newline at end of file
@@ -3,21 +3,90 @@
 
 #include <string>
 #include <map>
+#include <set>
+#include <vector>
+#include <span>
 #include <memory>
 #include <complex>
+#include <cstddef>
+#include <cstdint>
+
+#include <symbols.hpp>
+
+// Тип узла выражения.
+enum NodeType : uint8_t {
+    // Числовое значение.
+    NODE_VALUE = 0,
+    // Символьная переменная.
+    NODE_VARIABLE = 1,
+    // Операции '+', '-', '*', '/', '^'.
+    NODE_ADD = 2,
+    NODE_SUB = 3,
+    NODE_MUL = 4,
+    NODE_DIV = 5,
+    NODE_POW = 6,
+    // Функции sin, cos, ln, exp.
+    NODE_SIN = 7,
+    NODE_COS = 8,
+    NODE_LN  = 9,
+    NODE_EXP = 10
+};
+
+class ThreadPool;
+class ForkJoinPool;
+
+// Метрики выражения.
+struct ExpressionMetrics {
+    // Количество узлов дерева с учётом повторов общих подвыражений.
+    uint64_t nodes;
+    // Количество различных узлов.
+    uint64_t uniqueNodes;
+    // Наибольшая глубина (у числа и переменной глубина 1).
+    uint64_t depth;
+    // Переменные, от которых зависит выражение.
+    std::set<std::string> freeVariables;
+    // Количество различных узлов каждого типа.
+    std::map<NodeType, uint64_t> histogram;
+    // Оценка занимаемой узлами памяти в байтах.
+    uint64_t bytes;
+};
+
+template <typename Value_t> class ExpressionImpl;
+
+// Результаты обработки операндов узла (по одному на операнд).
+template <typename Value_t>
+using OperandResults = std::span<const std::shared_ptr<ExpressionImpl<Value_t>>>;
 
 // Абстрактный класс, задающий интерфейс между выражением и его реализацией.
 template <typename Value_t> class ExpressionImpl {
 public:
     // Запрет на создание экземпляров класса ExpressionImpl.
     ExpressionImpl() = default;
+    // Создание узла с заданным множеством свободных переменных и высотой.
+    ExpressionImpl(VariableSet variables, uint32_t height = 1);
     virtual ~ExpressionImpl() = default;
 
+    // Приближённое множество свободных переменных, вычисленное при создании узла.
+    const VariableSet &variables() const;
+    // Высота дерева узла (у числа и переменной - 1), вычисленная при создании узла.
+    uint32_t height() const;
+    // Содержит ли выражение переменную. Для номеров от VariableSet::EXACT_IDS, которые
+    // не отсеяны множеством переменных, поддерево обходится; внутри diff ответы для всех
+    // узлов находятся одним обходом на вызов и хранятся вне узлов.
+    bool depends_on(const std::string &name) const;
+    bool depends_on(uint32_t id) const;
+
+    // Общий нулевой узел; его возвращает diff для выражений без переменной дифференцирования.
+    static const std::shared_ptr<ExpressionImpl<Value_t>> &zero();
+
     // Функция вычисления результата выражения.
     virtual Value_t eval(std::map<std::string, Value_t> &context) const = 0;
 
-    // Взятие производной по переменной.
-    virtual std::shared_ptr<ExpressionImpl<Value_t>> diff(const std::string &by) const = 0;
+    // Взятие производной по переменной с номером by в общей таблице имён (intern_symbol):
+    // узлы сравнивают номера, а не строки.
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> diff(uint32_t by) const = 0;
+    // Взятие производной по имени переменной.
+    std::shared_ptr<ExpressionImpl<Value_t>> diff(const std::string &by) const;
 
     // Функция подстановки значений в вырежение.
     virtual std::shared_ptr<ExpressionImpl<Value_t>> substitute(std::map<std::string, Value_t> &context) const = 0;
@@ -25,8 +94,44 @@ public:
     // Функция преобразование выражение в упрощенное.
     virtual std::shared_ptr<ExpressionImpl<Value_t>> prettify() const = 0;
 
+    // Взятие производной узла по уже найденным производным операндов.
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> diff_with(uint32_t by,
+                                                               OperandResults<Value_t> diffs) const = 0;
+
+    // Упрощение узла по уже упрощённым операндам.
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> prettify_with(OperandResults<Value_t> operands) const = 0;
+
+    // Значение узла по уже вычисленным значениям операндов.
+    virtual Value_t eval_with(std::map<std::string, Value_t> &context, std::span<const Value_t> operands) const = 0;
+
+    // Подстановка в узел по уже подставленным операндам.
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> substitute_with(std::map<std::string, Value_t> &context,
+                                                                     OperandResults<Value_t> operands) const = 0;
+
     // Функция преобразования выражения в строку.
     virtual std::string to_string() const = 0;
+
+    // Дописывание в out части записи узла перед операндом position (при position == arity() - после
+    // последнего операнда); позволяет записать выражение в одну строку без рекурсии.
+    virtual void write(std::string &out, size_t position) const = 0;
+
+    // Тип узла выражения.
+    virtual NodeType type() const = 0;
+
+    // Количество подвыражений узла.
+    virtual size_t arity() const = 0;
+
+    // Подвыражение узла с заданным номером.
+    virtual const std::shared_ptr<ExpressionImpl<Value_t>> &operand(size_t index) const = 0;
+
+protected:
+    VariableSet variables_;
+    uint32_t height_ = 1;
+
+    // Освобождение операнда из деструктора узла без рекурсии: операнды, освобождаемые во время
+    // освобождения другого операнда, откладываются в список текущего потока и освобождаются в цикле,
+    // поэтому глубина вложенных деструкторов не зависит от глубины выражения.
+    static void release(std::shared_ptr<ExpressionImpl<Value_t>> &operand);
 };
 
 // Класс, задающий выражение и методы работы с ним.
@@ -35,6 +140,7 @@ public:
     // Создание выражений.
     Expression(const std::string &variable);
     Expression(Value_t val);
+    Expression(std::shared_ptr<ExpressionImpl<Value_t>> impl);
 
     template <typename T>
     friend Expression<T> m_val(T val);
@@ -43,32 +149,79 @@ public:
     friend Expression<T> m_var(const char *var);
 
     // Конструирование выражений на основе других выражений.
-    Expression  operator+ (const Expression &other);
-    Expression  operator- (const Expression &other);
-    Expression  operator* (const Expression &other);
-    Expression  operator/ (const Expression &other);
-    Expression  operator^ (const Expression &other);
-    Expression &operator*=(const Expression &other);
-    Expression &operator-=(const Expression &other);
-    Expression &operator+=(const Expression &other);
-    Expression &operator/=(const Expression &other);
-    Expression &operator^=(const Expression &other);
-
-    Expression sin();
-    Expression cos();
-    Expression ln();
-    Expression exp();
+    // Операнды принимаются по значению: временные выражения перемещаются в новый узел
+    // без изменения счётчиков ссылок, составное присваивание перемещает и левый операнд.
+    Expression  operator+ (Expression other) const &;
+    Expression  operator+ (Expression other) &&;
+    Expression  operator- (Expression other) const &;
+    Expression  operator- (Expression other) &&;
+    Expression  operator* (Expression other) const &;
+    Expression  operator* (Expression other) &&;
+    Expression  operator/ (Expression other) const &;
+    Expression  operator/ (Expression other) &&;
+    Expression  operator^ (Expression other) const &;
+    Expression  operator^ (Expression other) &&;
+    Expression &operator*=(Expression other);
+    Expression &operator-=(Expression other);
+    Expression &operator+=(Expression other);
+    Expression &operator/=(Expression other);
+    Expression &operator^=(Expression other);
+
+    Expression sin() const &;
+    Expression sin() &&;
+    Expression cos() const &;
+    Expression cos() &&;
+    Expression ln() const &;
+    Expression ln() &&;
+    Expression exp() const &;
+    Expression exp() &&;
+
+    // Сумма и произведение набора выражений в виде сбалансированного дерева глубины O(log N):
+    // N - 1 новых узлов, операнды перемещаются. Пустая сумма равна 0, пустое произведение - 1.
+    static Expression sum(std::vector<Expression> terms);
+    static Expression product(std::vector<Expression> factors);
+
+    // Наибольшая высота дерева, обрабатываемого рекурсивными методами узлов; более глубокие выражения
+    // обходятся с явным стеком, и их глубина ограничена только памятью.
+    static const uint32_t MAX_RECURSION_DEPTH = 1024;
 
     // Операции с выражениями.
     Value_t eval(std::map<std::string, Value_t> &context) const;
     Expression diff(const std::string &by) const;
     Expression substitute(std::map<std::string, Value_t> &context) const;
+    // Подстановка значений с одновременным сворачиванием констант и упрощением за один проход;
+    // общие подвыражения обрабатываются один раз и остаются общими.
+    Expression specialize(std::map<std::string, Value_t> &context) const;
     Expression prettify() const;
     std::string to_string() const;
 
-private:
-    Expression(std::shared_ptr<ExpressionImpl<Value_t>> impl);
+    // Упрощённые производные по набору переменных, вычисляемые параллельно;
+    // результаты следуют в порядке переменных. Без пула создаётся временный пул.
+    std::vector<Expression> diff_all(const std::vector<std::string> &vars) const;
+    std::vector<Expression> diff_all(const std::vector<std::string> &vars, ThreadPool &pool) const;
 
+    // Производная и упрощение одного большого выражения с параллельной обработкой поддеревьев.
+    // Поддеревья не больше grain узлов обрабатываются последовательно; результат совпадает с diff и prettify.
+    Expression diff(const std::string &by, ForkJoinPool &pool, uint64_t grain = 4096) const;
+    Expression prettify(ForkJoinPool &pool, uint64_t grain = 4096) const;
+
+    // Коэффициенты ряда Тейлора по переменной by в точке context[by] до степени order
+    // (c[j] = f^(j) / j!), вычисляемые распространением усечённых рядов без построения производных.
+    std::vector<Value_t> taylor(const std::string &by, std::map<std::string, Value_t> &context, size_t order) const;
+
+    // Метрики выражения, вычисляемые за один проход по различным узлам.
+    ExpressionMetrics metrics() const;
+    uint64_t node_count() const;
+    uint64_t unique_node_count() const;
+    uint64_t depth() const;
+    std::set<std::string> free_variables() const;
+    std::map<NodeType, uint64_t> histogram() const;
+    uint64_t byte_footprint() const;
+
+    // Доступ к реализации выражения.
+    const std::shared_ptr<ExpressionImpl<Value_t>> &impl() const;
+
+private:
     std::shared_ptr<ExpressionImpl<Value_t>> impl_;
 };
 
@@ -79,6 +232,18 @@ Expression<T> m_val(T val);
 template <typename T>
 Expression<T> m_var(const char* var);
 
+// Операции с числом слева: 2.0L * x.
+template <typename Value_t>
+Expression<Value_t> operator+(Value_t left, Expression<Value_t> right);
+template <typename Value_t>
+Expression<Value_t> operator-(Value_t left, Expression<Value_t> right);
+template <typename Value_t>
+Expression<Value_t> operator*(Value_t left, Expression<Value_t> right);
+template <typename Value_t>
+Expression<Value_t> operator/(Value_t left, Expression<Value_t> right);
+template <typename Value_t>
+Expression<Value_t> operator^(Value_t left, Expression<Value_t> right);
+
 // Класс, представляющий число в рамках выражения.
 template <typename Value_t> class Value : public ExpressionImpl<Value_t> {
 public:
@@ -89,10 +254,23 @@ public:
 
     // Реализация интерфейса ExpressionImpl.
     virtual Value_t eval(std::map<std::string, Value_t> &context) const override;
-    virtual std::shared_ptr<ExpressionImpl<Value_t>> diff(const std::string &by) const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> diff(uint32_t by) const override;
     virtual std::shared_ptr<ExpressionImpl<Value_t>> substitute(std::map<std::string, Value_t> &context) const override;
     virtual std::shared_ptr<ExpressionImpl<Value_t>> prettify() const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> diff_with(uint32_t by,
+                                                               OperandResults<Value_t> diffs) const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> prettify_with(OperandResults<Value_t> operands) const override;
+    virtual Value_t eval_with(std::map<std::string, Value_t> &context, std::span<const Value_t> operands) const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> substitute_with(std::map<std::string, Value_t> &context,
+                                                                     OperandResults<Value_t> operands) const override;
     virtual std::string to_string() const override;
+    virtual void write(std::string &out, size_t position) const override;
+    virtual NodeType type() const override;
+    virtual size_t arity() const override;
+    virtual const std::shared_ptr<ExpressionImpl<Value_t>> &operand(size_t index) const override;
+
+    // Значение числа.
+    Value_t value() const;
 
 private:
     Value_t value_;
@@ -101,37 +279,65 @@ private:
 // Класс, представляющий переменную в рамках выражения.
 template <typename Value_t> class Variable : public ExpressionImpl<Value_t> {
 public:
-    // Создание переменной на основе её имени.
+    // Создание переменной на основе её имени или номера имени в общей таблице.
     Variable(const std::string &name);
+    Variable(uint32_t id);
 
     virtual ~Variable() override = default;
 
     // Реализация интерфейса ExpressionImpl.
     virtual Value_t eval(std::map<std::string, Value_t> &context) const override;
-    virtual std::shared_ptr<ExpressionImpl<Value_t>> diff(const std::string &by) const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> diff(uint32_t by) const override;
     virtual std::shared_ptr<ExpressionImpl<Value_t>> substitute(std::map<std::string, Value_t> &context) const override;
     virtual std::shared_ptr<ExpressionImpl<Value_t>> prettify() const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> diff_with(uint32_t by,
+                                                               OperandResults<Value_t> diffs) const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> prettify_with(OperandResults<Value_t> operands) const override;
+    virtual Value_t eval_with(std::map<std::string, Value_t> &context, std::span<const Value_t> operands) const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> substitute_with(std::map<std::string, Value_t> &context,
+                                                                     OperandResults<Value_t> operands) const override;
     virtual std::string to_string() const override;
+    virtual void write(std::string &out, size_t position) const override;
+    virtual NodeType type() const override;
+    virtual size_t arity() const override;
+    virtual const std::shared_ptr<ExpressionImpl<Value_t>> &operand(size_t index) const override;
+
+    // Имя переменной.
+    const std::string &name() const;
+    // Номер имени в общей таблице.
+    uint32_t id() const;
 
 private:
-    std::string name_;
+    uint32_t id_;
+    // Имя хранится один раз в общей таблице.
+    const std::string *name_;
 };
 
 // Класс, представляющий выражение сложения двух выражений.
 template <typename Value_t> class OperationAdd : public ExpressionImpl<Value_t> {
 public:
     // Создание выражения для суммы на основе подвыражений.
-    OperationAdd(const std::shared_ptr<ExpressionImpl<Value_t>> &left,
-                 const std::shared_ptr<ExpressionImpl<Value_t>> &right);
+    OperationAdd(std::shared_ptr<ExpressionImpl<Value_t>> left,
+                 std::shared_ptr<ExpressionImpl<Value_t>> right);
 
-    virtual ~OperationAdd() override = default;
+    virtual ~OperationAdd() override;
 
     // Реализация интерфейса ExpressionImpl.
     virtual Value_t eval(std::map<std::string, Value_t> &context) const override;
-    virtual std::shared_ptr<ExpressionImpl<Value_t>> diff(const std::string &by) const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> diff(uint32_t by) const override;
     virtual std::shared_ptr<ExpressionImpl<Value_t>> substitute(std::map<std::string, Value_t> &context) const override;
     virtual std::shared_ptr<ExpressionImpl<Value_t>> prettify() const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> diff_with(uint32_t by,
+                                                               OperandResults<Value_t> diffs) const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> prettify_with(OperandResults<Value_t> operands) const override;
+    virtual Value_t eval_with(std::map<std::string, Value_t> &context, std::span<const Value_t> operands) const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> substitute_with(std::map<std::string, Value_t> &context,
+                                                                     OperandResults<Value_t> operands) const override;
     virtual std::string to_string() const override;
+    virtual void write(std::string &out, size_t position) const override;
+    virtual NodeType type() const override;
+    virtual size_t arity() const override;
+    virtual const std::shared_ptr<ExpressionImpl<Value_t>> &operand(size_t index) const override;
 
 private:
     std::shared_ptr<ExpressionImpl<Value_t>> left_;
@@ -142,17 +348,27 @@ private:
 template <typename Value_t> class OperationSub : public ExpressionImpl<Value_t> {
 public:
     // Создание выражения для вычитания на основе подвыражений.
-    OperationSub(const std::shared_ptr<ExpressionImpl<Value_t>> &left,
-                 const std::shared_ptr<ExpressionImpl<Value_t>> &right);
+    OperationSub(std::shared_ptr<ExpressionImpl<Value_t>> left,
+                 std::shared_ptr<ExpressionImpl<Value_t>> right);
 
-    virtual ~OperationSub() override = default;
+    virtual ~OperationSub() override;
 
     // Реализация интерфейса ExpressionImpl.
     virtual Value_t eval(std::map<std::string, Value_t> &context) const override;
-    virtual std::shared_ptr<ExpressionImpl<Value_t>> diff(const std::string &by) const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> diff(uint32_t by) const override;
     virtual std::shared_ptr<ExpressionImpl<Value_t>> substitute(std::map<std::string, Value_t> &context) const override;
     virtual std::shared_ptr<ExpressionImpl<Value_t>> prettify() const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> diff_with(uint32_t by,
+                                                               OperandResults<Value_t> diffs) const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> prettify_with(OperandResults<Value_t> operands) const override;
+    virtual Value_t eval_with(std::map<std::string, Value_t> &context, std::span<const Value_t> operands) const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> substitute_with(std::map<std::string, Value_t> &context,
+                                                                     OperandResults<Value_t> operands) const override;
     virtual std::string to_string() const override;
+    virtual void write(std::string &out, size_t position) const override;
+    virtual NodeType type() const override;
+    virtual size_t arity() const override;
+    virtual const std::shared_ptr<ExpressionImpl<Value_t>> &operand(size_t index) const override;
 
 private:
     std::shared_ptr<ExpressionImpl<Value_t>> left_;
@@ -163,17 +379,27 @@ private:
 template <typename Value_t> class OperationMul : public ExpressionImpl<Value_t> {
 public:
     // Создание выражения для уможения на основе подвыражений.
-    OperationMul(const std::shared_ptr<ExpressionImpl<Value_t>> &left,
-                 const std::shared_ptr<ExpressionImpl<Value_t>> &right);
+    OperationMul(std::shared_ptr<ExpressionImpl<Value_t>> left,
+                 std::shared_ptr<ExpressionImpl<Value_t>> right);
 
-    virtual ~OperationMul() override = default;
+    virtual ~OperationMul() override;
 
     // Реализация интерфейса ExpressionImpl.
     virtual Value_t eval(std::map<std::string, Value_t> &context) const override;
-    virtual std::shared_ptr<ExpressionImpl<Value_t>> diff(const std::string &by) const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> diff(uint32_t by) const override;
     virtual std::shared_ptr<ExpressionImpl<Value_t>> substitute(std::map<std::string, Value_t> &context) const override;
     virtual std::shared_ptr<ExpressionImpl<Value_t>> prettify() const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> diff_with(uint32_t by,
+                                                               OperandResults<Value_t> diffs) const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> prettify_with(OperandResults<Value_t> operands) const override;
+    virtual Value_t eval_with(std::map<std::string, Value_t> &context, std::span<const Value_t> operands) const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> substitute_with(std::map<std::string, Value_t> &context,
+                                                                     OperandResults<Value_t> operands) const override;
     virtual std::string to_string() const override;
+    virtual void write(std::string &out, size_t position) const override;
+    virtual NodeType type() const override;
+    virtual size_t arity() const override;
+    virtual const std::shared_ptr<ExpressionImpl<Value_t>> &operand(size_t index) const override;
 
 private:
     std::shared_ptr<ExpressionImpl<Value_t>> left_;
@@ -184,17 +410,27 @@ private:
 template <typename Value_t> class OperationDiv : public ExpressionImpl<Value_t> {
 public:
     // Создание выражения для деления на основе подвыражений.
-    OperationDiv(const std::shared_ptr<ExpressionImpl<Value_t>> &left,
-                 const std::shared_ptr<ExpressionImpl<Value_t>> &right);
+    OperationDiv(std::shared_ptr<ExpressionImpl<Value_t>> left,
+                 std::shared_ptr<ExpressionImpl<Value_t>> right);
 
-    virtual ~OperationDiv() override = default;
+    virtual ~OperationDiv() override;
 
     // Реализация интерфейса ExpressionImpl.
     virtual Value_t eval(std::map<std::string, Value_t> &context) const override;
-    virtual std::shared_ptr<ExpressionImpl<Value_t>> diff(const std::string &by) const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> diff(uint32_t by) const override;
     virtual std::shared_ptr<ExpressionImpl<Value_t>> substitute(std::map<std::string, Value_t> &context) const override;
     virtual std::shared_ptr<ExpressionImpl<Value_t>> prettify() const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> diff_with(uint32_t by,
+                                                               OperandResults<Value_t> diffs) const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> prettify_with(OperandResults<Value_t> operands) const override;
+    virtual Value_t eval_with(std::map<std::string, Value_t> &context, std::span<const Value_t> operands) const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> substitute_with(std::map<std::string, Value_t> &context,
+                                                                     OperandResults<Value_t> operands) const override;
     virtual std::string to_string() const override;
+    virtual void write(std::string &out, size_t position) const override;
+    virtual NodeType type() const override;
+    virtual size_t arity() const override;
+    virtual const std::shared_ptr<ExpressionImpl<Value_t>> &operand(size_t index) const override;
 
 private:
     std::shared_ptr<ExpressionImpl<Value_t>> left_;
@@ -205,37 +441,122 @@ private:
 template <typename Value_t> class OperationPow : public ExpressionImpl<Value_t> {
 public:
     // Создание выражения для возведения в степень на основе подвыражений.
-    OperationPow(const std::shared_ptr<ExpressionImpl<Value_t>> &left,
-                 const std::shared_ptr<ExpressionImpl<Value_t>> &right);
+    OperationPow(std::shared_ptr<ExpressionImpl<Value_t>> left,
+                 std::shared_ptr<ExpressionImpl<Value_t>> right);
+
+    virtual ~OperationPow() override;
+
+    // Реализация интерфейса ExpressionImpl.
+    virtual Value_t eval(std::map<std::string, Value_t> &context) const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> diff(uint32_t by) const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> substitute(std::map<std::string, Value_t> &context) const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> prettify() const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> diff_with(uint32_t by,
+                                                               OperandResults<Value_t> diffs) const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> prettify_with(OperandResults<Value_t> operands) const override;
+    virtual Value_t eval_with(std::map<std::string, Value_t> &context, std::span<const Value_t> operands) const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> substitute_with(std::map<std::string, Value_t> &context,
+                                                                     OperandResults<Value_t> operands) const override;
+    virtual std::string to_string() const override;
+    virtual void write(std::string &out, size_t position) const override;
+    virtual NodeType type() const override;
+    virtual size_t arity() const override;
+    virtual const std::shared_ptr<ExpressionImpl<Value_t>> &operand(size_t index) const override;
+
+private:
+    std::shared_ptr<ExpressionImpl<Value_t>> left_;
+    std::shared_ptr<ExpressionImpl<Value_t>> right_;
+};
+
+// Показатель степени, разобранный один раз: целые и полуцелые показатели до MAX_SQUARING
+// по модулю вычисляются умножениями (возведением в квадрат) и sqrt, остальные - через pow.
+template <typename Value_t> class PowerExponent {
+public:
+    // Наибольший модуль показателя, возводимого умножениями; при больших показателях
+    // цепочка умножений в long double медленнее pow.
+    static const int MAX_SQUARING = 4;
+
+    PowerExponent(Value_t exponent);
 
-    virtual ~OperationPow() override = default;
+    Value_t apply(const Value_t &base) const;
+    Value_t value() const;
+
+private:
+    Value_t exponent_;
+    // Удвоенный модуль показателя; -1, если показатель вычисляется через pow.
+    int twice_;
+    bool negative_;
+};
+
+// Класс, представляющий возведение в постоянную степень.
+// Тип узла - NODE_POW, показатель хранится и как число, и как узел-операнд, поэтому
+// обходы, ленты и сериализация работают с ним так же, как с OperationPow.
+template <typename Value_t> class OperationPowConst : public ExpressionImpl<Value_t> {
+public:
+    // Создание выражения для возведения в степень на основе основания и показателя.
+    OperationPowConst(std::shared_ptr<ExpressionImpl<Value_t>> left, Value_t exponent);
+
+    virtual ~OperationPowConst() override;
 
     // Реализация интерфейса ExpressionImpl.
     virtual Value_t eval(std::map<std::string, Value_t> &context) const override;
-    virtual std::shared_ptr<ExpressionImpl<Value_t>> diff(const std::string &by) const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> diff(uint32_t by) const override;
     virtual std::shared_ptr<ExpressionImpl<Value_t>> substitute(std::map<std::string, Value_t> &context) const override;
     virtual std::shared_ptr<ExpressionImpl<Value_t>> prettify() const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> diff_with(uint32_t by,
+                                                               OperandResults<Value_t> diffs) const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> prettify_with(OperandResults<Value_t> operands) const override;
+    virtual Value_t eval_with(std::map<std::string, Value_t> &context, std::span<const Value_t> operands) const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> substitute_with(std::map<std::string, Value_t> &context,
+                                                                     OperandResults<Value_t> operands) const override;
     virtual std::string to_string() const override;
+    virtual void write(std::string &out, size_t position) const override;
+    virtual NodeType type() const override;
+    virtual size_t arity() const override;
+    virtual const std::shared_ptr<ExpressionImpl<Value_t>> &operand(size_t index) const override;
+
+    // Показатель степени.
+    Value_t exponent() const;
 
 private:
     std::shared_ptr<ExpressionImpl<Value_t>> left_;
     std::shared_ptr<ExpressionImpl<Value_t>> right_;
+    PowerExponent<Value_t> exponent_;
 };
 
+// Возведение в степень с разбором показателя при каждом вызове (см. PowerExponent).
+template <typename Value_t>
+Value_t power(const Value_t &base, const Value_t &exponent);
+
+// Узел степени: OperationPowConst для числового показателя, иначе OperationPow.
+template <typename Value_t>
+std::shared_ptr<ExpressionImpl<Value_t>> make_power(std::shared_ptr<ExpressionImpl<Value_t>> left,
+                                                    std::shared_ptr<ExpressionImpl<Value_t>> right);
+
 // Класс, представляющий выражение взятия синуса.
 template <typename Value_t> class OperationSin : public ExpressionImpl<Value_t> {
 public:
     // Создание выражения для взятия синуса на основе подвыражения.
-    OperationSin(const std::shared_ptr<ExpressionImpl<Value_t>> &agrument);
+    OperationSin(std::shared_ptr<ExpressionImpl<Value_t>> argument);
 
-    virtual ~OperationSin() override = default;
+    virtual ~OperationSin() override;
 
     // Реализация интерфейса ExpressionImpl.
     virtual Value_t eval(std::map<std::string, Value_t> &context) const override;
-    virtual std::shared_ptr<ExpressionImpl<Value_t>> diff(const std::string &by) const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> diff(uint32_t by) const override;
     virtual std::shared_ptr<ExpressionImpl<Value_t>> substitute(std::map<std::string, Value_t> &context) const override;
     virtual std::shared_ptr<ExpressionImpl<Value_t>> prettify() const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> diff_with(uint32_t by,
+                                                               OperandResults<Value_t> diffs) const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> prettify_with(OperandResults<Value_t> operands) const override;
+    virtual Value_t eval_with(std::map<std::string, Value_t> &context, std::span<const Value_t> operands) const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> substitute_with(std::map<std::string, Value_t> &context,
+                                                                     OperandResults<Value_t> operands) const override;
     virtual std::string to_string() const override;
+    virtual void write(std::string &out, size_t position) const override;
+    virtual NodeType type() const override;
+    virtual size_t arity() const override;
+    virtual const std::shared_ptr<ExpressionImpl<Value_t>> &operand(size_t index) const override;
 
 private:
     std::shared_ptr<ExpressionImpl<Value_t>> argument_;
@@ -245,16 +566,26 @@ private:
 template <typename Value_t> class OperationCos : public ExpressionImpl<Value_t> {
 public:
     // Создание выражения для взятия косинуса на основе подвыражения.
-    OperationCos(const std::shared_ptr<ExpressionImpl<Value_t>> &agrument);
+    OperationCos(std::shared_ptr<ExpressionImpl<Value_t>> argument);
 
-    virtual ~OperationCos() override = default;
+    virtual ~OperationCos() override;
 
     // Реализация интерфейса ExpressionImpl.
     virtual Value_t eval(std::map<std::string, Value_t> &context) const override;
-    virtual std::shared_ptr<ExpressionImpl<Value_t>> diff(const std::string &by) const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> diff(uint32_t by) const override;
     virtual std::shared_ptr<ExpressionImpl<Value_t>> substitute(std::map<std::string, Value_t> &context) const override;
     virtual std::shared_ptr<ExpressionImpl<Value_t>> prettify() const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> diff_with(uint32_t by,
+                                                               OperandResults<Value_t> diffs) const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> prettify_with(OperandResults<Value_t> operands) const override;
+    virtual Value_t eval_with(std::map<std::string, Value_t> &context, std::span<const Value_t> operands) const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> substitute_with(std::map<std::string, Value_t> &context,
+                                                                     OperandResults<Value_t> operands) const override;
     virtual std::string to_string() const override;
+    virtual void write(std::string &out, size_t position) const override;
+    virtual NodeType type() const override;
+    virtual size_t arity() const override;
+    virtual const std::shared_ptr<ExpressionImpl<Value_t>> &operand(size_t index) const override;
 
 private:
     std::shared_ptr<ExpressionImpl<Value_t>> argument_;
@@ -264,16 +595,26 @@ private:
 template <typename Value_t> class OperationLn : public ExpressionImpl<Value_t> {
 public:
     // Создание выражения для взятия логарифма на основе подвыражения.
-    OperationLn(const std::shared_ptr<ExpressionImpl<Value_t>> &agrument);
+    OperationLn(std::shared_ptr<ExpressionImpl<Value_t>> argument);
 
-    virtual ~OperationLn() override = default;
+    virtual ~OperationLn() override;
 
     // Реализация интерфейса ExpressionImpl.
     virtual Value_t eval(std::map<std::string, Value_t> &context) const override;
-    virtual std::shared_ptr<ExpressionImpl<Value_t>> diff(const std::string &by) const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> diff(uint32_t by) const override;
     virtual std::shared_ptr<ExpressionImpl<Value_t>> substitute(std::map<std::string, Value_t> &context) const override;
     virtual std::shared_ptr<ExpressionImpl<Value_t>> prettify() const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> diff_with(uint32_t by,
+                                                               OperandResults<Value_t> diffs) const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> prettify_with(OperandResults<Value_t> operands) const override;
+    virtual Value_t eval_with(std::map<std::string, Value_t> &context, std::span<const Value_t> operands) const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> substitute_with(std::map<std::string, Value_t> &context,
+                                                                     OperandResults<Value_t> operands) const override;
     virtual std::string to_string() const override;
+    virtual void write(std::string &out, size_t position) const override;
+    virtual NodeType type() const override;
+    virtual size_t arity() const override;
+    virtual const std::shared_ptr<ExpressionImpl<Value_t>> &operand(size_t index) const override;
 
 private:
     std::shared_ptr<ExpressionImpl<Value_t>> argument_;
@@ -283,16 +624,26 @@ private:
 template <typename Value_t> class OperationExp : public ExpressionImpl<Value_t> {
 public:
     // Создание выражения для взятия степенной функции от экспоненты.
-    OperationExp(const std::shared_ptr<ExpressionImpl<Value_t>> &agrument);
+    OperationExp(std::shared_ptr<ExpressionImpl<Value_t>> argument);
 
-    virtual ~OperationExp() override = default;
+    virtual ~OperationExp() override;
 
     // Реализация интерфейса ExpressionImpl.
     virtual Value_t eval(std::map<std::string, Value_t> &context) const override;
-    virtual std::shared_ptr<ExpressionImpl<Value_t>> diff(const std::string &by) const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> diff(uint32_t by) const override;
     virtual std::shared_ptr<ExpressionImpl<Value_t>> substitute(std::map<std::string, Value_t> &context) const override;
     virtual std::shared_ptr<ExpressionImpl<Value_t>> prettify() const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> diff_with(uint32_t by,
+                                                               OperandResults<Value_t> diffs) const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> prettify_with(OperandResults<Value_t> operands) const override;
+    virtual Value_t eval_with(std::map<std::string, Value_t> &context, std::span<const Value_t> operands) const override;
+    virtual std::shared_ptr<ExpressionImpl<Value_t>> substitute_with(std::map<std::string, Value_t> &context,
+                                                                     OperandResults<Value_t> operands) const override;
     virtual std::string to_string() const override;
+    virtual void write(std::string &out, size_t position) const override;
+    virtual NodeType type() const override;
+    virtual size_t arity() const override;
+    virtual const std::shared_ptr<ExpressionImpl<Value_t>> &operand(size_t index) const override;
 
 private:
     std::shared_ptr<ExpressionImpl<Value_t>> argument_;
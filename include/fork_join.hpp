@@ -0,0 +1,79 @@
+#ifndef HEADER_GUARD_FORK_JOIN_HPP_INCLUDED
+#define HEADER_GUARD_FORK_JOIN_HPP_INCLUDED
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <exception>
+
+// Пул потоков для рекурсивного параллелизма вида "разделяй и властвуй".
+// У каждого исполнителя своя очередь задач: новые задачи кладутся и берутся с конца,
+// а свободные исполнители крадут самые старые (обычно самые крупные) задачи с начала чужих очередей.
+class ForkJoinPool {
+public:
+    // Создание пула; при workers == 0 используется число аппаратных потоков.
+    ForkJoinPool(size_t workers = 0);
+
+    // Создание, удаление, копирование и перемещение пула.
+    ~ForkJoinPool();
+
+    ForkJoinPool(const ForkJoinPool&) = delete;
+    ForkJoinPool(ForkJoinPool&&) = delete;
+
+    ForkJoinPool& operator=(const ForkJoinPool&) = delete;
+    ForkJoinPool& operator=(ForkJoinPool&&) = delete;
+
+    // Выполнение задачи на исполнителе пула с ожиданием её завершения.
+    // Исключение из задачи передаётся вызывающему.
+    void run(const std::function<void()> &task);
+
+    // Параллельное выполнение двух задач из задачи этого пула: вторая задача становится
+    // доступной для кражи, первая выполняется сразу. Вне пула задачи выполняются по очереди.
+    void fork_join(const std::function<void()> &first, const std::function<void()> &second);
+
+    // Количество исполнителей пула.
+    size_t size() const;
+
+private:
+    struct Task {
+        const std::function<void()> *function;
+        std::atomic<bool> done;
+        std::exception_ptr error;
+        // Задача поставлена извне пула, и её завершения ждут на условной переменной.
+        bool external;
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task*> tasks;
+        std::thread thread;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    // Задачи, поставленные извне пула.
+    std::deque<Task*> injected_;
+    // Количество задач во всех очередях.
+    size_t pending_;
+    // Признак завершения работы пула.
+    bool stopping_;
+
+    std::mutex mutex_;
+    // Появление задачи в одной из очередей.
+    std::condition_variable available_;
+    // Завершение задачи, поставленной извне.
+    std::condition_variable finished_;
+
+    // Получение задачи: из своей очереди, из внешней очереди или кражей у другого исполнителя.
+    Task *take(size_t index);
+    // Выполнение задачи с сохранением исключения.
+    void execute(Task *task);
+    // Цикл обработки задач исполнителем.
+    void work(size_t index);
+};
+
+#endif // HEADER_GUARD_FORK_JOIN_HPP_INCLUDED
\ No newline at end of file
@@ -0,0 +1,73 @@
+#ifndef HEADER_GUARD_FROZEN_HPP_INCLUDED
+#define HEADER_GUARD_FROZEN_HPP_INCLUDED
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+#include <cstddef>
+
+#include <expression.hpp>
+
+// Узел замороженного выражения (12 байт).
+struct FrozenNode {
+    // Тип узла выражения; степень с числовым показателем - NODE_POW с операндом-числом.
+    NodeType type;
+    // Номера узлов-операндов (у функций используется только left).
+    // Для чисел в left хранится номер в таблице констант, для переменных - в таблице переменных.
+    uint32_t left;
+    uint32_t right;
+};
+
+// Неизменяемое выражение в одном непрерывном массиве узлов в топологическом порядке
+// (операнды раньше операций, корень последний) с отдельными таблицами констант и переменных.
+// Вычисление, производная и упрощение выполняются проходами по массиву без рекурсии и
+// без выделения памяти на каждый узел; результаты совпадают с методами Expression.
+template <typename Value_t> class FrozenExpression {
+public:
+    // Замораживание выражения; общие подвыражения записываются один раз.
+    FrozenExpression(const Expression<Value_t> &expr);
+
+    // Восстановление выражения с сохранением общих подвыражений.
+    Expression<Value_t> expression() const;
+
+    Value_t eval(std::map<std::string, Value_t> &context) const;
+    // Значения переменных передаются в порядке таблицы variables();
+    // регистры берутся из буфера потока, который не освобождается между вызовами.
+    Value_t eval(const Value_t *variables) const;
+    // То же с буфером вызывающего: registers - массив размера size().
+    Value_t eval(const Value_t *variables, Value_t *registers) const;
+
+    FrozenExpression diff(const std::string &by) const;
+    FrozenExpression prettify() const;
+
+    // Количество узлов.
+    size_t size() const;
+    // Объём памяти узлов и таблиц в байтах.
+    uint64_t byte_footprint() const;
+
+    // Доступ к составляющим представления.
+    const std::vector<FrozenNode> &nodes() const;
+    const std::vector<Value_t> &constants() const;
+    // Номера имён переменных в общей таблице (intern_symbol).
+    const std::vector<uint32_t> &variables() const;
+
+private:
+    FrozenExpression() = default;
+
+    std::vector<FrozenNode> nodes_;
+    std::vector<Value_t> constants_;
+    std::vector<uint32_t> variables_;
+
+    // Добавление узлов в конец массива.
+    uint32_t append(NodeType type, uint32_t left, uint32_t right = 0);
+    uint32_t append_value(Value_t value);
+
+    bool is_value(uint32_t node) const;
+    Value_t value(uint32_t node) const;
+
+    // Удаление узлов, недостижимых из root, с сохранением порядка; root становится последним.
+    void compact(uint32_t root);
+};
+
+#endif // HEADER_GUARD_FROZEN_HPP_INCLUDED
\ No newline at end of file
@@ -0,0 +1,101 @@
+#ifndef HEADER_GUARD_GENERATOR_HPP_INCLUDED
+#define HEADER_GUARD_GENERATOR_HPP_INCLUDED
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <random>
+#include <cstdint>
+
+#include <expression.hpp>
+
+// Параметры генерации случайных выражений.
+struct GeneratorOptions {
+    // Начальное значение генератора случайных чисел.
+    uint64_t seed = 1;
+    // Желаемое количество различных узлов выражения.
+    size_t nodes = 100;
+    // Максимальная глубина выражения.
+    size_t depth = 32;
+    // Количество различных переменных.
+    size_t variables = 1;
+    // Относительные веса операций; операции с нулевым весом не используются.
+    std::map<NodeType, double> mix = {
+        {NODE_ADD, 1.0}, {NODE_SUB, 1.0}, {NODE_MUL, 1.0}, {NODE_DIV, 1.0}, {NODE_POW, 1.0},
+        {NODE_SIN, 1.0}, {NODE_COS, 1.0}, {NODE_LN,  1.0}, {NODE_EXP, 1.0}
+    };
+    // Доля операндов, ссылающихся на уже построенные подвыражения.
+    double sharing = 0.0;
+    // Диапазон значений переменных в случайных точках.
+    long double pointMin = 0.5L;
+    long double pointMax = 2.0L;
+};
+
+// Результат сравнения символьной производной с численной.
+struct DerivativeCheck {
+    // Количество сравнённых точек.
+    size_t points;
+    // Точки вне области определения или с неустойчивой численной производной.
+    size_t skipped;
+    // Точки с расхождением больше допустимого.
+    size_t mismatches;
+    // Наибольшая относительная погрешность среди сравнённых точек.
+    long double maxError;
+};
+
+// Генератор случайных выражений с заданным размером, глубиной, набором операций
+// и долей общих подвыражений. При одинаковых параметрах результат воспроизводим.
+class ExpressionGenerator {
+public:
+    typedef long double Value_t;
+
+    ExpressionGenerator(const GeneratorOptions &options);
+
+    // Построение случайного выражения.
+    Expression<Value_t> expression();
+
+    // Запись выражения в текстовом виде, пригодном для разбора парсером.
+    // Общие подвыражения записываются столько раз, сколько на них ссылаются.
+    static std::string text(const Expression<Value_t> &expr);
+
+    // Имена переменных генерируемых выражений.
+    const std::vector<std::string> &variables() const;
+
+    // Случайная точка вычисления.
+    std::map<std::string, Value_t> point();
+
+    // Сравнение производной с центральной разностной производной в случайных точках.
+    DerivativeCheck check_derivative(const Expression<Value_t> &expr, const Expression<Value_t> &derivative,
+                                     const std::string &by, size_t points, Value_t tolerance = 1e-5L);
+
+private:
+    // Построенное подвыражение, его высота и количество созданных для него узлов.
+    struct Built {
+        std::shared_ptr<ExpressionImpl<Value_t>> node;
+        size_t height;
+        size_t nodes;
+    };
+
+    GeneratorOptions options_;
+    std::mt19937_64 random_;
+    std::vector<std::string> variables_;
+    // Выборка построенных подвыражений для повторного использования.
+    std::vector<Built> reservoir_;
+    uint64_t built_;
+
+    // Построение подвыражения из не более чем budget узлов высотой не более depth.
+    // Глубина рекурсии ограничена параметром depth.
+    Built build(size_t budget, size_t depth);
+    Built leaf();
+    // Выбор построенного ранее подвыражения высотой не более depth с вероятностью sharing.
+    bool share(size_t depth, Built &shared);
+    // Запоминание подвыражения для повторного использования.
+    void remember(const Built &built);
+
+    // Случайные числа, не зависящие от реализации стандартных распределений.
+    uint64_t uniform(uint64_t bound);
+    double uniform_real();
+};
+
+#endif // HEADER_GUARD_GENERATOR_HPP_INCLUDED
\ No newline at end of file
@@ -0,0 +1,18 @@
+#ifndef HEADER_GUARD_HASH_HPP_INCLUDED
+#define HEADER_GUARD_HASH_HPP_INCLUDED
+
+#include <cstdint>
+
+#include <expression.hpp>
+
+// Структурный хеш выражения.
+// Зависит только от формы дерева выражения, но не от того,
+// какие подвыражения разделяются между собой в памяти.
+template <typename Value_t>
+uint64_t structural_hash(const Expression<Value_t> &expr);
+
+// Структурное сравнение двух выражений.
+template <typename Value_t>
+bool structurally_equal(const Expression<Value_t> &first, const Expression<Value_t> &second);
+
+#endif // HEADER_GUARD_HASH_HPP_INCLUDED
\ No newline at end of file
@@ -0,0 +1,49 @@
+#ifndef HEADER_GUARD_INCREMENTAL_HPP_INCLUDED
+#define HEADER_GUARD_INCREMENTAL_HPP_INCLUDED
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <cstdint>
+
+#include <expression.hpp>
+#include <tape.hpp>
+
+// Вычислитель с сохранением значений всех узлов между вычислениями.
+// После set() пересчитываются только инструкции ленты, зависящие от изменённых переменных,
+// поэтому при изменении нескольких переменных из многих обновление намного дешевле полного вычисления.
+template <typename Value_t> class IncrementalEvaluator {
+public:
+    // Построение и полное вычисление; контекст должен содержать все переменные выражения.
+    IncrementalEvaluator(const Expression<Value_t> &expr, std::map<std::string, Value_t> &context);
+
+    // Изменение значения переменной; переменные, от которых выражение не зависит, пропускаются.
+    void set(const std::string &name, Value_t value);
+
+    // Значение выражения с пересчётом зависящих от изменённых переменных узлов.
+    Value_t value();
+
+    // Количество инструкций, пересчитанных при последнем обновлении.
+    size_t recomputed() const;
+
+private:
+    Tape<Value_t> tape_;
+    std::unordered_map<std::string, uint32_t> variableIndex_;
+    std::vector<Value_t> values_;
+    std::vector<Value_t> registers_;
+
+    // Для каждой переменной - номера зависящих от неё инструкций по возрастанию
+    // (строки dependents_ с началами в dependentOffsets_). Построение - два прохода
+    // по ленте на каждые 64 переменные, O(N * V / 64) плюс суммарная длина списков.
+    std::vector<uint32_t> dependentOffsets_;
+    std::vector<uint32_t> dependents_;
+
+    // Изменённые с последнего вычисления переменные и номера инструкций для пересчёта.
+    std::vector<uint32_t> dirty_;
+    std::vector<uint32_t> pending_;
+    std::vector<uint32_t> merged_;
+    size_t recomputed_;
+};
+
+#endif // HEADER_GUARD_INCREMENTAL_HPP_INCLUDED
\ No newline at end of file
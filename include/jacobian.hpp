@@ -0,0 +1,60 @@
+#ifndef HEADER_GUARD_JACOBIAN_HPP_INCLUDED
+#define HEADER_GUARD_JACOBIAN_HPP_INCLUDED
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstddef>
+
+#include <expression.hpp>
+#include <tape.hpp>
+#include <thread_pool.hpp>
+
+// Разреженная матрица Якоби набора выражений по набору переменных.
+// Структура матрицы определяется по свободным переменным каждого выражения:
+// производные берутся только для структурно ненулевых элементов.
+// Элементы хранятся в формате CSR (по строкам, внутри строки - в порядке переменных).
+template <typename Value_t> class SparseJacobian {
+public:
+    // Построение матрицы; с пулом производные берутся параллельно.
+    SparseJacobian(const std::vector<Expression<Value_t>> &functions, const std::vector<std::string> &variables);
+    SparseJacobian(const std::vector<Expression<Value_t>> &functions, const std::vector<std::string> &variables,
+                   ThreadPool &pool);
+
+    // Размеры матрицы и количество структурно ненулевых элементов.
+    size_t rows() const;
+    size_t cols() const;
+    size_t nonzeros() const;
+
+    // Формат CSR: элементы строки i занимают позиции [row_offsets()[i], row_offsets()[i + 1]).
+    const std::vector<size_t> &row_offsets() const;
+    const std::vector<size_t> &columns() const;
+    const std::vector<Expression<Value_t>> &derivatives() const;
+
+    // Номера строк элементов; вместе с columns() образуют формат COO.
+    std::vector<size_t> row_indices() const;
+
+    // Значения элементов в порядке CSR.
+    std::vector<Value_t> eval(std::map<std::string, Value_t> &context) const;
+    // Значения элементов в наборе точек; точка задаёт значения переменных в порядке конструктора.
+    // Все переменные производных должны входить в набор переменных матрицы.
+    std::vector<std::vector<Value_t>> eval_batch(const std::vector<std::vector<Value_t>> &points) const;
+
+private:
+    std::vector<std::string> variables_;
+    std::vector<size_t> rowOffsets_;
+    std::vector<size_t> columns_;
+    std::vector<Expression<Value_t>> derivatives_;
+
+    // Лента всех производных с общими подвыражениями.
+    Tape<Value_t> tape_;
+    // Позиции переменных ленты среди переменных матрицы.
+    std::vector<size_t> positions_;
+
+    // Структура матрицы по свободным переменным выражений.
+    void build_pattern(const std::vector<Expression<Value_t>> &functions);
+    // Лента и позиции переменных по найденным производным.
+    void compile();
+};
+
+#endif // HEADER_GUARD_JACOBIAN_HPP_INCLUDED
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <iostream>
 #include <string>
 #include <regex>
+#include <vector>
 
 // Тип лексемы языка выражений.
 enum TokenType {
@@ -50,6 +51,8 @@ class Lexer {
 public:
     // Создание лексера для разбора строки.
     Lexer(const std::string& input);
+    // Создание лексера, выдающего заранее считанные лексемы.
+    Lexer(std::vector<Token> tokens);
 
     // Создание, удаление, копирование и перемещение лексического анализатора.
     Lexer()  = delete;
@@ -64,6 +67,9 @@ public:
     // Извлечение следующей лексемы строки.
     Token getNextToken();
 
+    // Считывание всех оставшихся лексем строки, включая завершающую TOK_EOF.
+    std::vector<Token> tokenize();
+
 private:
     // Текст для лексического разбора.
     std::string input_;
@@ -74,6 +80,11 @@ private:
     // Номер символа в строке разбираемого текста.
     size_t column_;
 
+    // Заранее считанные лексемы и номер следующей выдаваемой.
+    bool replay_;
+    std::vector<Token> tokens_;
+    size_t next_;
+
     // Просмотр следующего символа текста без извлечения.
     char peek() const;
 
@@ -0,0 +1,52 @@
+#ifndef HEADER_GUARD_POLYNOMIAL_HPP_INCLUDED
+#define HEADER_GUARD_POLYNOMIAL_HPP_INCLUDED
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+#include <expression.hpp>
+
+// Многочлен от одной переменной с плотным набором коэффициентов: c[0] + c[1] x + ... + c[n] x^n.
+template <typename Value_t> class Polynomial {
+public:
+    // Наибольшая степень распознаваемых многочленов.
+    static const size_t MAX_DEGREE = 64;
+
+    Polynomial(const std::string &variable, const std::vector<Value_t> &coefficients);
+
+    // Распознавание многочлена в выражении из сумм, разностей, произведений, делений на число
+    // и натуральных степеней; false, если выражение не является многочленом от одной переменной.
+    // Для выражения без переменных variable() пусто, а степень равна нулю.
+    static bool recognize(const Expression<Value_t> &expr, Polynomial &result);
+
+    const std::string &variable() const;
+    const std::vector<Value_t> &coefficients() const;
+    size_t degree() const;
+
+    // Вычисление по схеме Горнера.
+    Value_t eval(Value_t x) const;
+    // Вычисление по схеме Эстрина: независимые пары коэффициентов сворачиваются по степеням x^2, x^4, ...
+    Value_t eval_estrin(Value_t x) const;
+    // Вычисление в наборе точек; внутренний цикл идёт по точкам и допускает векторизацию.
+    void eval(const Value_t *points, Value_t *results, size_t count) const;
+
+    // Производная, вычисляемая по коэффициентам.
+    Polynomial derivative() const;
+
+    // Выражение по схеме Горнера без вызовов pow.
+    Expression<Value_t> to_expression() const;
+
+private:
+    std::string variable_;
+    std::vector<Value_t> coefficients_;
+};
+
+// Замена многочленных подвыражений степени не ниже 2 и постоянных подвыражений
+// их записью по схеме Горнера и числами соответственно. Заменяются только многочлены
+// в раскрытом виде; разложенные на множители ((x - 1)^20) сохраняются, так как
+// раскрытие скобок вблизи корней теряет точность.
+template <typename Value_t>
+Expression<Value_t> horner_form(const Expression<Value_t> &expr);
+
+#endif // HEADER_GUARD_POLYNOMIAL_HPP_INCLUDED
\ No newline at end of file
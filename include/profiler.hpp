@@ -0,0 +1,70 @@
+#ifndef HEADER_GUARD_PROFILER_HPP_INCLUDED
+#define HEADER_GUARD_PROFILER_HPP_INCLUDED
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <cstdint>
+
+#include <expression.hpp>
+
+// Счётчики профилировщика.
+struct ProfileCounters {
+    // Количество вычислений.
+    uint64_t calls;
+    // Такты с учётом вычисления операндов.
+    uint64_t cycles;
+    // Такты без учёта вычисления операндов.
+    uint64_t selfCycles;
+};
+
+// Профилирующий вычислитель выражения.
+// Обходит выражение самостоятельно через интерфейс type()/operand(),
+// поэтому обычный eval() не содержит никакого кода профилирования.
+// Счётчики накапливаются по всем вызовам eval() до вызова reset().
+template <typename Value_t> class Profiler {
+public:
+    Profiler(const Expression<Value_t> &expr);
+
+    // Вычисление выражения со сбором счётчиков.
+    Value_t eval(std::map<std::string, Value_t> &context);
+
+    // Сброс накопленных счётчиков.
+    void reset();
+
+    // Счётчики по типам узлов.
+    std::map<NodeType, ProfileCounters> by_type() const;
+    // Счётчики по узлам (узел, входящий в несколько путей, учитывается один раз).
+    std::unordered_map<const ExpressionImpl<Value_t>*, ProfileCounters> by_node() const;
+
+    // Отчёт в формате свёрнутых стеков ("кадр;кадр;кадр такты") для построения flame graph.
+    // Кадр - имя класса узла и номер операнда у родителя, например "OperationPow#1".
+    std::string folded() const;
+
+private:
+    // Узел дерева путей: один и тот же узел выражения может встречаться на нескольких путях.
+    struct Path {
+        const ExpressionImpl<Value_t> *node;
+        uint32_t parent;
+        uint32_t slot;
+        uint32_t children[2];
+        uint64_t calls;
+        uint64_t cycles;
+    };
+
+    Expression<Value_t> expr_;
+    std::vector<Path> paths_;
+
+    // Вычисление поддерева пути root со сбором счётчиков (без рекурсии).
+    Value_t visit(uint32_t root, std::map<std::string, Value_t> &context);
+    uint32_t child(uint32_t path, uint32_t slot);
+
+    // Такты, затраченные на вычисление операндов пути.
+    uint64_t children_cycles(const Path &path) const;
+};
+
+// Имя класса узла заданного типа.
+const char *node_type_name(NodeType type);
+
+#endif // HEADER_GUARD_PROFILER_HPP_INCLUDED
\ No newline at end of file
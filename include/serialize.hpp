@@ -0,0 +1,89 @@
+#ifndef HEADER_GUARD_SERIALIZE_HPP_INCLUDED
+#define HEADER_GUARD_SERIALIZE_HPP_INCLUDED
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include <expression.hpp>
+#include <tape.hpp>
+
+// Двоичный формат набора выражений.
+//
+// Заголовок BinaryHeader, затем секции, выровненные на 16 байт:
+//   узлы      - node_count записей TapeInstruction в топологическом порядке,
+//   выходы    - output_count номеров узлов (uint32_t),
+//   константы - constant_count значений Value_t,
+//   имена     - variable_count + 1 смещений (uint32_t) и байты имён переменных.
+//
+// Узлы хранятся в том же виде, что и инструкции ленты вычислений,
+// поэтому загрузка не требует разбора каждого узла.
+
+// Сигнатура и версия двоичного формата.
+constexpr uint32_t BINARY_MAGIC   = 0x42584453; // "SDXB"
+constexpr uint32_t BINARY_VERSION = 1;
+
+// Заголовок двоичного файла.
+struct BinaryHeader {
+    uint32_t magic;
+    uint32_t version;
+    // Размер и вид (0 - действительные, 1 - комплексные) чисел в таблице констант.
+    uint32_t value_size;
+    uint32_t value_kind;
+    // Размеры секций.
+    uint32_t node_count;
+    uint32_t output_count;
+    uint32_t constant_count;
+    uint32_t variable_count;
+    uint64_t names_size;
+    uint64_t reserved;
+};
+
+// Сохранение набора выражений в двоичный файл.
+template <typename Value_t>
+void save_binary(const std::string &path, const std::vector<Expression<Value_t>> &exprs);
+
+// Сохранение ленты вычислений в двоичный файл.
+template <typename Value_t>
+void save_binary(const std::string &path, const Tape<Value_t> &tape);
+
+// Двоичный файл выражений, отображённый в память.
+template <typename Value_t> class BinaryImage {
+public:
+    // Отображение файла в память с проверкой заголовка, границ секций и таблицы имён.
+    // Ссылки между узлами проверяются при построении ленты в tape().
+    BinaryImage(const std::string &path);
+
+    // Создание, удаление, копирование и перемещение образа.
+    BinaryImage() = delete;
+    ~BinaryImage();
+
+    BinaryImage(const BinaryImage&) = delete;
+    BinaryImage(BinaryImage &&other);
+
+    BinaryImage& operator=(const BinaryImage&) = delete;
+    BinaryImage& operator=(BinaryImage&&) = delete;
+
+    // Количество выражений в образе.
+    size_t size() const;
+
+    // Лента вычислений для всех выражений образа.
+    Tape<Value_t> tape() const;
+    // Восстановление выражений с сохранением общих подвыражений.
+    std::vector<Expression<Value_t>> expressions() const;
+
+private:
+    // Отображённая область памяти.
+    void *data_;
+    size_t length_;
+
+    // Указатели на секции внутри отображённой области.
+    const BinaryHeader *header_;
+    const TapeInstruction *nodes_;
+    const uint32_t *outputs_;
+    const Value_t *constants_;
+    const uint32_t *nameOffsets_;
+    const char *names_;
+};
+
+#endif // HEADER_GUARD_SERIALIZE_HPP_INCLUDED
\ No newline at end of file
@@ -0,0 +1,158 @@
+#ifndef HEADER_GUARD_SERVER_HPP_INCLUDED
+#define HEADER_GUARD_SERVER_HPP_INCLUDED
+
+#include <string>
+#include <vector>
+#include <list>
+#include <map>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+
+#include <expression.hpp>
+#include <tape.hpp>
+#include <thread_pool.hpp>
+
+// Протокол сервера: один запрос - одна строка, один ответ - одна строка.
+// Поля запроса разделяются символом '|'.
+//
+//   EVAL <expr> | x=1 y=2                  -> OK <value>
+//   DIFF <expr> | x                        -> OK <derivative>
+//   GRAD <expr> | x=1 y=2                  -> OK <d/dx> <d/dy>
+//   BATCH <expr> | x y | 1 2 ; 3 4 ; ...   -> OK <value> <value> ...
+//   STATS                                  -> OK hits=<n> misses=<n>
+//
+// Ошибки возвращаются в виде строки "ERR <message>".
+
+// Потокобезопасный кеш с вытеснением давно использованных значений.
+template <typename Value> class SharedCache {
+public:
+    SharedCache(size_t capacity);
+
+    // Поиск значения; при успехе запись становится недавно использованной.
+    bool find(const std::string &key, Value &value);
+    // Добавление значения с вытеснением лишних записей.
+    void insert(const std::string &key, const Value &value);
+
+    // Счётчики обращений.
+    uint64_t hits() const;
+    uint64_t misses() const;
+
+private:
+    struct Entry {
+        Value value;
+        std::list<std::string>::iterator position;
+    };
+
+    size_t capacity_;
+    std::mutex mutex_;
+    std::list<std::string> recency_;
+    std::unordered_map<std::string, Entry> entries_;
+    std::atomic<uint64_t> hits_;
+    std::atomic<uint64_t> misses_;
+};
+
+// Сервер вычислений через локальный сокет (AF_UNIX).
+// Поток run() принимает соединения, читает и пишет их неблокирующие сокеты через poll();
+// каждая полученная строка ставится в пул потоков фиксированного размера отдельной задачей,
+// поэтому очередь пула ограничивает количество ожидающих запросов, а не соединений.
+// Исполнители только складывают ответы в соединение; отправляет их поток run() в порядке
+// запросов. Пока очередь пула заполнена или клиент не забирает ответы, строки соединения
+// не ставятся в пул и оно не читается, остальные соединения при этом обслуживаются.
+// Разобранные выражения, производные и ленты вычислений кешируются и используются всеми запросами.
+class Server {
+public:
+    typedef long double Value_t;
+
+    // Наибольшая длина строки запроса; на более длинный запрос отвечается ошибкой и соединение закрывается.
+    static constexpr size_t MAX_REQUEST_SIZE = 1 << 20;
+    // Наибольшее количество запросов соединения, поставленных в пул и ещё не отвеченных;
+    // при его достижении, как и при MAX_REQUEST_SIZE байтах неотправленных ответов,
+    // чтение соединения и постановка его запросов приостанавливаются.
+    static constexpr size_t MAX_PENDING_REQUESTS = 256;
+
+    // Создание сервера для сокета по заданному пути.
+    Server(const std::string &socketPath, size_t workers = 0, size_t queueCapacity = 64,
+           size_t cacheCapacity = 4096);
+
+    // Создание, удаление, копирование и перемещение сервера.
+    Server() = delete;
+    ~Server();
+
+    Server(const Server&) = delete;
+    Server(Server&&) = delete;
+
+    Server& operator=(const Server&) = delete;
+    Server& operator=(Server&&) = delete;
+
+    // Приём соединений и чтение запросов до вызова stop().
+    void run();
+    // Остановка сервера; открытые соединения закрываются после ответов на уже принятые запросы.
+    void stop();
+
+    // Обработка одного запроса протокола.
+    std::string handle(const std::string &request);
+
+private:
+    // Соединение клиента; все поля, кроме ready, используются только потоком run().
+    struct Connection {
+        int socket;
+        // Принятые байты, ещё не поставленные в пул, и количество полных строк среди них.
+        std::string buffer;
+        size_t lines = 0;
+        // Ответы в порядке запросов, ещё не переданные в сокет.
+        std::string output;
+        // Количество поставленных в пул запросов и ответов, перенесённых в output.
+        uint64_t submitted = 0;
+        uint64_t collected = 0;
+        // Чтение завершено: сокет закрывается после отправки последнего ответа.
+        bool finished = false;
+        // Ошибка сокета: остальные ответы отбрасываются.
+        bool broken = false;
+
+        std::mutex mutex;
+        // Готовые ответы исполнителей по номерам запросов.
+        std::map<uint64_t, std::string> ready;
+    };
+
+    // Путь к сокету и дескриптор слушающего сокета.
+    std::string socketPath_;
+    int listener_;
+    std::atomic<bool> stopping_;
+    // Канал, через который stop() и исполнители с готовыми ответами прерывают ожидание в poll().
+    int wakeup_[2];
+
+    // Общие для всех запросов кеши.
+    SharedCache<std::shared_ptr<Expression<Value_t>>> expressions_;
+    SharedCache<std::shared_ptr<Expression<Value_t>>> derivatives_;
+    SharedCache<std::shared_ptr<Tape<Value_t>>> tapes_;
+
+    // Пул исполнителей запросов; объявлен последним, чтобы завершаться первым.
+    ThreadPool pool_;
+
+    // Чтение доступных данных соединения.
+    void receive(Connection &connection);
+    // Постановка в пул первой полной строки соединения; false, если ставить нечего или очередь заполнена.
+    bool submit(const std::shared_ptr<Connection> &connection);
+    // Ответ исполнителя на запрос с номером sequence.
+    void respond(Connection &connection, uint64_t sequence, std::string response);
+    // Перенос готовых по порядку ответов в output и отправка без ожидания.
+    void flush(Connection &connection);
+    // Прерывание ожидания в poll().
+    void wake();
+
+    // Получение выражения, производной и ленты вычислений через кеши.
+    std::shared_ptr<Expression<Value_t>> expression(const std::string &text);
+    std::shared_ptr<Expression<Value_t>> derivative(const std::string &text, const std::string &by);
+    std::shared_ptr<Tape<Value_t>> tape(const std::string &key, const std::vector<Expression<Value_t>> &exprs);
+
+    // Обработчики команд протокола.
+    std::string handleEval(const std::vector<std::string> &fields);
+    std::string handleDiff(const std::vector<std::string> &fields);
+    std::string handleGrad(const std::vector<std::string> &fields);
+    std::string handleBatch(const std::vector<std::string> &fields);
+};
+
+#endif // HEADER_GUARD_SERVER_HPP_INCLUDED
\ No newline at end of file
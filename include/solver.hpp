@@ -0,0 +1,95 @@
+#ifndef HEADER_GUARD_SOLVER_HPP_INCLUDED
+#define HEADER_GUARD_SOLVER_HPP_INCLUDED
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstddef>
+
+#include <expression.hpp>
+#include <tape.hpp>
+#include <thread_pool.hpp>
+
+// Задача решателя.
+enum SolveMode {
+    // Корень f(x) = 0.
+    SOLVE_ROOT,
+    // Стационарная точка f'(x) = 0 (минимум при f''(x) > 0).
+    SOLVE_MINIMUM
+};
+
+// Итог итераций из одной начальной точки.
+enum SolveStatus {
+    // Шаг стал меньше допуска.
+    SOLVE_CONVERGED,
+    // Значение или производная стали бесконечными, NaN, или производная обратилась в ноль.
+    SOLVE_DIVERGED,
+    // Исчерпано допустимое количество итераций.
+    SOLVE_EXHAUSTED,
+    // Для минимума: найдена стационарная точка с f''(x) <= 0 (максимум или перегиб).
+    SOLVE_NOT_MINIMUM
+};
+
+const char *solve_status_name(SolveStatus status);
+
+struct SolverOptions {
+    SolveMode mode = SOLVE_ROOT;
+    // Наибольшее количество итераций из одной точки.
+    size_t iterations = 50;
+    // Итерации завершаются, когда |шаг| <= tolerance * (1 + |x|).
+    long double tolerance = 1e-15L;
+    // Количество начальных точек в одной задаче пула.
+    size_t batch = 256;
+};
+
+template <typename Value_t> struct SolveResult {
+    Value_t start;
+    Value_t x;
+    // Значение f(x) в найденной точке.
+    Value_t value;
+    // Невязка |g(x)|, где g = f для корня и g = f' для минимума.
+    long double residual;
+    size_t iterations;
+    SolveStatus status;
+};
+
+// Сводка по набору начальных точек.
+struct SolverStats {
+    size_t converged = 0;
+    size_t diverged = 0;
+    size_t exhausted = 0;
+    size_t notMinimum = 0;
+    // Суммарное количество итераций.
+    size_t iterations = 0;
+
+    std::string to_text() const;
+};
+
+// Метод Ньютона для выражения от одной переменной.
+// Производные берутся один раз; g и g' (и f для минимума) записываются на общую ленту,
+// поэтому одна итерация - один проход по ленте без разбора и вызовов виртуальных функций.
+template <typename Value_t> class NewtonSolver {
+public:
+    // Остальные переменные выражения задаются значениями parameters и подставляются до компиляции.
+    NewtonSolver(const Expression<Value_t> &expr, const std::string &variable,
+                 std::map<std::string, Value_t> &parameters, const SolverOptions &options = SolverOptions());
+
+    // Итерации из каждой начальной точки; с пулом точки обрабатываются пакетами параллельно.
+    std::vector<SolveResult<Value_t>> solve(const std::vector<Value_t> &starts) const;
+    std::vector<SolveResult<Value_t>> solve(const std::vector<Value_t> &starts, ThreadPool &pool) const;
+
+    static SolverStats summarize(const std::vector<SolveResult<Value_t>> &results);
+
+    // Лента итерации: выходы g, g' и (для минимума) f.
+    const Tape<Value_t> &tape() const;
+
+private:
+    SolverOptions options_;
+    Tape<Value_t> tape_;
+
+    // Итерации для starts[first], ..., starts[last - 1].
+    void solve_range(const std::vector<Value_t> &starts, size_t first, size_t last,
+                     std::vector<SolveResult<Value_t>> &results) const;
+};
+
+#endif // HEADER_GUARD_SOLVER_HPP_INCLUDED
\ No newline at end of file
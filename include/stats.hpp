@@ -0,0 +1,88 @@
+#ifndef HEADER_GUARD_STATS_HPP_INCLUDED
+#define HEADER_GUARD_STATS_HPP_INCLUDED
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <type_traits>
+#include <cstdint>
+
+#include <expression.hpp>
+
+// Счётчики выделений динамической памяти с начала работы процесса.
+// Подсчёт ведётся замещёнными глобальными операторами new в счётчиках своего потока
+// (без атомарных операций чтения-изменения-записи); allocation_counters() суммирует
+// счётчики всех потоков.
+struct AllocationCounters {
+    uint64_t count;
+    uint64_t bytes;
+};
+
+AllocationCounters allocation_counters();
+
+// Пиковый объём резидентной памяти процесса в байтах.
+uint64_t peak_memory();
+
+// Результаты одной фазы обработки.
+struct PhaseStats {
+    std::string name;
+    // Время выполнения в миллисекундах.
+    double ms;
+    // Выделения памяти за время фазы.
+    uint64_t allocations;
+    uint64_t bytes;
+    // Размер выражения, полученного в фазе (если фаза строит выражение).
+    bool hasExpression;
+    uint64_t nodes;
+    uint64_t uniqueNodes;
+    uint64_t depth;
+};
+
+// Сбор статистики по фазам обработки выражения.
+// Выключенный сбор не замеряет фазы и не обходит выражения.
+class Stats {
+public:
+    Stats(bool enabled = true);
+
+    // Выполнение фазы с замером времени и выделений памяти.
+    template <typename Function>
+    auto phase(const std::string &name, Function function) {
+        if (!enabled_) return function();
+
+        Start start = begin();
+
+        if constexpr (std::is_void_v<decltype(function())>) {
+            function();
+            end(name, start);
+        }
+        else {
+            auto result = function();
+            end(name, start);
+            return result;
+        }
+    }
+
+    // Запоминание размера выражения, полученного в последней фазе.
+    template <typename Value_t>
+    void measure(const Expression<Value_t> &expr);
+
+    const std::vector<PhaseStats> &phases() const;
+
+    // Отчёт в текстовом виде и в формате JSON.
+    std::string to_text() const;
+    std::string to_json() const;
+
+private:
+    struct Start {
+        std::chrono::steady_clock::time_point time;
+        AllocationCounters allocations;
+    };
+
+    bool enabled_;
+    std::vector<PhaseStats> phases_;
+
+    static Start begin();
+    void end(const std::string &name, const Start &start);
+};
+
+#endif // HEADER_GUARD_STATS_HPP_INCLUDED
\ No newline at end of file
@@ -0,0 +1,40 @@
+#ifndef HEADER_GUARD_SYMBOLS_HPP_INCLUDED
+#define HEADER_GUARD_SYMBOLS_HPP_INCLUDED
+
+#include <string>
+#include <cstdint>
+
+// Номер имени переменной в общей для всех выражений таблице; имя добавляется при первом обращении.
+// Номера не меняются до завершения программы.
+uint32_t intern_symbol(const std::string &name);
+// Поиск номера уже добавленного имени; false, если имя ещё не встречалось.
+bool find_symbol(const std::string &name, uint32_t &id);
+// Имя с заданным номером; ссылка действительна до завершения программы.
+const std::string &symbol_name(uint32_t id);
+
+// Приближённое множество номеров переменных в одном 64-битном слове.
+// Номера меньше EXACT_IDS хранятся точно (бит с номером id), все большие номера
+// отмечаются одним общим битом. Поэтому отрицательный ответ may_contain всегда верен,
+// а положительный для больших номеров требует проверки по самому выражению.
+// Размер множества не зависит от количества и величины номеров.
+class VariableSet {
+public:
+    // Номера, для которых ответ may_contain точный.
+    static constexpr uint32_t EXACT_IDS = 63;
+
+    // Пустое множество и множество из одного номера.
+    VariableSet();
+    VariableSet(uint32_t id);
+
+    // Объединение множеств.
+    VariableSet united(const VariableSet &other) const;
+
+    // false - номера в множестве точно нет; для id < EXACT_IDS true - номер точно есть.
+    bool may_contain(uint32_t id) const;
+    bool empty() const;
+
+private:
+    uint64_t bits_;
+};
+
+#endif // HEADER_GUARD_SYMBOLS_HPP_INCLUDED
\ No newline at end of file
@@ -0,0 +1,110 @@
+#ifndef HEADER_GUARD_TAPE_HPP_INCLUDED
+#define HEADER_GUARD_TAPE_HPP_INCLUDED
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <cstdint>
+
+#include <expression.hpp>
+
+// Инструкция ленты вычислений, соответствующая одному узлу выражения.
+struct TapeInstruction {
+    // Тип узла выражения.
+    NodeType type;
+    // Номера инструкций-операндов.
+    // Для чисел и переменных в left хранится номер в таблице констант или переменных.
+    uint32_t left;
+    uint32_t right;
+};
+
+bool operator==(const TapeInstruction &left, const TapeInstruction &right);
+
+// Хеш инструкции для нумерации значений при записи ленты.
+struct TapeInstructionHash {
+    size_t operator()(const TapeInstruction &instr) const;
+};
+
+// Лента вычислений - линейное представление набора выражений.
+// Узлы записываются в топологическом порядке (операнды раньше операций),
+// общие подвыражения записываются на ленту один раз - и общие узлы, и одинаковые операции
+// над одинаковыми операндами (например, exp(u) в функции и в её производной).
+// sin и cos одного аргумента вычисляются одним вызовом sincos.
+template <typename Value_t> class Tape {
+public:
+    // Построение ленты для одного выражения.
+    Tape(const Expression<Value_t> &expr);
+    // Построение ленты для набора выражений с общими подвыражениями.
+    Tape(const std::vector<Expression<Value_t>> &exprs);
+    // Построение ленты для выражения, специализированного значениями части переменных;
+    // на ленте остаются только свободные переменные.
+    Tape(const Expression<Value_t> &expr, std::map<std::string, Value_t> &bound);
+    // Создание ленты по готовым таблицам с проверкой ссылок между инструкциями.
+    Tape(std::vector<TapeInstruction> code, std::vector<Value_t> constants,
+         std::vector<std::string> variables, std::vector<uint32_t> outputs);
+
+    // Вычисление первого выхода ленты.
+    Value_t eval(std::map<std::string, Value_t> &context) const;
+    // Вычисление всех выходов ленты.
+    std::vector<Value_t> eval_all(std::map<std::string, Value_t> &context) const;
+
+    // Вычисление всех инструкций ленты.
+    // variables - значения переменных в порядке таблицы переменных,
+    // registers - массив результатов размера size().
+    void run(const Value_t *variables, Value_t *registers) const;
+    // Вычисление только инструкций с заданными номерами (по возрастанию);
+    // регистры их операндов должны содержать актуальные значения.
+    void run(const Value_t *variables, Value_t *registers, const std::vector<uint32_t> &indices) const;
+
+    // Коэффициенты ряда Тейлора первого выхода по переменной by до степени order включительно:
+    // c[j] = f^(j)(a) / j!, где a = context[by]; остальные переменные берутся из контекста.
+    // Усечённые ряды распространяются по инструкциям за O(order^2) на инструкцию.
+    std::vector<Value_t> taylor(const std::string &by, std::map<std::string, Value_t> &context, size_t order) const;
+
+    // Восстановление выражений по ленте с сохранением общих подвыражений.
+    std::vector<Expression<Value_t>> expressions() const;
+
+    // Количество инструкций на ленте.
+    size_t size() const;
+
+    // Доступ к составляющим ленты.
+    const std::vector<TapeInstruction> &code() const;
+    const std::vector<Value_t> &constants() const;
+    const std::vector<std::string> &variables() const;
+    const std::vector<uint32_t> &outputs() const;
+
+    // Для sin и cos одного аргумента - номер парной инструкции, иначе NO_PARTNER.
+    const std::vector<uint32_t> &partners() const;
+
+    static constexpr uint32_t NO_PARTNER = UINT32_MAX;
+
+private:
+    // Инструкции в топологическом порядке.
+    std::vector<TapeInstruction> code_;
+    // Таблица числовых констант.
+    std::vector<Value_t> constants_;
+    // Таблица имён переменных.
+    std::vector<std::string> variables_;
+    // Номера инструкций, результаты которых являются выходами ленты.
+    std::vector<uint32_t> outputs_;
+    // Номера парных инструкций sin и cos (см. partners()).
+    std::vector<uint32_t> partners_;
+
+    // Запись выражения на ленту.
+    uint32_t record(const std::shared_ptr<ExpressionImpl<Value_t>> &root,
+                    std::unordered_map<const ExpressionImpl<Value_t>*, uint32_t> &recorded,
+                    std::unordered_map<std::string, uint32_t> &variableIndex,
+                    std::unordered_map<TapeInstruction, uint32_t, TapeInstructionHash> &numbered);
+
+    // Вычисление одной инструкции.
+    void execute(size_t i, const Value_t *variables, Value_t *registers) const;
+
+    // Поиск пар sin и cos одного аргумента.
+    void pair_trigonometry();
+
+    // Формирование значений переменных по контексту вычисления.
+    std::vector<Value_t> bind(std::map<std::string, Value_t> &context) const;
+};
+
+#endif // HEADER_GUARD_TAPE_HPP_INCLUDED
\ No newline at end of file
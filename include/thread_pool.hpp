@@ -0,0 +1,69 @@
+#ifndef HEADER_GUARD_THREAD_POOL_HPP_INCLUDED
+#define HEADER_GUARD_THREAD_POOL_HPP_INCLUDED
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+// Пул потоков с фиксированным числом исполнителей и ограниченной очередью задач.
+// При заполненной очереди постановка задачи блокируется до освобождения места,
+// что ограничивает скорость поступления задач скоростью их обработки.
+class ThreadPool {
+public:
+    // Создание пула; при workers == 0 используется число аппаратных потоков.
+    ThreadPool(size_t workers = 0, size_t capacity = 1024);
+
+    // Создание, удаление, копирование и перемещение пула.
+    ThreadPool() = delete;
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool(ThreadPool&&) = delete;
+
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ThreadPool& operator=(ThreadPool&&) = delete;
+
+    // Постановка задачи в очередь с ожиданием свободного места.
+    void submit(std::function<void()> task);
+    // Постановка задачи в очередь без ожидания; false, если очередь заполнена.
+    bool try_submit(std::function<void()> task);
+
+    // Ожидание завершения всех поставленных задач.
+    void wait();
+
+    // Вызов body(0), ..., body(count - 1) на исполнителях пула и в вызывающем потоке.
+    // Вызывающий поток сам обрабатывает индексы и ждёт только уже начатые вызовы,
+    // поэтому функцию можно вызывать и из задачи этого же пула.
+    // Первое исключение из body передаётся вызывающему после завершения всех вызовов.
+    void parallel_for(size_t count, const std::function<void(size_t)> &body);
+
+    // Количество исполнителей пула.
+    size_t size() const;
+
+private:
+    // Потоки-исполнители.
+    std::vector<std::thread> workers_;
+    // Очередь задач и её максимальный размер.
+    std::deque<std::function<void()>> queue_;
+    size_t capacity_;
+    // Количество выполняемых в данный момент задач.
+    size_t active_;
+    // Признак завершения работы пула.
+    bool stopping_;
+
+    std::mutex mutex_;
+    // Появление задачи в очереди.
+    std::condition_variable available_;
+    // Освобождение места в очереди.
+    std::condition_variable space_;
+    // Завершение всех задач.
+    std::condition_variable idle_;
+
+    // Цикл обработки задач исполнителем.
+    void work();
+};
+
+#endif // HEADER_GUARD_THREAD_POOL_HPP_INCLUDED
\ No newline at end of file
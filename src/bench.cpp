@@ -0,0 +1,657 @@
+#include <expression.hpp>
+
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <filesystem>
+#include <algorithm>
+
+#include <lexer.hpp>
+#include <parser.hpp>
+#include <tape.hpp>
+#include <serialize.hpp>
+#include <generator.hpp>
+#include <thread_pool.hpp>
+#include <fork_join.hpp>
+#include <jacobian.hpp>
+#include <closure.hpp>
+#include <polynomial.hpp>
+#include <incremental.hpp>
+#include <solver.hpp>
+#include <frozen.hpp>
+
+typedef long double Value_t;
+
+//===================//
+// Измерение и отчёт //
+//===================//
+
+// Время выполнения функции в миллисекундах (минимум из нескольких запусков).
+template <typename Function>
+double measure_ms(Function function, int repeats = 5) {
+    double best = 0.0;
+
+    for (int i = 0; i < repeats; i++) {
+        auto start = std::chrono::steady_clock::now();
+        function();
+        auto finish = std::chrono::steady_clock::now();
+
+        double elapsed = std::chrono::duration<double, std::milli>(finish - start).count();
+        if (i == 0 || elapsed < best) best = elapsed;
+    }
+
+    return best;
+}
+
+// Запись с результатами одного измерения в формате JSON.
+class Record {
+public:
+    Record(const std::string &family, const std::string &stage) {
+        add("family", family);
+        add("stage", stage);
+    }
+
+    Record &add(const std::string &key, const std::string &value) {
+        fields_.emplace_back(key, "\"" + value + "\"");
+        return *this;
+    }
+
+    Record &add(const std::string &key, double value) {
+        char buffer[64];
+        snprintf(buffer, sizeof(buffer), "%.6g", value);
+        fields_.emplace_back(key, buffer);
+        return *this;
+    }
+
+    std::string to_json() const {
+        std::string json = "{";
+        for (size_t i = 0; i < fields_.size(); i++) {
+            json += (i == 0 ? "\"" : ", \"") + fields_[i].first + "\": " + fields_[i].second;
+        }
+        return json + "}";
+    }
+
+private:
+    std::vector<std::pair<std::string, std::string>> fields_;
+};
+
+// Все записи запуска.
+std::vector<Record> records;
+
+//==========================//
+// Семейства входных данных //
+//==========================//
+
+// Семейство синтетических выражений.
+struct Family {
+    std::string name;
+    std::string source;
+    // Переменная дифференцирования и точка вычисления.
+    std::string variable;
+    std::map<std::string, Value_t> point;
+};
+
+// Имя переменной по номеру (имена переменных состоят только из букв).
+std::string variable_name(size_t index) {
+    std::string name = "v";
+    do {
+        name += char('a' + index % 26);
+        index /= 26;
+    } while (index != 0);
+    return name;
+}
+
+// Широкий многочлен: n * x^n + ... + 2 * x^2 + 1 * x.
+Family wide_polynomial(size_t terms) {
+    std::string source;
+    for (size_t i = terms; i >= 1; i--) {
+        source += std::to_string(i) + " * x ^ " + std::to_string(i) + (i > 1 ? " + " : "");
+    }
+    return {"wide_polynomial_" + std::to_string(terms), source, "x", {{"x", 0.75L}}};
+}
+
+// Глубокая вложенность: (((x + 1) * x + 2) * x + 3) ...
+Family deep_nesting(size_t depth) {
+    std::string source = "x";
+    for (size_t i = 1; i <= depth; i++) {
+        source = "(" + source + " + " + std::to_string(i) + ") * x";
+    }
+    return {"deep_nesting_" + std::to_string(depth), source, "x", {{"x", 0.5L}}};
+}
+
+// Башня тригонометрических функций: sin(cos(sin(... x ...))).
+Family trig_tower(size_t height) {
+    std::string source = "x";
+    for (size_t i = 0; i < height; i++) {
+        source = std::string(i % 2 == 0 ? "sin(" : "cos(") + source + ")";
+    }
+    return {"trig_tower_" + std::to_string(height), source, "x", {{"x", 0.3L}}};
+}
+
+// Цепочка степеней: x ^ x ^ ... ^ x.
+Family power_chain(size_t length) {
+    std::string source = "x";
+    for (size_t i = 1; i < length; i++) {
+        source += " ^ x";
+    }
+    return {"power_chain_" + std::to_string(length), source, "x", {{"x", 1.1L}}};
+}
+
+// Многомерная модель: сумма членов, связывающих соседние переменные.
+Family multi_variable(size_t variables) {
+    std::string source;
+    std::map<std::string, Value_t> point;
+
+    for (size_t i = 0; i < variables; i++) {
+        std::string current = variable_name(i);
+        std::string next = variable_name((i + 1) % variables);
+
+        source += (i > 0 ? " + " : "") + std::string("sin(") + current + " * " + next + ") * exp(" +
+                  current + " / (1 + " + next + " ^ 2)) + ln(1 + " + current + " ^ 2)";
+        point[current] = 0.1L + 0.01L * Value_t(i);
+    }
+    return {"multi_variable_" + std::to_string(variables), source, variable_name(0), point};
+}
+
+// Случайное выражение заданного размера.
+Family random_expression(size_t nodes) {
+    GeneratorOptions options;
+    options.nodes = nodes;
+    options.depth = 64;
+    options.variables = 3;
+
+    ExpressionGenerator generator(options);
+    std::string source = ExpressionGenerator::text(generator.expression());
+    return {"random_" + std::to_string(nodes), source, "x", generator.point()};
+}
+
+//=================//
+// Этапы конвейера //
+//=================//
+
+void bench_family(const Family &family) {
+    const std::string &source = family.source;
+
+    // Лексический анализ.
+    size_t tokens = 0;
+    double lexMs = measure_ms([&] {
+        Lexer lexer{source};
+        tokens = 0;
+        while (lexer.getNextToken().type != TOK_EOF) tokens++;
+    });
+    records.push_back(Record(family.name, "lex")
+        .add("ms", lexMs).add("bytes", double(source.size())).add("tokens", double(tokens))
+        .add("mb_per_s", double(source.size()) / 1e3 / lexMs));
+
+    // Синтаксический анализ.
+    Expression<Value_t> expr = Expression<Value_t>(0.0L);
+    double parseMs = measure_ms([&] {
+        Lexer lexer{source};
+        Parser<Value_t> parser{lexer};
+        expr = parser.parseExpression();
+    });
+    records.push_back(Record(family.name, "parse")
+        .add("ms", parseMs).add("tokens_per_s", double(tokens) / parseMs * 1e3));
+
+    // Дифференцирование.
+    Expression<Value_t> derivative = expr;
+    double diffMs = measure_ms([&] { derivative = expr.diff(family.variable); });
+    records.push_back(Record(family.name, "diff")
+        .add("ms", diffMs).add("input_nodes", double(expr.unique_node_count()))
+        .add("output_nodes", double(derivative.unique_node_count()))
+        .add("output_bytes", double(derivative.byte_footprint())));
+
+    // Упрощение.
+    Expression<Value_t> pretty = derivative;
+    double prettifyMs = measure_ms([&] { pretty = derivative.prettify(); });
+    records.push_back(Record(family.name, "prettify")
+        .add("ms", prettifyMs).add("output_nodes", double(pretty.unique_node_count())));
+
+    // Печать.
+    size_t textSize = 0;
+    double toStringMs = measure_ms([&] { textSize = pretty.to_string().size(); });
+    records.push_back(Record(family.name, "to_string")
+        .add("ms", toStringMs).add("bytes", double(textSize)));
+
+    // Вычисление значений выражения и производной.
+    std::map<std::string, Value_t> context = family.point;
+    // Число повторений уменьшается с ростом выражения.
+    const int iterations = int(std::max<size_t>(10, 200000 / expr.unique_node_count()));
+    volatile Value_t sink = 0;
+
+    double evalMs = measure_ms([&] { for (int i = 0; i < iterations; i++) sink = expr.eval(context); }, 3);
+    double evalDiffMs = measure_ms([&] { for (int i = 0; i < iterations; i++) sink = pretty.eval(context); }, 3);
+
+    Tape<Value_t> tape(pretty);
+    std::vector<Value_t> variables;
+    for (const std::string &name : tape.variables()) variables.push_back(context.at(name));
+    std::vector<Value_t> registers(tape.size());
+
+    double tapeMs = measure_ms([&] {
+        for (int i = 0; i < iterations; i++) {
+            tape.run(variables.data(), registers.data());
+            sink = registers[tape.outputs()[0]];
+        }
+    }, 3);
+
+    ClosureEvaluator<Value_t> closures(pretty);
+    std::vector<Value_t> closureVariables;
+    for (const std::string &name : closures.variables()) closureVariables.push_back(context.at(name));
+    std::vector<Value_t> closureRegisters(closures.size());
+
+    double closureMs = measure_ms([&] {
+        for (int i = 0; i < iterations; i++) sink = closures.eval(closureVariables.data(), closureRegisters.data());
+    }, 3);
+    (void) sink;
+
+    records.push_back(Record(family.name, "eval")
+        .add("expr_ns_per_op", evalMs * 1e6 / iterations)
+        .add("derivative_ns_per_op", evalDiffMs * 1e6 / iterations)
+        .add("derivative_tape_ns_per_op", tapeMs * 1e6 / iterations)
+        .add("derivative_closure_ns_per_op", closureMs * 1e6 / iterations));
+}
+
+// Масштабирование дифференцирования по многим переменным с числом исполнителей.
+void bench_diff_all(size_t variables) {
+    Family family = multi_variable(variables);
+    Lexer lexer{family.source};
+    Parser<Value_t> parser{lexer};
+    Expression<Value_t> expr = parser.parseExpression();
+
+    std::vector<std::string> names;
+    for (const auto &[name, value] : family.point) names.push_back(name);
+
+    double serialMs = measure_ms([&] {
+        for (const std::string &name : names) expr.diff(name).prettify();
+    }, 3);
+
+    Record record(family.name, "diff_all");
+    record.add("variables", double(names.size())).add("serial_ms", serialMs);
+
+    for (size_t workers = 1; workers <= 8; workers *= 2) {
+        ThreadPool pool(workers);
+        double parallelMs = measure_ms([&] { expr.diff_all(names, pool); }, 3);
+
+        record.add("workers_" + std::to_string(workers) + "_ms", parallelMs)
+              .add("workers_" + std::to_string(workers) + "_speedup", serialMs / parallelMs);
+    }
+    records.push_back(record);
+}
+
+// Производная и упрощение одного большого выражения: последовательно и с разделением поддеревьев.
+void bench_fork_join(const Family &family, uint64_t grain) {
+    Lexer lexer{family.source};
+    Parser<Value_t> parser{lexer};
+    Expression<Value_t> expr = parser.parseExpression();
+
+    double serialMs = measure_ms([&] { expr.diff(family.variable).prettify(); }, 3);
+
+    Record record(family.name, "fork_join");
+    record.add("grain", double(grain)).add("serial_ms", serialMs);
+
+    for (size_t workers = 1; workers <= 8; workers *= 2) {
+        ForkJoinPool pool(workers);
+        double parallelMs = measure_ms([&] { expr.diff(family.variable, pool, grain).prettify(pool, grain); }, 3);
+
+        record.add("workers_" + std::to_string(workers) + "_ms", parallelMs)
+              .add("workers_" + std::to_string(workers) + "_speedup", serialMs / parallelMs);
+    }
+    records.push_back(record);
+}
+
+// Якобиан разреженной системы: каждое уравнение зависит от трёх соседних переменных.
+void bench_jacobian(size_t equations) {
+    std::vector<std::string> names;
+    for (size_t i = 0; i < equations; i++) names.push_back(variable_name(i));
+
+    std::vector<Expression<Value_t>> functions;
+    for (size_t i = 0; i < equations; i++) {
+        Expression<Value_t> next(names[(i + 1) % equations]);
+        Expression<Value_t> third(names[(i + 2) % equations]);
+        functions.push_back(Expression<Value_t>(names[i]) * next + third.sin());
+    }
+
+    double denseMs = measure_ms([&] {
+        for (const Expression<Value_t> &function : functions) {
+            for (const std::string &name : names) function.diff(name).prettify();
+        }
+    }, 3);
+
+    size_t nonzeros = 0;
+    double sparseMs = measure_ms([&] { nonzeros = SparseJacobian<Value_t>(functions, names).nonzeros(); }, 3);
+
+    Record record("sparse_system_" + std::to_string(equations), "jacobian");
+    record.add("equations", double(equations)).add("nonzeros", double(nonzeros))
+          .add("dense_ms", denseMs).add("sparse_ms", sparseMs).add("speedup", denseMs / sparseMs);
+    records.push_back(record);
+}
+
+// Специализация выражения с 30 параметрами и двумя свободными переменными.
+void bench_specialize() {
+    Expression<Value_t> x("x");
+    Expression<Value_t> y("y");
+    std::map<std::string, Value_t> parameters;
+
+    Expression<Value_t> expr = x * y;
+    for (int i = 0; i < 30; i++) {
+        std::string name = "p" + std::to_string(i);
+        parameters[name] = 0.1L * (i + 1);
+        Expression<Value_t> p(name);
+        expr = expr + (p * p + p.sin()) * x - p / (p + Expression<Value_t>(1.0L)) * y;
+    }
+
+    Expression<Value_t> specialized = expr;
+    double substituteMs = measure_ms([&] { specialized = expr.substitute(parameters).prettify(); });
+    double specializeMs = measure_ms([&] { specialized = expr.specialize(parameters); });
+
+    std::map<std::string, Value_t> context = parameters;
+    context["x"] = 1.5L;
+    context["y"] = -0.5L;
+
+    const int iterations = 10000;
+    volatile Value_t sink = 0;
+
+    Tape<Value_t> full(expr);
+    Tape<Value_t> bound(expr, parameters);
+    double fullMs = measure_ms([&] { for (int i = 0; i < iterations; i++) sink = full.eval(context); }, 3);
+    double boundMs = measure_ms([&] { for (int i = 0; i < iterations; i++) sink = bound.eval(context); }, 3);
+    (void) sink;
+
+    records.push_back(Record("parameters_30", "specialize")
+        .add("substitute_prettify_ms", substituteMs).add("specialize_ms", specializeMs)
+        .add("full_tape_size", double(full.size())).add("specialized_tape_size", double(bound.size()))
+        .add("full_ns_per_op", fullMs * 1e6 / iterations).add("specialized_ns_per_op", boundMs * 1e6 / iterations));
+}
+
+// Многочлен степени degree в виде суммы степеней: дерево, схема Горнера и вычисление в наборе точек.
+void bench_polynomial(int degree) {
+    Expression<Value_t> x("x");
+    Expression<Value_t> expr(1.0L);
+    for (int i = 1; i <= degree; i++) {
+        expr = expr + Expression<Value_t>(1.0L / i) * (x ^ Expression<Value_t>(Value_t(i)));
+    }
+
+    Polynomial<Value_t> polynomial("", {});
+    double recognizeMs = measure_ms([&] { Polynomial<Value_t>::recognize(expr, polynomial); });
+    Expression<Value_t> horner = horner_form(expr);
+
+    const int iterations = 10000;
+    volatile Value_t sink = 0;
+    std::map<std::string, Value_t> context = {{"x", 0.75L}};
+
+    Tape<Value_t> tree(expr);
+    Tape<Value_t> rewritten(horner);
+    double treeMs = measure_ms([&] { for (int i = 0; i < iterations; i++) sink = tree.eval(context); }, 3);
+    double hornerMs = measure_ms([&] { for (int i = 0; i < iterations; i++) sink = rewritten.eval(context); }, 3);
+    double estrinMs = measure_ms([&] { for (int i = 0; i < iterations; i++) sink = polynomial.eval_estrin(0.75L); }, 3);
+
+    std::vector<Value_t> points(iterations, 0.75L);
+    std::vector<Value_t> results(iterations);
+    double batchMs = measure_ms([&] { polynomial.eval(points.data(), results.data(), points.size()); }, 3);
+    (void) sink;
+
+    records.push_back(Record("polynomial_" + std::to_string(degree), "horner")
+        .add("recognize_ms", recognizeMs)
+        .add("pow_tape_ns_per_op", treeMs * 1e6 / iterations).add("horner_tape_ns_per_op", hornerMs * 1e6 / iterations)
+        .add("estrin_ns_per_op", estrinMs * 1e6 / iterations).add("batch_ns_per_point", batchMs * 1e6 / iterations));
+}
+
+// Построение суммы большого числа слагаемых со своей переменной в каждом: присваивание результата
+// копирующей операции, составное присваивание с перемещением и сбалансированная сумма.
+void bench_builders(size_t count) {
+    std::vector<Expression<Value_t>> terms;
+    terms.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        terms.push_back(Expression<Value_t>(Value_t(i + 1)) * Expression<Value_t>("p" + std::to_string(i)));
+    }
+
+    Expression<Value_t> result(0.0L);
+    double copyMs = measure_ms([&] {
+        Expression<Value_t> chain(0.0L);
+        for (const Expression<Value_t> &term : terms) chain = chain + term;
+        result = chain;
+    }, 3);
+    double moveMs = measure_ms([&] {
+        Expression<Value_t> chain(0.0L);
+        for (const Expression<Value_t> &term : terms) chain += term;
+        result = chain;
+    }, 3);
+    uint64_t chainDepth = result.depth();
+
+    double sumMs = measure_ms([&] { result = Expression<Value_t>::sum(terms); }, 3);
+
+    records.push_back(Record("sum_" + std::to_string(count), "builders")
+        .add("copy_assign_ms", copyMs).add("compound_move_ms", moveMs).add("balanced_sum_ms", sumMs)
+        .add("chain_depth", double(chainDepth)).add("balanced_depth", double(result.depth())));
+}
+
+// Операции над левосторонней цепочкой сумм, глубина которой превышает предел рекурсии.
+void bench_deep(size_t count) {
+    Expression<Value_t> x("x");
+    std::map<std::string, Value_t> context = {{"x", 0.5L}};
+    Expression<Value_t> chain(0.0L);
+
+    double buildMs = measure_ms([&] {
+        chain = Expression<Value_t>(0.0L);
+        for (size_t i = 0; i < count; i++) chain += x;
+    }, 1);
+
+    volatile Value_t sink = 0;
+    double evalMs = measure_ms([&] { sink = chain.eval(context); }, 3);
+    double diffMs = measure_ms([&] { sink = chain.diff("x").eval(context); }, 3);
+    double prettifyMs = measure_ms([&] { sink = chain.prettify().eval(context); }, 3);
+    double stringMs = measure_ms([&] { sink = Value_t(chain.to_string().size()); }, 3);
+    uint64_t depth = chain.depth();
+    double releaseMs = measure_ms([&] { chain = x; }, 1);
+    (void) sink;
+
+    records.push_back(Record("chain_" + std::to_string(count), "deep")
+        .add("depth", double(depth)).add("build_ms", buildMs).add("eval_ms", evalMs).add("diff_eval_ms", diffMs)
+        .add("prettify_eval_ms", prettifyMs).add("to_string_ms", stringMs).add("release_ms", releaseMs));
+}
+
+// Дерево указателей и замороженный массив узлов: память, вычисление, производная с упрощением.
+void bench_frozen(size_t nodes) {
+    GeneratorOptions options;
+    options.seed = 11;
+    options.nodes = nodes;
+    options.variables = 8;
+    options.sharing = 0.1;
+    options.mix = {{NODE_ADD, 1.0}, {NODE_SUB, 1.0}, {NODE_MUL, 1.0}, {NODE_SIN, 1.0}, {NODE_COS, 1.0}};
+    ExpressionGenerator generator(options);
+    Expression<Value_t> expr = generator.expression();
+    std::map<std::string, Value_t> context = generator.point();
+    const std::string &by = generator.variables()[0];
+
+    FrozenExpression<Value_t> frozen(expr);
+    double freezeMs = measure_ms([&] { frozen = FrozenExpression<Value_t>(expr); }, 3);
+    double thawMs = measure_ms([&] { expr = frozen.expression(); }, 3);
+
+    const int iterations = 20;
+    volatile Value_t sink = 0;
+    double treeEvalMs = measure_ms([&] { for (int i = 0; i < iterations; i++) sink = expr.eval(context); });
+    double frozenEvalMs = measure_ms([&] { for (int i = 0; i < iterations; i++) sink = frozen.eval(context); });
+    double treeDiffMs = measure_ms([&] { sink = expr.diff(by).prettify().eval(context); }, 3);
+    double frozenDiffMs = measure_ms([&] { sink = frozen.diff(by).prettify().eval(context); }, 3);
+    (void) sink;
+
+    records.push_back(Record("generated_" + std::to_string(nodes), "frozen")
+        .add("tree_bytes", double(expr.byte_footprint())).add("frozen_bytes", double(frozen.byte_footprint()))
+        .add("freeze_ms", freezeMs).add("thaw_ms", thawMs)
+        .add("tree_eval_us", treeEvalMs * 1000.0 / iterations).add("frozen_eval_us", frozenEvalMs * 1000.0 / iterations)
+        .add("tree_diff_prettify_ms", treeDiffMs).add("frozen_diff_prettify_ms", frozenDiffMs));
+}
+
+// Сравнение полного вычисления модели с инкрементальным при изменении двух переменных из многих.
+void bench_incremental(size_t nodes, size_t variables) {
+    GeneratorOptions options;
+    options.seed = 7;
+    options.nodes = nodes;
+    options.variables = variables;
+    options.sharing = 0.1;
+    // Операции без выхода из области определения: значения модели остаются конечными.
+    options.mix = {{NODE_ADD, 1.0}, {NODE_SUB, 1.0}, {NODE_MUL, 1.0}, {NODE_SIN, 1.0}, {NODE_COS, 1.0}};
+    ExpressionGenerator generator(options);
+    Expression<Value_t> expr = generator.expression();
+    std::map<std::string, Value_t> context = generator.point();
+    const std::vector<std::string> &names = generator.variables();
+
+    Tape<Value_t> tape(expr);
+    IncrementalEvaluator<Value_t> incremental(expr, context);
+
+    const int iterations = 2000;
+    volatile Value_t sink = 0;
+    size_t recomputed = 0;
+
+    // На каждом шаге по кругу изменяются две переменные.
+    auto step = [&](int i, auto &&update) {
+        for (size_t k = 0; k < 2; k++) {
+            const std::string &name = names[(2 * i + k) % names.size()];
+            context[name] += (i % 2 == 0) ? 0.001L : -0.001L;
+            update(name, context[name]);
+        }
+    };
+
+    double fullMs = measure_ms([&] {
+        for (int i = 0; i < iterations; i++) {
+            step(i, [](const std::string &, Value_t) {});
+            sink = tape.eval(context);
+        }
+    }, 3);
+    double incrementalMs = measure_ms([&] {
+        for (int i = 0; i < iterations; i++) {
+            step(i, [&](const std::string &name, Value_t value) { incremental.set(name, value); });
+            sink = incremental.value();
+            recomputed += incremental.recomputed();
+        }
+    }, 3);
+    (void) sink;
+
+    records.push_back(Record("random_" + std::to_string(nodes) + "_vars_" + std::to_string(variables), "incremental")
+        .add("tape_size", double(tape.size())).add("mean_recomputed", double(recomputed) / (3.0 * iterations))
+        .add("full_ns_per_update", fullMs * 1e6 / iterations).add("incremental_ns_per_update", incrementalMs * 1e6 / iterations));
+}
+
+// Пропускная способность метода Ньютона: итерации по дереву выражения и производной
+// против общей ленты решателя, последовательно и на пуле.
+void bench_solver(size_t points) {
+    Lexer lexer{std::string("x ^ 3 - 2 * x - 5 + sin(x) * exp((0 - x * x) / 8) - a")};
+    Parser<Value_t> parser{lexer};
+    Expression<Value_t> expr = parser.parseExpression();
+    std::map<std::string, Value_t> parameters = {{"a", 0.5L}};
+
+    std::vector<Value_t> starts(points);
+    for (size_t i = 0; i < points; i++) {
+        starts[i] = -10.0L + 20.0L * Value_t(i) / Value_t(points);
+    }
+
+    SolverOptions options;
+    NewtonSolver<Value_t> solver(expr, "x", parameters, options);
+
+    Expression<Value_t> derivative = expr.diff("x").prettify();
+    double treeMs = measure_ms([&] {
+        std::map<std::string, Value_t> context = parameters;
+        for (Value_t start : starts) {
+            context["x"] = start;
+            for (size_t k = 0; k < options.iterations; k++) {
+                Value_t step = expr.eval(context) / derivative.eval(context);
+                context["x"] -= step;
+                if (!(std::abs(step) > options.tolerance * (1.0L + std::abs(context["x"])))) break;
+            }
+        }
+    }, 3);
+
+    std::vector<SolveResult<Value_t>> results;
+    double serialMs = measure_ms([&] { results = solver.solve(starts); }, 3);
+    ThreadPool pool(0);
+    double poolMs = measure_ms([&] { results = solver.solve(starts, pool); }, 3);
+    SolverStats stats = NewtonSolver<Value_t>::summarize(results);
+
+    records.push_back(Record("newton_cubic_" + std::to_string(points), "solver")
+        .add("converged", double(stats.converged)).add("mean_iterations", double(stats.iterations) / double(points))
+        .add("tree_points_per_s", points / treeMs * 1e3).add("tape_points_per_s", points / serialMs * 1e3)
+        .add("pool_points_per_s", points / poolMs * 1e3).add("workers", double(pool.size())));
+}
+
+// Сравнение загрузки производных из двоичного файла с повторным разбором текста.
+void bench_binary_load(const std::string &source, int order) {
+    Lexer lexer{source};
+    Parser<Value_t> parser{lexer};
+    Expression<Value_t> expr = parser.parseExpression();
+
+    std::vector<Expression<Value_t>> derivatives;
+    Expression<Value_t> current = expr;
+    for (int i = 0; i < order; i++) {
+        current = current.diff("x");
+        derivatives.push_back(current);
+    }
+
+    std::string text = derivatives.back().to_string();
+    std::string path = (std::filesystem::temp_directory_path() / "differentiator_bench.sdx").string();
+
+    double saveMs = measure_ms([&] { save_binary(path, derivatives); });
+
+    double parseMs = measure_ms([&] {
+        Lexer textLexer{text};
+        Parser<Value_t> textParser{textLexer};
+        textParser.parseExpression();
+    });
+
+    double loadExprMs = measure_ms([&] { BinaryImage<Value_t>(path).expressions(); });
+    double loadTapeMs = measure_ms([&] { BinaryImage<Value_t>(path).tape(); });
+
+    records.push_back(Record("derivative_set_" + std::to_string(order), "binary_load")
+        .add("text_bytes", double(text.size()))
+        .add("binary_bytes", double(std::filesystem::file_size(path)))
+        .add("parse_last_ms", parseMs)
+        .add("save_all_ms", saveMs)
+        .add("load_expressions_all_ms", loadExprMs)
+        .add("load_tape_all_ms", loadTapeMs));
+
+    std::filesystem::remove(path);
+}
+
+int main(int argc, char* argv[]) {
+    // Флаг --quick уменьшает размеры входных данных для быстрой проверки.
+    bool quick = argc > 1 && std::strcmp(argv[1], "--quick") == 0;
+    size_t scale = quick ? 1 : 4;
+
+    std::vector<Family> families = {
+        wide_polynomial(16 * scale),
+        deep_nesting(16 * scale),
+        trig_tower(16 * scale),
+        power_chain(2 * scale),
+        multi_variable(8 * scale),
+    };
+
+    for (size_t nodes = 100; nodes <= 1000 * scale; nodes *= 10) {
+        families.push_back(random_expression(nodes));
+    }
+
+    for (const Family &family : families) {
+        bench_family(family);
+    }
+    bench_diff_all(16 * scale);
+    bench_fork_join(families.back(), 256);
+    bench_jacobian(64 * scale);
+    bench_specialize();
+    bench_polynomial(12);
+    bench_builders(2500 * scale);
+    bench_deep(100000 * scale);
+    bench_frozen(20000 * scale);
+    bench_incremental(1000 * scale, 40);
+    bench_solver(1024 * scale);
+    bench_binary_load("exp(x / y) * ln(x + y) + x ^ x * y - (x * y) ^ 3", 3);
+
+    printf("{\n  \"benchmarks\": [\n");
+    for (size_t i = 0; i < records.size(); i++) {
+        printf("    %s%s\n", records[i].to_json().c_str(), i + 1 < records.size() ? "," : "");
+    }
+    printf("  ]\n}\n");
+
+    return EXIT_SUCCESS;
+}
\ No newline at end of file
@@ -0,0 +1,250 @@
+#include <closure.hpp>
+
+#include <stdexcept>
+#include <cmath>
+#include <complex>
+#include <unordered_map>
+
+namespace {
+
+// Вид операнда замыкания.
+enum OperandKind {
+    OPERAND_VALUE,
+    OPERAND_VARIABLE,
+    OPERAND_NODE
+};
+
+template <typename Value_t>
+using Closure = typename ClosureEvaluator<Value_t>::Closure;
+
+template <typename Value_t, OperandKind kind>
+inline Value_t fetch(const Value_t *registers, uint32_t index, const Value_t &value, const Value_t *variables) {
+    if constexpr (kind == OPERAND_VALUE) {
+        (void) registers;
+        (void) index;
+        (void) variables;
+        return value;
+    }
+    else if constexpr (kind == OPERAND_VARIABLE) {
+        (void) registers;
+        (void) value;
+        return variables[index];
+    }
+    else {
+        (void) value;
+        (void) variables;
+        return registers[index];
+    }
+}
+
+template <typename Value_t, NodeType type>
+inline Value_t apply(const Value_t &left, const Value_t &right) {
+    // Для функций sin, cos, ln и exp правый операнд не используется.
+    (void) right;
+
+    if constexpr (type == NODE_ADD) return left + right;
+    if constexpr (type == NODE_SUB) return left - right;
+    if constexpr (type == NODE_MUL) return left * right;
+    if constexpr (type == NODE_DIV) return left / right;
+    if constexpr (type == NODE_POW) return power(left, right);
+    if constexpr (type == NODE_SIN) return sin(left);
+    if constexpr (type == NODE_COS) return cos(left);
+    if constexpr (type == NODE_LN)  return log(left);
+    if constexpr (type == NODE_EXP) return exp(left);
+}
+
+template <typename Value_t, NodeType type, OperandKind leftKind, OperandKind rightKind>
+Value_t binary(const Value_t *registers, const Closure<Value_t> &self, const Value_t *variables) {
+    return apply<Value_t, type>(fetch<Value_t, leftKind>(registers, self.left, self.leftValue, variables),
+                                fetch<Value_t, rightKind>(registers, self.right, self.rightValue, variables));
+}
+
+template <typename Value_t, NodeType type, OperandKind kind>
+Value_t unary(const Value_t *registers, const Closure<Value_t> &self, const Value_t *variables) {
+    return apply<Value_t, type>(fetch<Value_t, kind>(registers, self.left, self.leftValue, variables), Value_t(0.0));
+}
+
+// Лист выражения используется как замыкание, только если всё выражение - число или переменная.
+template <typename Value_t, OperandKind kind>
+Value_t leaf(const Value_t *registers, const Closure<Value_t> &self, const Value_t *variables) {
+    return fetch<Value_t, kind>(registers, self.left, self.leftValue, variables);
+}
+
+template <typename Value_t>
+using Function = Value_t (*)(const Value_t*, const Closure<Value_t>&, const Value_t*);
+
+template <typename Value_t, NodeType type, OperandKind leftKind>
+Function<Value_t> select_binary(OperandKind rightKind) {
+    switch (rightKind) {
+        case OPERAND_VALUE:    return binary<Value_t, type, leftKind, OPERAND_VALUE>;
+        case OPERAND_VARIABLE: return binary<Value_t, type, leftKind, OPERAND_VARIABLE>;
+        case OPERAND_NODE:     return binary<Value_t, type, leftKind, OPERAND_NODE>;
+    }
+    return nullptr;
+}
+
+template <typename Value_t, NodeType type>
+Function<Value_t> select_binary(OperandKind leftKind, OperandKind rightKind) {
+    switch (leftKind) {
+        case OPERAND_VALUE:    return select_binary<Value_t, type, OPERAND_VALUE>(rightKind);
+        case OPERAND_VARIABLE: return select_binary<Value_t, type, OPERAND_VARIABLE>(rightKind);
+        case OPERAND_NODE:     return select_binary<Value_t, type, OPERAND_NODE>(rightKind);
+    }
+    return nullptr;
+}
+
+template <typename Value_t, NodeType type>
+Function<Value_t> select_unary(OperandKind kind) {
+    switch (kind) {
+        case OPERAND_VALUE:    return unary<Value_t, type, OPERAND_VALUE>;
+        case OPERAND_VARIABLE: return unary<Value_t, type, OPERAND_VARIABLE>;
+        case OPERAND_NODE:     return unary<Value_t, type, OPERAND_NODE>;
+    }
+    return nullptr;
+}
+
+template <typename Value_t>
+Function<Value_t> select(NodeType type, OperandKind leftKind, OperandKind rightKind) {
+    switch (type) {
+        case NODE_VALUE:    return leaf<Value_t, OPERAND_VALUE>;
+        case NODE_VARIABLE: return leaf<Value_t, OPERAND_VARIABLE>;
+        case NODE_ADD:      return select_binary<Value_t, NODE_ADD>(leftKind, rightKind);
+        case NODE_SUB:      return select_binary<Value_t, NODE_SUB>(leftKind, rightKind);
+        case NODE_MUL:      return select_binary<Value_t, NODE_MUL>(leftKind, rightKind);
+        case NODE_DIV:      return select_binary<Value_t, NODE_DIV>(leftKind, rightKind);
+        case NODE_POW:      return select_binary<Value_t, NODE_POW>(leftKind, rightKind);
+        case NODE_SIN:      return select_unary<Value_t, NODE_SIN>(leftKind);
+        case NODE_COS:      return select_unary<Value_t, NODE_COS>(leftKind);
+        case NODE_LN:       return select_unary<Value_t, NODE_LN>(leftKind);
+        case NODE_EXP:      return select_unary<Value_t, NODE_EXP>(leftKind);
+    }
+    return nullptr;
+}
+
+} // namespace
+
+template <typename Value_t>
+ClosureEvaluator<Value_t>::ClosureEvaluator(const Expression<Value_t> &expr) :
+    closures_  (),
+    variables_ ()
+{
+    std::unordered_map<const ExpressionImpl<Value_t>*, uint32_t> compiled;
+    std::unordered_map<std::string, uint32_t> variableIndex;
+
+    auto variable_index = [&](const ExpressionImpl<Value_t> *node) {
+        const std::string &name = static_cast<const Variable<Value_t>*>(node)->name();
+
+        auto [iter, inserted] = variableIndex.try_emplace(name, static_cast<uint32_t>(variables_.size()));
+        if (inserted) variables_.push_back(name);
+        return iter->second;
+    };
+
+    // Операнд-лист встраивается в замыкание родителя, операнд-узел задаётся номером замыкания.
+    auto operand = [&](const ExpressionImpl<Value_t> *node, uint32_t &index, Value_t &value) {
+        switch (node->type()) {
+            case NODE_VALUE:
+                value = static_cast<const Value<Value_t>*>(node)->value();
+                return OPERAND_VALUE;
+            case NODE_VARIABLE:
+                index = variable_index(node);
+                return OPERAND_VARIABLE;
+            default:
+                index = compiled.at(node);
+                return OPERAND_NODE;
+        }
+    };
+
+    // Обход в глубину с явным стеком: замыкание создаётся после замыканий своих операндов-узлов.
+    std::vector<const ExpressionImpl<Value_t>*> stack{expr.impl().get()};
+
+    while (!stack.empty()) {
+        const ExpressionImpl<Value_t> *node = stack.back();
+
+        if (compiled.contains(node)) {
+            stack.pop_back();
+            continue;
+        }
+
+        bool ready = true;
+        for (size_t i = 0; i < node->arity(); i++) {
+            const ExpressionImpl<Value_t> *child = node->operand(i).get();
+
+            if (child->arity() > 0 && !compiled.contains(child)) {
+                stack.push_back(child);
+                ready = false;
+            }
+        }
+        if (!ready) continue;
+
+        stack.pop_back();
+
+        Closure closure{nullptr, 0, 0, Value_t(0.0), Value_t(0.0)};
+        OperandKind leftKind  = OPERAND_VALUE;
+        OperandKind rightKind = OPERAND_VALUE;
+
+        if (node->arity() == 0) {
+            leftKind = operand(node, closure.left, closure.leftValue);
+        }
+        else {
+            leftKind = operand(node->operand(0).get(), closure.left, closure.leftValue);
+            if (node->arity() == 2) {
+                rightKind = operand(node->operand(1).get(), closure.right, closure.rightValue);
+            }
+        }
+
+        closure.call = select<Value_t>(node->type(), leftKind, rightKind);
+
+        compiled.emplace(node, static_cast<uint32_t>(closures_.size()));
+        closures_.push_back(closure);
+    }
+}
+
+template <typename Value_t>
+Value_t ClosureEvaluator<Value_t>::eval(std::map<std::string, Value_t> &context) const {
+    std::vector<Value_t> values;
+    values.reserve(variables_.size());
+
+    for (const std::string &name : variables_) {
+        auto iter = context.find(name);
+
+        if (iter == context.end()) {
+            throw std::runtime_error("Variable \"" + name + "\" not present in evaluation context");
+        }
+
+        values.push_back(iter->second);
+    }
+
+    return eval(values.data());
+}
+
+template <typename Value_t>
+Value_t ClosureEvaluator<Value_t>::eval(const Value_t *variables) const {
+    thread_local std::vector<Value_t> registers;
+    if (registers.size() < closures_.size()) registers.resize(closures_.size());
+
+    return eval(variables, registers.data());
+}
+
+template <typename Value_t>
+Value_t ClosureEvaluator<Value_t>::eval(const Value_t *variables, Value_t *registers) const {
+    // Замыкания записаны операндами вперёд: проход по массиву без рекурсии,
+    // значение каждого узла сохраняется в регистр с его номером. Корень - последний.
+    for (size_t i = 0; i < closures_.size(); i++) {
+        registers[i] = closures_[i].call(registers, closures_[i], variables);
+    }
+
+    return registers[closures_.size() - 1];
+}
+
+template <typename Value_t>
+const std::vector<std::string> &ClosureEvaluator<Value_t>::variables() const {
+    return variables_;
+}
+
+template <typename Value_t>
+size_t ClosureEvaluator<Value_t>::size() const {
+    return closures_.size();
+}
+
+template class ClosureEvaluator<long double>;
+template class ClosureEvaluator<std::complex<long double>>;
\ No newline at end of file
@@ -0,0 +1,346 @@
+#include <complex_batch.hpp>
+
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+//========================//
+// Структура ComplexBatch //
+//========================//
+
+template <typename Real_t>
+size_t ComplexBatch<Real_t>::size() const {
+    return re.size();
+}
+
+template <typename Real_t>
+void ComplexBatch<Real_t>::resize(size_t count) {
+    re.resize(count);
+    im.resize(count);
+}
+
+template struct ComplexBatch<double>;
+template struct ComplexBatch<long double>;
+
+//=========================================//
+// Вычислительные ядра для быстрого режима //
+//=========================================//
+
+namespace {
+
+// Произведение (a + bi)(c + di) без обработки особых значений.
+template <typename Real_t>
+inline void fast_mul(Real_t a, Real_t b, Real_t c, Real_t d, Real_t &re, Real_t &im) {
+    re = a * c - b * d;
+    im = a * d + b * c;
+}
+
+// Частное (a + bi)/(c + di) без масштабирования и обработки особых значений.
+template <typename Real_t>
+inline void fast_div(Real_t a, Real_t b, Real_t c, Real_t d, Real_t &re, Real_t &im) {
+    Real_t inverse = Real_t(1) / (c * c + d * d);
+
+    re = (a * c + b * d) * inverse;
+    im = (b * c - a * d) * inverse;
+}
+
+template <typename Real_t>
+inline void fast_exp(Real_t a, Real_t b, Real_t &re, Real_t &im) {
+    Real_t modulus = std::exp(a);
+
+    re = modulus * std::cos(b);
+    im = modulus * std::sin(b);
+}
+
+template <typename Real_t>
+inline void fast_log(Real_t a, Real_t b, Real_t &re, Real_t &im) {
+    re = Real_t(0.5) * std::log(a * a + b * b);
+    im = std::atan2(b, a);
+}
+
+// Возведение в степень: целые показатели обрабатываются повторным возведением в квадрат,
+// остальные - через exp(w * ln(z)).
+template <typename Real_t>
+inline void fast_pow(Real_t a, Real_t b, Real_t c, Real_t d, Real_t &re, Real_t &im) {
+    // Нулевое основание: 0^0 = 1, ноль при положительной действительной части показателя,
+    // иначе полюс с теми же значениями, что у std::pow (inf или nan и nan).
+    if (a == Real_t(0) && b == Real_t(0)) {
+        if (c == Real_t(0) && d == Real_t(0)) {
+            re = Real_t(1);
+            im = Real_t(0);
+        }
+        else if (c > Real_t(0)) {
+            re = Real_t(0);
+            im = Real_t(0);
+        }
+        else {
+            re = c < Real_t(0) ? std::numeric_limits<Real_t>::infinity() : std::numeric_limits<Real_t>::quiet_NaN();
+            im = std::numeric_limits<Real_t>::quiet_NaN();
+        }
+        return;
+    }
+
+    if (d == Real_t(0) && c == std::floor(c) && std::fabs(c) <= Real_t(64)) {
+        long n = static_cast<long>(c);
+        unsigned long e = static_cast<unsigned long>(n < 0 ? -n : n);
+
+        Real_t accRe = 1, accIm = 0;
+        Real_t baseRe = a, baseIm = b;
+        while (e != 0) {
+            if (e & 1) fast_mul(accRe, accIm, baseRe, baseIm, accRe, accIm);
+            fast_mul(baseRe, baseIm, baseRe, baseIm, baseRe, baseIm);
+            e >>= 1;
+        }
+
+        if (n < 0) {
+            fast_div(Real_t(1), Real_t(0), accRe, accIm, re, im);
+        }
+        else {
+            re = accRe;
+            im = accIm;
+        }
+        return;
+    }
+
+    Real_t logRe, logIm, prodRe, prodIm;
+    fast_log(a, b, logRe, logIm);
+    fast_mul(c, d, logRe, logIm, prodRe, prodIm);
+    fast_exp(prodRe, prodIm, re, im);
+}
+
+template <typename Real_t>
+inline void fast_sin(Real_t a, Real_t b, Real_t &re, Real_t &im) {
+    re = std::sin(a) * std::cosh(b);
+    im = std::cos(a) * std::sinh(b);
+}
+
+template <typename Real_t>
+inline void fast_cos(Real_t a, Real_t b, Real_t &re, Real_t &im) {
+    re =  std::cos(a) * std::cosh(b);
+    im = -std::sin(a) * std::sinh(b);
+}
+
+// sin и cos одного аргумента: вещественные функции вычисляются по одному разу.
+template <typename Real_t>
+inline void fast_sincos(Real_t a, Real_t b, Real_t &sinRe, Real_t &sinIm, Real_t &cosRe, Real_t &cosIm) {
+    Real_t sine   = std::sin(a);
+    Real_t cosine = std::cos(a);
+    Real_t ch     = std::cosh(b);
+    Real_t sh     = std::sinh(b);
+
+    sinRe =  sine * ch;
+    sinIm =  cosine * sh;
+    cosRe =  cosine * ch;
+    cosIm = -sine * sh;
+}
+
+// Поточечное применение операции std::complex к набору в виде структуры массивов.
+template <typename Real_t, typename Operation>
+inline void strict_binary(const Real_t *aRe, const Real_t *aIm, const Real_t *bRe, const Real_t *bIm,
+                          Real_t *re, Real_t *im, size_t count, Operation operation) {
+    for (size_t k = 0; k < count; k++) {
+        std::complex<Real_t> value = operation(std::complex<Real_t>{aRe[k], aIm[k]},
+                                               std::complex<Real_t>{bRe[k], bIm[k]});
+        re[k] = value.real();
+        im[k] = value.imag();
+    }
+}
+
+template <typename Real_t, typename Operation>
+inline void strict_unary(const Real_t *aRe, const Real_t *aIm, Real_t *re, Real_t *im,
+                         size_t count, Operation operation) {
+    for (size_t k = 0; k < count; k++) {
+        std::complex<Real_t> value = operation(std::complex<Real_t>{aRe[k], aIm[k]});
+        re[k] = value.real();
+        im[k] = value.imag();
+    }
+}
+
+} // namespace
+
+//=============================//
+// Класс ComplexBatchEvaluator //
+//=============================//
+
+template <typename Real_t>
+ComplexBatchEvaluator<Real_t>::ComplexBatchEvaluator(const Expression<std::complex<long double>> &expr,
+                                                     ComplexMode mode) :
+    tape_        (expr),
+    mode_        (mode),
+    registersRe_ (tape_.size() * BLOCK_SIZE),
+    registersIm_ (tape_.size() * BLOCK_SIZE)
+{
+    // Значения констант не зависят от точки, поэтому заполняем их один раз.
+    for (size_t i = 0; i < tape_.size(); i++) {
+        const TapeInstruction &instr = tape_.code()[i];
+
+        if (instr.type == NODE_VALUE) {
+            std::complex<long double> value = tape_.constants()[instr.left];
+
+            std::fill_n(registersRe_.begin() + i * BLOCK_SIZE, BLOCK_SIZE, static_cast<Real_t>(value.real()));
+            std::fill_n(registersIm_.begin() + i * BLOCK_SIZE, BLOCK_SIZE, static_cast<Real_t>(value.imag()));
+        }
+    }
+}
+
+template <typename Real_t>
+void ComplexBatchEvaluator<Real_t>::eval(const std::map<std::string, ComplexBatch<Real_t>> &inputs,
+                                         ComplexBatch<Real_t> &result) {
+    std::vector<const ComplexBatch<Real_t>*> variables;
+    size_t count = 0;
+
+    for (const std::string &name : tape_.variables()) {
+        auto iter = inputs.find(name);
+
+        if (iter == inputs.end()) {
+            throw std::runtime_error("Variable \"" + name + "\" not present in evaluation context");
+        }
+        if (!variables.empty() && iter->second.size() != count) {
+            throw std::runtime_error("Variable \"" + name + "\" has mismatching number of points");
+        }
+
+        count = iter->second.size();
+        variables.push_back(&iter->second);
+    }
+
+    // Выражение без переменных вычисляется в одной точке.
+    if (variables.empty()) {
+        count = 1;
+    }
+
+    result.resize(count);
+
+    for (size_t offset = 0; offset < count; offset += BLOCK_SIZE) {
+        evalBlock(variables, offset, std::min(BLOCK_SIZE, count - offset), result);
+    }
+}
+
+template <typename Real_t>
+void ComplexBatchEvaluator<Real_t>::evalBlock(const std::vector<const ComplexBatch<Real_t>*> &variables,
+                                              size_t offset, size_t count, ComplexBatch<Real_t> &result) {
+    const std::vector<TapeInstruction> &code = tape_.code();
+
+    for (size_t i = 0; i < code.size(); i++) {
+        const TapeInstruction &instr = code[i];
+
+        Real_t *re = registersRe_.data() + i * BLOCK_SIZE;
+        Real_t *im = registersIm_.data() + i * BLOCK_SIZE;
+
+        // Значения констант заполнены при создании вычислителя.
+        if (instr.type == NODE_VALUE) {
+            continue;
+        }
+
+        if (instr.type == NODE_VARIABLE) {
+            const ComplexBatch<Real_t> &input = *variables[instr.left];
+
+            std::copy_n(input.re.begin() + offset, count, re);
+            std::copy_n(input.im.begin() + offset, count, im);
+            continue;
+        }
+
+        const Real_t *aRe = registersRe_.data() + instr.left  * BLOCK_SIZE;
+        const Real_t *aIm = registersIm_.data() + instr.left  * BLOCK_SIZE;
+        const Real_t *bRe = registersRe_.data() + instr.right * BLOCK_SIZE;
+        const Real_t *bIm = registersIm_.data() + instr.right * BLOCK_SIZE;
+
+        // Сложение и вычитание не требуют обработки особых значений ни в одном из режимов.
+        if (instr.type == NODE_ADD) {
+            for (size_t k = 0; k < count; k++) { re[k] = aRe[k] + bRe[k]; im[k] = aIm[k] + bIm[k]; }
+            continue;
+        }
+        if (instr.type == NODE_SUB) {
+            for (size_t k = 0; k < count; k++) { re[k] = aRe[k] - bRe[k]; im[k] = aIm[k] - bIm[k]; }
+            continue;
+        }
+
+        if (mode_ == COMPLEX_FAST && (instr.type == NODE_SIN || instr.type == NODE_COS)) {
+            uint32_t partner = tape_.partners()[i];
+
+            // Первая инструкция пары sin/cos записывает оба значения, вторая пропускается.
+            if (partner != Tape<std::complex<long double>>::NO_PARTNER) {
+                if (partner < i) continue;
+
+                Real_t *pairRe = registersRe_.data() + partner * BLOCK_SIZE;
+                Real_t *pairIm = registersIm_.data() + partner * BLOCK_SIZE;
+                Real_t *sinRe = instr.type == NODE_SIN ? re : pairRe;
+                Real_t *sinIm = instr.type == NODE_SIN ? im : pairIm;
+                Real_t *cosRe = instr.type == NODE_SIN ? pairRe : re;
+                Real_t *cosIm = instr.type == NODE_SIN ? pairIm : im;
+
+                for (size_t k = 0; k < count; k++) {
+                    fast_sincos(aRe[k], aIm[k], sinRe[k], sinIm[k], cosRe[k], cosIm[k]);
+                }
+                continue;
+            }
+        }
+
+        if (mode_ == COMPLEX_FAST) {
+            switch (instr.type) {
+                case NODE_MUL:
+                    for (size_t k = 0; k < count; k++) fast_mul(aRe[k], aIm[k], bRe[k], bIm[k], re[k], im[k]);
+                    break;
+                case NODE_DIV:
+                    for (size_t k = 0; k < count; k++) fast_div(aRe[k], aIm[k], bRe[k], bIm[k], re[k], im[k]);
+                    break;
+                case NODE_POW:
+                    for (size_t k = 0; k < count; k++) fast_pow(aRe[k], aIm[k], bRe[k], bIm[k], re[k], im[k]);
+                    break;
+                case NODE_SIN:
+                    for (size_t k = 0; k < count; k++) fast_sin(aRe[k], aIm[k], re[k], im[k]);
+                    break;
+                case NODE_COS:
+                    for (size_t k = 0; k < count; k++) fast_cos(aRe[k], aIm[k], re[k], im[k]);
+                    break;
+                case NODE_LN:
+                    for (size_t k = 0; k < count; k++) fast_log(aRe[k], aIm[k], re[k], im[k]);
+                    break;
+                case NODE_EXP:
+                    for (size_t k = 0; k < count; k++) fast_exp(aRe[k], aIm[k], re[k], im[k]);
+                    break;
+                default:
+                    break;
+            }
+        }
+        else {
+            // Строгий режим: поточечные операции std::complex.
+            switch (instr.type) {
+                case NODE_MUL:
+                    strict_binary(aRe, aIm, bRe, bIm, re, im, count,
+                                  [](std::complex<Real_t> a, std::complex<Real_t> b) { return a * b; });
+                    break;
+                case NODE_DIV:
+                    strict_binary(aRe, aIm, bRe, bIm, re, im, count,
+                                  [](std::complex<Real_t> a, std::complex<Real_t> b) { return a / b; });
+                    break;
+                case NODE_POW:
+                    strict_binary(aRe, aIm, bRe, bIm, re, im, count,
+                                  [](std::complex<Real_t> a, std::complex<Real_t> b) { return std::pow(a, b); });
+                    break;
+                case NODE_SIN:
+                    strict_unary(aRe, aIm, re, im, count, [](std::complex<Real_t> a) { return std::sin(a); });
+                    break;
+                case NODE_COS:
+                    strict_unary(aRe, aIm, re, im, count, [](std::complex<Real_t> a) { return std::cos(a); });
+                    break;
+                case NODE_LN:
+                    strict_unary(aRe, aIm, re, im, count, [](std::complex<Real_t> a) { return std::log(a); });
+                    break;
+                case NODE_EXP:
+                    strict_unary(aRe, aIm, re, im, count, [](std::complex<Real_t> a) { return std::exp(a); });
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    uint32_t output = tape_.outputs()[0];
+
+    std::copy_n(registersRe_.begin() + output * BLOCK_SIZE, count, result.re.begin() + offset);
+    std::copy_n(registersIm_.begin() + output * BLOCK_SIZE, count, result.im.begin() + offset);
+}
+
+template class ComplexBatchEvaluator<double>;
+template class ComplexBatchEvaluator<long double>;
\ No newline at end of file
@@ -0,0 +1,227 @@
+#include <diff_cache.hpp>
+
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <cstdio>
+#include <complex>
+
+#include <unistd.h>
+
+#include <hash.hpp>
+#include <serialize.hpp>
+
+namespace fs = std::filesystem;
+
+// Расширение файлов записей кеша.
+static const char *ENTRY_EXTENSION = ".sdx";
+
+// Уровень упрощения в записи хранится числом четвёртым выражением.
+template <typename Value_t>
+static Expression<Value_t> level_tag(SimplifyLevel level) {
+    return Expression<Value_t>(Value_t(static_cast<int>(level)));
+}
+
+template <typename Value_t>
+DiffCache<Value_t>::DiffCache(const std::string &directory, uint64_t capacity) :
+    directory_ (directory),
+    capacity_  (capacity),
+    mutex_     (),
+    recency_   (),
+    entries_   (),
+    bytes_     (0),
+    hits_      (0),
+    misses_    (0),
+    stores_    (0),
+    evictions_ (0)
+{
+    fs::create_directories(directory_);
+
+    // Восстанавливаем порядок использования записей по времени последнего обращения.
+    std::vector<std::pair<fs::file_time_type, fs::directory_entry>> found;
+    for (const fs::directory_entry &file : fs::directory_iterator(directory_)) {
+        if (file.is_regular_file() && file.path().extension() == ENTRY_EXTENSION) {
+            found.emplace_back(file.last_write_time(), file);
+        }
+    }
+
+    std::sort(found.begin(), found.end(), [](const auto &first, const auto &second) {
+        return first.first > second.first;
+    });
+
+    for (const auto &[time, file] : found) {
+        std::string key = file.path().stem().string();
+
+        recency_.push_back(key);
+        entries_.emplace(key, Entry{std::prev(recency_.end()), file.file_size()});
+        bytes_ += file.file_size();
+    }
+
+    evict();
+}
+
+template <typename Value_t>
+std::string DiffCache<Value_t>::entry_key(const Expression<Value_t> &expr, const std::string &by,
+                                          SimplifyLevel level) {
+    uint64_t hash = structural_hash(expr);
+    hash ^= std::hash<std::string>{}(by) * 0x9e3779b97f4a7c15ULL;
+    hash += static_cast<uint64_t>(level);
+
+    char key[17];
+    snprintf(key, sizeof(key), "%016llx", static_cast<unsigned long long>(hash));
+    return key;
+}
+
+template <typename Value_t>
+Expression<Value_t> DiffCache<Value_t>::diff(const Expression<Value_t> &expr, const std::string &by,
+                                             SimplifyLevel level) {
+    std::string key = entry_key(expr, by, level);
+
+    Expression<Value_t> result = expr;
+    if (lookup(key, expr, by, level, result)) {
+        hits_++;
+        return result;
+    }
+    misses_++;
+
+    result = expr.diff(by);
+    if (level == SIMPLIFY_PRETTIFY) {
+        result = result.prettify();
+    }
+
+    store(key, expr, by, level, result);
+
+    return result;
+}
+
+template <typename Value_t>
+Expression<Value_t> DiffCache<Value_t>::prettify(const Expression<Value_t> &expr, const std::string &by,
+                                                 const Expression<Value_t> &derivative) {
+    std::string key = entry_key(expr, by, SIMPLIFY_PRETTIFY);
+
+    Expression<Value_t> result = expr;
+    if (lookup(key, expr, by, SIMPLIFY_PRETTIFY, result)) {
+        hits_++;
+        return result;
+    }
+    misses_++;
+
+    result = derivative.prettify();
+    store(key, expr, by, SIMPLIFY_PRETTIFY, result);
+
+    return result;
+}
+
+template <typename Value_t>
+bool DiffCache<Value_t>::lookup(const std::string &key, const Expression<Value_t> &expr,
+                                const std::string &by, SimplifyLevel level, Expression<Value_t> &result) {
+    fs::path path = directory_ / (key + ENTRY_EXTENSION);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        auto iter = entries_.find(key);
+        if (iter == entries_.end()) return false;
+
+        // Перемещаем запись в начало очереди использования.
+        recency_.splice(recency_.begin(), recency_, iter->second.position);
+    }
+
+    try {
+        std::vector<Expression<Value_t>> stored = BinaryImage<Value_t>(path.string()).expressions();
+
+        if (stored.size() != 4 || stored[2].to_string() != by ||
+            !structurally_equal(stored[3], level_tag<Value_t>(level)) || !structurally_equal(stored[0], expr)) {
+            return false;
+        }
+
+        // Время изменения файла служит временем последнего обращения между запусками.
+        std::error_code ignored;
+        fs::last_write_time(path, fs::file_time_type::clock::now(), ignored);
+
+        result = stored[1];
+        return true;
+    }
+    catch (const std::exception&) {
+        // Повреждённую или удалённую другим процессом запись исключаем из индекса.
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        auto iter = entries_.find(key);
+        if (iter != entries_.end()) {
+            bytes_ -= iter->second.size;
+            recency_.erase(iter->second.position);
+            entries_.erase(iter);
+        }
+        return false;
+    }
+}
+
+template <typename Value_t>
+void DiffCache<Value_t>::store(const std::string &key, const Expression<Value_t> &expr,
+                               const std::string &by, SimplifyLevel level, const Expression<Value_t> &result) {
+    fs::path path = directory_ / (key + ENTRY_EXTENSION);
+
+    // Запись производится во временный файл и атомарно переименовывается,
+    // чтобы параллельные процессы не прочитали частично записанный файл.
+    fs::path temporary = directory_ / (key + ".tmp." + std::to_string(getpid()) + "." +
+                                       std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())));
+
+    uint64_t size = 0;
+    try {
+        save_binary(temporary.string(), std::vector<Expression<Value_t>>{
+            expr, result, Expression<Value_t>(by), level_tag<Value_t>(level)
+        });
+        size = fs::file_size(temporary);
+        fs::rename(temporary, path);
+    }
+    catch (const std::exception&) {
+        // Кеш необязателен: ошибка записи не влияет на результат дифференцирования.
+        std::error_code ignored;
+        fs::remove(temporary, ignored);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto iter = entries_.find(key);
+    if (iter != entries_.end()) {
+        bytes_ -= iter->second.size;
+        recency_.erase(iter->second.position);
+        entries_.erase(iter);
+    }
+
+    recency_.push_front(key);
+    entries_.emplace(key, Entry{recency_.begin(), size});
+    bytes_ += size;
+    stores_++;
+
+    evict();
+}
+
+template <typename Value_t>
+void DiffCache<Value_t>::evict() {
+    // Вызывается под блокировкой mutex_ (либо из конструктора).
+    while (bytes_ > capacity_ && !recency_.empty()) {
+        std::string key = recency_.back();
+        recency_.pop_back();
+
+        auto iter = entries_.find(key);
+        bytes_ -= iter->second.size;
+        entries_.erase(iter);
+
+        std::error_code ignored;
+        fs::remove(directory_ / (key + ENTRY_EXTENSION), ignored);
+        evictions_++;
+    }
+}
+
+template <typename Value_t>
+DiffCacheStats DiffCache<Value_t>::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    return DiffCacheStats{hits_.load(), misses_.load(), stores_.load(), evictions_.load(), bytes_};
+}
+
+template class DiffCache<long double>;
+template class DiffCache<std::complex<long double>>;
\ No newline at end of file
@@ -5,9 +5,17 @@
 #include <map>
 #include <iostream>
 #include <sstream>
+#include <fstream>
 
 #include <lexer.hpp>
 #include <parser.hpp>
+#include <diff_cache.hpp>
+#include <server.hpp>
+#include <generator.hpp>
+#include <stats.hpp>
+#include <profiler.hpp>
+#include <solver.hpp>
+#include <thread_pool.hpp>
 
 typedef long double Value_t;
 
@@ -27,39 +35,217 @@ std::map<std::string, Value_t> parseVariables(int argc, char* argv[], int startI
 
 int main(int argc, char* argv[])
 {
+    // Флаг --stats[=json] допускается в любой позиции и исключается из списка аргументов.
+    std::string statsFormat;
+    int argCount = 0;
+    for (int i = 0; i < argc; i++) {
+        if (std::strcmp(argv[i], "--stats") == 0)           statsFormat = "text";
+        else if (std::strcmp(argv[i], "--stats=json") == 0) statsFormat = "json";
+        else argv[argCount++] = argv[i];
+    }
+    argc = argCount;
+
+    // Без --stats фазы не замеряются и выражения не обходятся.
+    Stats stats{!statsFormat.empty()};
+
     if (argc < 3) {
-        std::cerr << "Usage: differentiator --eval <expression> [var=value ...]\n";
-        std::cerr << "       differentiator --diff <expression> --by <variable>\n";
+        std::cerr << "Usage: differentiator --eval <expression> [var=value ...] [--stats[=json]]\n";
+        std::cerr << "       differentiator --diff <expression> --by <variable> [--cache <directory>] [--stats[=json]]\n";
+        std::cerr << "       differentiator --serve <socket> [--workers <count>] [--queue <count>]\n";
+        std::cerr << "       differentiator --generate <nodes> [--seed <n>] [--depth <n>] [--vars <n>] [--sharing <ratio>]\n";
+        std::cerr << "       differentiator --profile <expression> [--iterations <count>] [var=value ...]\n";
+        std::cerr << "       differentiator --taylor <expression> --at <variable>=<value> [var=value ...] [--order <k>]\n";
+        std::cerr << "       differentiator --solve <expression> --var <variable> --starts <file> [--minimize] [--iterations <n>]\n";
+        std::cerr << "                      [--tolerance <t>] [--workers <count>] [var=value ...] [--stats[=json]]\n";
         return EXIT_FAILURE;
     }
 
     if (std::strcmp(argv[1], "--eval") == 0) {
+        Lexer lexer{stats.phase("lex", [&] { return Lexer{std::string(argv[2])}.tokenize(); })};
+        Parser<Value_t> parser{lexer};
+        Expression expr = stats.phase("parse", [&] { return parser.parseExpression(); });
+        stats.measure(expr);
+
+        std::map<std::string, Value_t> context = parseVariables(argc, argv, 3);
+
+        Value_t value = stats.phase("eval", [&] { return expr.eval(context); });
+        std::string text = stats.phase("to_string", [&] { return expr.to_string(); });
+
+        printf("EVAL[%s] = %Lf\n", text.c_str(), value);
+
+    }
+    else if (std::strcmp(argv[1], "--diff") == 0 && argc >= 5 && std::strcmp(argv[3], "--by") == 0) {
+        Lexer lexer{stats.phase("lex", [&] { return Lexer{std::string(argv[2])}.tokenize(); })};
+        Parser<Value_t> parser{lexer};
+        Expression expr = stats.phase("parse", [&] { return parser.parseExpression(); });
+        stats.measure(expr);
+
+        std::string variable = argv[4];
+
+        if (argc >= 7 && std::strcmp(argv[5], "--cache") == 0) {
+            // Производная и её упрощение берутся из постоянного кеша либо вычисляются и сохраняются в него;
+            // фазы те же, что и без кеша.
+            DiffCache<Value_t> cache{std::string(argv[6])};
+            Expression diffExpr = stats.phase("diff", [&] { return cache.diff(expr, variable, SIMPLIFY_NONE); });
+            stats.measure(diffExpr);
+
+            Expression prettyExpr = stats.phase("prettify", [&] { return cache.prettify(expr, variable, diffExpr); });
+            stats.measure(prettyExpr);
+
+            std::string text = stats.phase("to_string", [&] { return prettyExpr.to_string(); });
+            printf("DIFF[%s] = [%s]\n", expr.to_string().c_str(), text.c_str());
+
+            DiffCacheStats cacheStats = cache.stats();
+            fprintf(stderr, "CACHE[hits=%llu misses=%llu evictions=%llu bytes=%llu]\n",
+                    static_cast<unsigned long long>(cacheStats.hits), static_cast<unsigned long long>(cacheStats.misses),
+                    static_cast<unsigned long long>(cacheStats.evictions), static_cast<unsigned long long>(cacheStats.bytes));
+        }
+        else {
+            Expression diffExpr = stats.phase("diff", [&] { return expr.diff(variable); });
+            stats.measure(diffExpr);
+
+            Expression prettyExpr = stats.phase("prettify", [&] { return diffExpr.prettify(); });
+            stats.measure(prettyExpr);
+
+            std::string text = stats.phase("to_string", [&] { return prettyExpr.to_string(); });
+            printf("DIFF[%s] = [%s]\n", expr.to_string().c_str(), text.c_str());
+        }
+
+    }
+    else if (std::strcmp(argv[1], "--serve") == 0) {
+        size_t workers = 0;
+        size_t queue = 64;
+
+        for (int i = 3; i + 1 < argc; i += 2) {
+            if (std::strcmp(argv[i], "--workers") == 0) workers = std::stoul(argv[i + 1]);
+            if (std::strcmp(argv[i], "--queue") == 0)   queue   = std::stoul(argv[i + 1]);
+        }
+
+        Server server{std::string(argv[2]), workers, queue};
+        server.run();
+    }
+    else if (std::strcmp(argv[1], "--generate") == 0) {
+        GeneratorOptions options;
+        options.nodes = std::stoul(argv[2]);
+
+        for (int i = 3; i + 1 < argc; i += 2) {
+            if (std::strcmp(argv[i], "--seed") == 0)    options.seed      = std::stoull(argv[i + 1]);
+            if (std::strcmp(argv[i], "--depth") == 0)   options.depth     = std::stoul(argv[i + 1]);
+            if (std::strcmp(argv[i], "--vars") == 0)    options.variables = std::stoul(argv[i + 1]);
+            if (std::strcmp(argv[i], "--sharing") == 0) options.sharing   = std::stod(argv[i + 1]);
+        }
+
+        // Текст случайного выражения для проверки лексера и парсера на больших входах.
+        ExpressionGenerator generator{options};
+        printf("%s\n", ExpressionGenerator::text(generator.expression()).c_str());
+    }
+    else if (std::strcmp(argv[1], "--profile") == 0) {
         Lexer lexer{std::string(argv[2])};
         Parser<Value_t> parser{lexer};
         Expression expr = parser.parseExpression();
 
         std::map<std::string, Value_t> context = parseVariables(argc, argv, 3);
 
-        printf("EVAL[%s] = %Lf\n", expr.to_string().c_str(), expr.eval(context));
+        size_t iterations = 1;
+        for (int i = 3; i + 1 < argc; i++) {
+            if (std::strcmp(argv[i], "--iterations") == 0) iterations = std::stoul(argv[i + 1]);
+        }
+
+        Profiler<Value_t> profiler{expr};
+        for (size_t i = 0; i < iterations; i++) {
+            profiler.eval(context);
+        }
 
+        // Свёрнутые стеки - в stdout для flamegraph.pl, сводка по типам узлов - в stderr.
+        printf("%s", profiler.folded().c_str());
+        for (const auto &[type, counters] : profiler.by_type()) {
+            fprintf(stderr, "PROFILE[type=%s calls=%llu cycles=%llu self=%llu]\n", node_type_name(type),
+                    static_cast<unsigned long long>(counters.calls), static_cast<unsigned long long>(counters.cycles),
+                    static_cast<unsigned long long>(counters.selfCycles));
+        }
     }
-    else if (std::strcmp(argv[1], "--diff") == 0 && argc >= 5 && std::strcmp(argv[3], "--by") == 0) {
+    else if (std::strcmp(argv[1], "--taylor") == 0 && argc >= 5 && std::strcmp(argv[3], "--at") == 0) {
         Lexer lexer{std::string(argv[2])};
         Parser<Value_t> parser{lexer};
         Expression expr = parser.parseExpression();
 
-        std::string variable = argv[4];
-        Expression diffExpr = expr.diff(variable);
+        // Разложение ведётся по первой переменной после --at, остальные переменные фиксированы.
+        std::string point = argv[4];
+        std::string variable = point.substr(0, point.find('='));
+        std::map<std::string, Value_t> context = parseVariables(argc, argv, 4);
 
-        printf("DIFF[%s] = [%s]\n", expr.to_string().c_str(), diffExpr.prettify().to_string().c_str());
+        size_t order = 8;
+        for (int i = 5; i + 1 < argc; i++) {
+            if (std::strcmp(argv[i], "--order") == 0) order = std::stoul(argv[i + 1]);
+        }
 
+        std::vector<Value_t> coefficients = stats.phase("taylor", [&] { return expr.taylor(variable, context, order); });
+
+        printf("TAYLOR[%s] at %s = %Lg:", expr.to_string().c_str(), variable.c_str(), context.at(variable));
+        for (Value_t coefficient : coefficients) {
+            printf(" %.18Lg", coefficient);
+        }
+        printf("\n");
+    }
+    else if (std::strcmp(argv[1], "--solve") == 0) {
+        Lexer lexer{std::string(argv[2])};
+        Parser<Value_t> parser{lexer};
+        Expression expr = parser.parseExpression();
+
+        std::string variable;
+        std::string startsPath;
+        SolverOptions options;
+        size_t workers = 0;
+        for (int i = 3; i < argc; i++) {
+            if (std::strcmp(argv[i], "--minimize") == 0) options.mode = SOLVE_MINIMUM;
+            if (i + 1 >= argc) continue;
+            if (std::strcmp(argv[i], "--var") == 0)        variable           = argv[i + 1];
+            if (std::strcmp(argv[i], "--starts") == 0)     startsPath         = argv[i + 1];
+            if (std::strcmp(argv[i], "--iterations") == 0) options.iterations = std::stoul(argv[i + 1]);
+            if (std::strcmp(argv[i], "--tolerance") == 0)  options.tolerance  = std::stold(argv[i + 1]);
+            if (std::strcmp(argv[i], "--workers") == 0)    workers            = std::stoul(argv[i + 1]);
+        }
+
+        // Начальные точки - числа, разделённые пробельными символами.
+        std::ifstream startsFile{startsPath};
+        if (variable.empty() || !startsFile) {
+            std::cerr << "--solve requires --var <variable> and a readable --starts <file>\n";
+            return EXIT_FAILURE;
+        }
+        std::vector<Value_t> starts;
+        for (Value_t start; startsFile >> start;) {
+            starts.push_back(start);
+        }
+
+        std::map<std::string, Value_t> parameters = parseVariables(argc, argv, 3);
+        NewtonSolver<Value_t> solver = stats.phase("compile", [&] {
+            return NewtonSolver<Value_t>{expr, variable, parameters, options};
+        });
+
+        ThreadPool pool{workers};
+        std::vector<SolveResult<Value_t>> results = stats.phase("solve", [&] { return solver.solve(starts, pool); });
+
+        for (const SolveResult<Value_t> &result : results) {
+            printf("SOLVE[%.18Lg] = %.18Lg value=%.18Lg residual=%.3Lg iterations=%zu status=%s\n", result.start, result.x,
+                   result.value, result.residual, result.iterations, solve_status_name(result.status));
+        }
+        fprintf(stderr, "%s", NewtonSolver<Value_t>::summarize(results).to_text().c_str());
     }
     else {
         std::cerr << "Invalid arguments.\n";
-        std::cerr << "Usage: differentiator --eval <expression> [var=value ...]\n";
-        std::cerr << "       differentiator --diff <expression> --by <variable>\n";
+        std::cerr << "Usage: differentiator --eval <expression> [var=value ...] [--stats[=json]]\n";
+        std::cerr << "       differentiator --diff <expression> --by <variable> [--cache <directory>] [--stats[=json]]\n";
+        std::cerr << "       differentiator --serve <socket> [--workers <count>] [--queue <count>]\n";
+        std::cerr << "       differentiator --generate <nodes> [--seed <n>] [--depth <n>] [--vars <n>] [--sharing <ratio>]\n";
+        std::cerr << "       differentiator --profile <expression> [--iterations <count>] [var=value ...]\n";
+        std::cerr << "       differentiator --taylor <expression> --at <variable>=<value> [var=value ...] [--order <k>]\n";
+        std::cerr << "       differentiator --solve <expression> --var <variable> --starts <file> [--minimize] [--iterations <n>]\n";
+        std::cerr << "                      [--tolerance <t>] [--workers <count>] [var=value ...] [--stats[=json]]\n";
         return EXIT_FAILURE;
     }
 
+    if (statsFormat == "text") fprintf(stderr, "%s", stats.to_text().c_str());
+    if (statsFormat == "json") fprintf(stderr, "%s\n", stats.to_json().c_str());
+
     return EXIT_SUCCESS;
 }
\ No newline at end of file
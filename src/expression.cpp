@@ -1,9 +1,112 @@
+
+
 #include <expression.hpp>
 #include <utils.hpp>
+#include <thread_pool.hpp>
+#include <fork_join.hpp>
+#include <symbols.hpp>
+#include <tape.hpp>
 
 #include <stdexcept>
 #include <cmath>
 #include <complex>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <functional>
+
+// Ответы depends_on(id) для узлов одного дерева, в которых переменная не отсеяна множеством
+// переменных. Строятся одним обходом на вызов diff и дальше только читаются, поэтому
+// таблица одного вызова может использоваться из нескольких потоков.
+template <typename Value_t>
+struct Dependencies {
+    uint32_t id;
+    std::unordered_map<const ExpressionImpl<Value_t>*, bool> found;
+};
+
+// Обход поддерева в обратном порядке с явным стеком; операнды, отсеянные множеством переменных,
+// не посещаются, общие подвыражения проверяются один раз. Для номеров, на которые множество
+// переменных отвечает точно, таблица не нужна и остаётся пустой.
+template <typename Value_t>
+static Dependencies<Value_t> find_dependencies(const ExpressionImpl<Value_t> *root, uint32_t id) {
+    Dependencies<Value_t> result{id, {}};
+    if (id < VariableSet::EXACT_IDS || !root->variables().may_contain(id)) return result;
+
+    auto is_variable = [id](const ExpressionImpl<Value_t> *node) {
+        return node->type() == NODE_VARIABLE && static_cast<const Variable<Value_t>*>(node)->id() == id;
+    };
+
+    // Узел, номер следующего операнда и ответ узла в таблице (элементы таблицы не перемещаются).
+    struct Frame {
+        const ExpressionImpl<Value_t> *node;
+        size_t next;
+        bool *answer;
+    };
+
+    // В цепочках операций (длинных суммах) таблица содержит около height() узлов.
+    result.found.reserve(root->height());
+    bool *rootAnswer = &result.found.emplace(root, is_variable(root)).first->second;
+    std::vector<Frame> stack{Frame{root, 0, rootAnswer}};
+
+    while (!stack.empty()) {
+        Frame &frame = stack.back();
+
+        if (frame.next == frame.node->arity()) {
+            bool answer = *frame.answer;
+            stack.pop_back();
+            if (!stack.empty()) *stack.back().answer = *stack.back().answer || answer;
+            continue;
+        }
+
+        const ExpressionImpl<Value_t> *child = frame.node->operand(frame.next++).get();
+        if (!child->variables().may_contain(id)) continue;
+
+        // Переменные-операнды проверяются на месте и в таблицу не попадают.
+        if (child->type() == NODE_VARIABLE) {
+            *frame.answer = *frame.answer || is_variable(child);
+            continue;
+        }
+
+        auto [iter, inserted] = result.found.try_emplace(child, false);
+        if (!inserted) {
+            // Узел уже обойден: дерево без циклов, поэтому незавершённые узлы - только предки.
+            *frame.answer = *frame.answer || iter->second;
+            continue;
+        }
+        stack.push_back(Frame{child, 0, &iter->second});
+    }
+
+    return result;
+}
+
+// Таблица, из которой отвечает depends_on в текущем потоке.
+template <typename Value_t>
+static const Dependencies<Value_t> *&current_dependencies() {
+    thread_local const Dependencies<Value_t> *current = nullptr;
+    return current;
+}
+
+// Подключение таблицы к текущему потоку на время жизни объекта.
+template <typename Value_t>
+class DependencyScope {
+public:
+    DependencyScope(const Dependencies<Value_t> &dependencies) :
+        previous_ (current_dependencies<Value_t>())
+    {
+        current_dependencies<Value_t>() = &dependencies;
+    }
+
+    ~DependencyScope() {
+        current_dependencies<Value_t>() = previous_;
+    }
+
+    DependencyScope(const DependencyScope &) = delete;
+    DependencyScope &operator=(const DependencyScope &) = delete;
+
+private:
+    const Dependencies<Value_t> *previous_;
+};
 
 //==================//
 // Класс Expression //
@@ -25,108 +128,655 @@ Expression<Value_t>::Expression(Value_t val) :
 {}
 
 template <typename Value_t>
-Expression<Value_t> Expression<Value_t>::operator+(const Expression<Value_t> &other) {
-    return Expression<Value_t>(std::make_shared<OperationAdd<Value_t>>(impl_, other.impl_));
+Expression<Value_t> Expression<Value_t>::operator+(Expression<Value_t> other) const & {
+    return Expression<Value_t>(std::make_shared<OperationAdd<Value_t>>(impl_, std::move(other.impl_)));
+}
+
+template <typename Value_t>
+Expression<Value_t> Expression<Value_t>::operator+(Expression<Value_t> other) && {
+    return Expression<Value_t>(std::make_shared<OperationAdd<Value_t>>(std::move(impl_), std::move(other.impl_)));
 }
 
 template <typename Value_t>
-Expression<Value_t> &Expression<Value_t>::operator+=(const Expression<Value_t> &other) {
-    *this = *this + other;
+Expression<Value_t> &Expression<Value_t>::operator+=(Expression<Value_t> other) {
+    impl_ = std::make_shared<OperationAdd<Value_t>>(std::move(impl_), std::move(other.impl_));
 
     return *this;
 }
 
 template <typename Value_t>
-Expression<Value_t> Expression<Value_t>::operator-(const Expression<Value_t> &other) {
-    return Expression<Value_t>(std::make_shared<OperationSub<Value_t>>(impl_, other.impl_));
+Expression<Value_t> Expression<Value_t>::operator-(Expression<Value_t> other) const & {
+    return Expression<Value_t>(std::make_shared<OperationSub<Value_t>>(impl_, std::move(other.impl_)));
+}
+
+template <typename Value_t>
+Expression<Value_t> Expression<Value_t>::operator-(Expression<Value_t> other) && {
+    return Expression<Value_t>(std::make_shared<OperationSub<Value_t>>(std::move(impl_), std::move(other.impl_)));
 }
 
 template <typename Value_t>
-Expression<Value_t> &Expression<Value_t>::operator-=(const Expression<Value_t> &other) {
-    *this = *this - other;
+Expression<Value_t> &Expression<Value_t>::operator-=(Expression<Value_t> other) {
+    impl_ = std::make_shared<OperationSub<Value_t>>(std::move(impl_), std::move(other.impl_));
 
     return *this;
 }
 
 template <typename Value_t>
-Expression<Value_t> Expression<Value_t>::operator*(const Expression<Value_t> &other) {
-    return Expression<Value_t>(std::make_shared<OperationMul<Value_t>>(impl_, other.impl_));
+Expression<Value_t> Expression<Value_t>::operator*(Expression<Value_t> other) const & {
+    return Expression<Value_t>(std::make_shared<OperationMul<Value_t>>(impl_, std::move(other.impl_)));
+}
+
+template <typename Value_t>
+Expression<Value_t> Expression<Value_t>::operator*(Expression<Value_t> other) && {
+    return Expression<Value_t>(std::make_shared<OperationMul<Value_t>>(std::move(impl_), std::move(other.impl_)));
 }
 
 template <typename Value_t>
-Expression<Value_t> &Expression<Value_t>::operator*=(const Expression<Value_t> &other) {
-    *this = *this * other;
+Expression<Value_t> &Expression<Value_t>::operator*=(Expression<Value_t> other) {
+    impl_ = std::make_shared<OperationMul<Value_t>>(std::move(impl_), std::move(other.impl_));
 
     return *this;
 }
 
 template <typename Value_t>
-Expression<Value_t> Expression<Value_t>::operator/(const Expression<Value_t> &other) {
-    return Expression<Value_t>(std::make_shared<OperationDiv<Value_t>>(impl_, other.impl_));
+Expression<Value_t> Expression<Value_t>::operator/(Expression<Value_t> other) const & {
+    return Expression<Value_t>(std::make_shared<OperationDiv<Value_t>>(impl_, std::move(other.impl_)));
 }
 
 template <typename Value_t>
-Expression<Value_t> &Expression<Value_t>::operator/=(const Expression<Value_t> &other) {
-    *this = *this / other;
+Expression<Value_t> Expression<Value_t>::operator/(Expression<Value_t> other) && {
+    return Expression<Value_t>(std::make_shared<OperationDiv<Value_t>>(std::move(impl_), std::move(other.impl_)));
+}
+
+template <typename Value_t>
+Expression<Value_t> &Expression<Value_t>::operator/=(Expression<Value_t> other) {
+    impl_ = std::make_shared<OperationDiv<Value_t>>(std::move(impl_), std::move(other.impl_));
 
     return *this;
 }
 
 template <typename Value_t>
-Expression<Value_t> Expression<Value_t>::operator^(const Expression<Value_t> &other) {
-    return Expression<Value_t>(std::make_shared<OperationPow<Value_t>>(impl_, other.impl_));
+Expression<Value_t> Expression<Value_t>::operator^(Expression<Value_t> other) const & {
+    return Expression<Value_t>(make_power(impl_, std::move(other.impl_)));
+}
+
+template <typename Value_t>
+Expression<Value_t> Expression<Value_t>::operator^(Expression<Value_t> other) && {
+    return Expression<Value_t>(make_power(std::move(impl_), std::move(other.impl_)));
 }
 
 template <typename Value_t>
-Expression<Value_t>& Expression<Value_t>::operator^=(const Expression<Value_t> &other) {
-    *this = *this ^ other;
+Expression<Value_t> &Expression<Value_t>::operator^=(Expression<Value_t> other) {
+    impl_ = make_power(std::move(impl_), std::move(other.impl_));
 
     return *this;
 }
 
 template <typename Value_t>
-Expression<Value_t> Expression<Value_t>::sin() {
+Expression<Value_t> Expression<Value_t>::sin() const & {
     return Expression<Value_t>(std::make_shared<OperationSin<Value_t>>(impl_));
 }
 
 template <typename Value_t>
-Expression<Value_t> Expression<Value_t>::cos() {
+Expression<Value_t> Expression<Value_t>::sin() && {
+    return Expression<Value_t>(std::make_shared<OperationSin<Value_t>>(std::move(impl_)));
+}
+
+template <typename Value_t>
+Expression<Value_t> Expression<Value_t>::cos() const & {
     return Expression<Value_t>(std::make_shared<OperationCos<Value_t>>(impl_));
 }
 
 template <typename Value_t>
-Expression<Value_t> Expression<Value_t>::ln() {
+Expression<Value_t> Expression<Value_t>::cos() && {
+    return Expression<Value_t>(std::make_shared<OperationCos<Value_t>>(std::move(impl_)));
+}
+
+template <typename Value_t>
+Expression<Value_t> Expression<Value_t>::ln() const & {
     return Expression<Value_t>(std::make_shared<OperationLn<Value_t>>(impl_));
 }
 
 template <typename Value_t>
-Expression<Value_t> Expression<Value_t>::exp() {
+Expression<Value_t> Expression<Value_t>::ln() && {
+    return Expression<Value_t>(std::make_shared<OperationLn<Value_t>>(std::move(impl_)));
+}
+
+template <typename Value_t>
+Expression<Value_t> Expression<Value_t>::exp() const & {
     return Expression<Value_t>(std::make_shared<OperationExp<Value_t>>(impl_));
 }
 
+template <typename Value_t>
+Expression<Value_t> Expression<Value_t>::exp() && {
+    return Expression<Value_t>(std::make_shared<OperationExp<Value_t>>(std::move(impl_)));
+}
+
+namespace {
+
+// Попарное свёртывание соседних операндов до одного: каждый проход вдвое сокращает набор.
+template <typename Value_t, typename Combine>
+Expression<Value_t> balanced(std::vector<Expression<Value_t>> operands, Value_t empty, Combine combine) {
+    if (operands.empty()) {
+        return Expression<Value_t>(empty);
+    }
+
+    for (size_t count = operands.size(); count > 1; count = (count + 1) / 2) {
+        for (size_t i = 0; i < count / 2; i++) {
+            operands[i] = combine(std::move(operands[2 * i]), std::move(operands[2 * i + 1]));
+        }
+        if (count % 2 == 1) {
+            operands[count / 2] = std::move(operands[count - 1]);
+        }
+    }
+
+    return std::move(operands[0]);
+}
+
+} // namespace
+
+template <typename Value_t>
+Expression<Value_t> Expression<Value_t>::sum(std::vector<Expression<Value_t>> terms) {
+    return balanced(std::move(terms), Value_t(0.0), [](Expression<Value_t> &&left, Expression<Value_t> &&right) {
+        return std::move(left) + std::move(right);
+    });
+}
+
+template <typename Value_t>
+Expression<Value_t> Expression<Value_t>::product(std::vector<Expression<Value_t>> factors) {
+    return balanced(std::move(factors), Value_t(1.0), [](Expression<Value_t> &&left, Expression<Value_t> &&right) {
+        return std::move(left) * std::move(right);
+    });
+}
+
+template <typename Value_t>
+Expression<Value_t> operator+(Value_t left, Expression<Value_t> right) {
+    return Expression<Value_t>(left) + std::move(right);
+}
+
+template <typename Value_t>
+Expression<Value_t> operator-(Value_t left, Expression<Value_t> right) {
+    return Expression<Value_t>(left) - std::move(right);
+}
+
+template <typename Value_t>
+Expression<Value_t> operator*(Value_t left, Expression<Value_t> right) {
+    return Expression<Value_t>(left) * std::move(right);
+}
+
+template <typename Value_t>
+Expression<Value_t> operator/(Value_t left, Expression<Value_t> right) {
+    return Expression<Value_t>(left) / std::move(right);
+}
+
+template <typename Value_t>
+Expression<Value_t> operator^(Value_t left, Expression<Value_t> right) {
+    return Expression<Value_t>(left) ^ std::move(right);
+}
+
+template Expression<long double> operator+(long double left, Expression<long double> right);
+template Expression<std::complex<long double>> operator+(std::complex<long double> left, Expression<std::complex<long double>> right);
+template Expression<long double> operator-(long double left, Expression<long double> right);
+template Expression<std::complex<long double>> operator-(std::complex<long double> left, Expression<std::complex<long double>> right);
+template Expression<long double> operator*(long double left, Expression<long double> right);
+template Expression<std::complex<long double>> operator*(std::complex<long double> left, Expression<std::complex<long double>> right);
+template Expression<long double> operator/(long double left, Expression<long double> right);
+template Expression<std::complex<long double>> operator/(std::complex<long double> left, Expression<std::complex<long double>> right);
+template Expression<long double> operator^(long double left, Expression<long double> right);
+template Expression<std::complex<long double>> operator^(std::complex<long double> left, Expression<std::complex<long double>> right);
+
+template <typename Value_t>
+const uint32_t Expression<Value_t>::MAX_RECURSION_DEPTH;
+
+namespace {
+
+// Обход снизу вверх с явным стеком: результат узла строится combine по результатам операндов.
+// leaf записывает результат узла, операнды которого обходить не нужно, и возвращает true.
+// Запоминаются только узлы с несколькими владельцами: остальные встречаются при обходе один раз.
+template <typename Value_t, typename Result, typename Leaf, typename Combine>
+Result bottom_up(const std::shared_ptr<ExpressionImpl<Value_t>> &root, Leaf leaf, Combine combine) {
+    struct Frame {
+        const std::shared_ptr<ExpressionImpl<Value_t>> *node;
+        size_t next;
+        Result operands[2];
+    };
+
+    std::unordered_map<const ExpressionImpl<Value_t>*, Result> shared;
+    std::vector<Frame> stack;
+    Result result{};
+
+    // Результат для листа или известного общего узла; иначе узел кладётся на стек.
+    auto visit = [&](const std::shared_ptr<ExpressionImpl<Value_t>> &node) {
+        if (node.use_count() > 1) {
+            auto iter = shared.find(node.get());
+            if (iter != shared.end()) {
+                result = iter->second;
+                return true;
+            }
+        }
+
+        if (leaf(node, result)) return true;
+
+        stack.push_back(Frame{&node, 0, {}});
+        return false;
+    };
+
+    bool ready = visit(root);
+    while (!stack.empty()) {
+        Frame &frame = stack.back();
+        const ExpressionImpl<Value_t> &node = **frame.node;
+
+        if (ready) {
+            frame.operands[frame.next++] = std::move(result);
+        }
+        if (frame.next < node.arity()) {
+            ready = visit(node.operand(frame.next));
+            continue;
+        }
+
+        result = combine(node, std::span<const Result>(frame.operands, node.arity()));
+        if (frame.node->use_count() > 1) {
+            shared.emplace(&node, result);
+        }
+
+        stack.pop_back();
+        ready = true;
+    }
+
+    return result;
+}
+
+} // namespace
+
+// Неглубокие выражения и поддеревья обрабатываются рекурсивными методами узлов,
+// более глубокие - обходом bottom_up.
 template <typename Value_t>
 Value_t Expression<Value_t>::eval(std::map<std::string, Value_t> &context) const {
-    return impl_->eval(context);
+    if (impl_->height() <= MAX_RECURSION_DEPTH) return impl_->eval(context);
+
+    return bottom_up<Value_t, Value_t>(impl_,
+        [&](const std::shared_ptr<ExpressionImpl<Value_t>> &node, Value_t &result) {
+            if (node->height() > MAX_RECURSION_DEPTH) return false;
+            result = node->eval(context);
+            return true;
+        },
+        [&](const ExpressionImpl<Value_t> &node, std::span<const Value_t> operands) {
+            return node.eval_with(context, operands);
+        }
+    );
 }
 
 template <typename Value_t>
-Expression<Value_t> Expression<Value_t>::diff(const std::string &by) const {
-    return Expression<Value_t>(impl_->diff(by));
+Expression<Value_t> Expression<Value_t>::diff(const std::string &name) const {
+    // Имя ищется в таблице один раз, дальше узлы сравнивают номера.
+    uint32_t by;
+    if (!find_symbol(name, by)) return Expression<Value_t>(ExpressionImpl<Value_t>::zero());
+
+    Dependencies<Value_t> dependencies = find_dependencies(impl_.get(), by);
+    DependencyScope<Value_t> scope(dependencies);
+
+    if (impl_->height() <= MAX_RECURSION_DEPTH) return Expression<Value_t>(impl_->diff(by));
+
+    return Expression<Value_t>(bottom_up<Value_t, std::shared_ptr<ExpressionImpl<Value_t>>>(impl_,
+        [&](const std::shared_ptr<ExpressionImpl<Value_t>> &node, std::shared_ptr<ExpressionImpl<Value_t>> &result) {
+            if (!node->depends_on(by)) {
+                result = ExpressionImpl<Value_t>::zero();
+                return true;
+            }
+            if (node->height() > MAX_RECURSION_DEPTH) return false;
+            result = node->diff(by);
+            return true;
+        },
+        [&](const ExpressionImpl<Value_t> &node, OperandResults<Value_t> diffs) {
+            return node.diff_with(by, diffs);
+        }
+    ));
 }
 
 template <typename Value_t>
 Expression<Value_t> Expression<Value_t>::substitute(std::map<std::string, Value_t> &context) const {
-    return Expression<Value_t>(impl_->substitute(context));
+    if (impl_->height() <= MAX_RECURSION_DEPTH) return Expression<Value_t>(impl_->substitute(context));
+
+    return Expression<Value_t>(bottom_up<Value_t, std::shared_ptr<ExpressionImpl<Value_t>>>(impl_,
+        [&](const std::shared_ptr<ExpressionImpl<Value_t>> &node, std::shared_ptr<ExpressionImpl<Value_t>> &result) {
+            if (node->height() > MAX_RECURSION_DEPTH) return false;
+            result = node->substitute(context);
+            return true;
+        },
+        [&](const ExpressionImpl<Value_t> &node, OperandResults<Value_t> operands) {
+            return node.substitute_with(context, operands);
+        }
+    ));
+}
+
+template <typename Value_t>
+Expression<Value_t> Expression<Value_t>::specialize(std::map<std::string, Value_t> &context) const {
+    // Узел упрощается по уже специализированным операндам.
+    return Expression<Value_t>(bottom_up<Value_t, std::shared_ptr<ExpressionImpl<Value_t>>>(impl_,
+        [&](const std::shared_ptr<ExpressionImpl<Value_t>> &node, std::shared_ptr<ExpressionImpl<Value_t>> &result) {
+            if (node->type() == NODE_VARIABLE) {
+                auto iter = context.find(static_cast<const Variable<Value_t>*>(node.get())->name());
+                result = iter != context.end() ? std::make_shared<Value<Value_t>>(iter->second) : node;
+                return true;
+            }
+            if (node->arity() == 0) {
+                result = node;
+                return true;
+            }
+            return false;
+        },
+        [](const ExpressionImpl<Value_t> &node, OperandResults<Value_t> operands) {
+            return node.prettify_with(operands);
+        }
+    ));
 }
 
 template <typename Value_t>
 Expression<Value_t> Expression<Value_t>::prettify() const {
-    return Expression<Value_t>(impl_->prettify());
+    if (impl_->height() <= MAX_RECURSION_DEPTH) return Expression<Value_t>(impl_->prettify());
+
+    return Expression<Value_t>(bottom_up<Value_t, std::shared_ptr<ExpressionImpl<Value_t>>>(impl_,
+        [](const std::shared_ptr<ExpressionImpl<Value_t>> &node, std::shared_ptr<ExpressionImpl<Value_t>> &result) {
+            if (node->height() > MAX_RECURSION_DEPTH) return false;
+            result = node->prettify();
+            return true;
+        },
+        [](const ExpressionImpl<Value_t> &node, OperandResults<Value_t> operands) {
+            return node.prettify_with(operands);
+        }
+    ));
 }
 
 template <typename Value_t>
 std::string Expression<Value_t>::to_string() const {
-    return impl_->to_string();
+    // Запись с явным стеком в одну строку: время линейно по размеру записи при любой глубине.
+    std::string result;
+    std::vector<std::pair<const ExpressionImpl<Value_t>*, size_t>> stack{{impl_.get(), 0}};
+
+    while (!stack.empty()) {
+        auto &[node, position] = stack.back();
+        node->write(result, position);
+
+        if (position == node->arity()) {
+            stack.pop_back();
+            continue;
+        }
+
+        const ExpressionImpl<Value_t> *operand = node->operand(position++).get();
+        stack.emplace_back(operand, 0);
+    }
+
+    return result;
+}
+
+template <typename Value_t>
+const std::shared_ptr<ExpressionImpl<Value_t>> &Expression<Value_t>::impl() const {
+    return impl_;
+}
+
+template <typename Value_t>
+std::vector<Expression<Value_t>> Expression<Value_t>::diff_all(const std::vector<std::string> &vars) const {
+    if (vars.empty()) return {};
+
+    ThreadPool pool(std::min<size_t>(vars.size(), std::thread::hardware_concurrency()));
+
+    return diff_all(vars, pool);
+}
+
+template <typename Value_t>
+std::vector<Expression<Value_t>> Expression<Value_t>::diff_all(const std::vector<std::string> &vars,
+                                                               ThreadPool &pool) const {
+    // Узлы выражения не изменяются после создания, поэтому дерево безопасно обходить из разных потоков.
+    std::vector<std::shared_ptr<ExpressionImpl<Value_t>>> results(vars.size());
+
+    pool.parallel_for(vars.size(), [&](size_t i) {
+        results[i] = diff(vars[i]).prettify().impl();
+    });
+
+    return std::vector<Expression<Value_t>>(results.begin(), results.end());
+}
+
+template <typename Value_t>
+std::vector<Value_t> Expression<Value_t>::taylor(const std::string &by, std::map<std::string, Value_t> &context,
+                                                 size_t order) const {
+    return Tape<Value_t>(*this).taylor(by, context, order);
+}
+
+// Размеры деревьев всех различных узлов с учётом повторов общих подвыражений.
+// Узлы обходятся в обратном порядке с явным стеком; visit(node) вызывается один раз
+// для каждого различного узла после его операндов.
+template <typename Value_t, typename Visit>
+static std::unordered_map<const ExpressionImpl<Value_t>*, uint64_t> tree_sizes(const ExpressionImpl<Value_t> *root,
+                                                                              Visit visit) {
+    std::unordered_map<const ExpressionImpl<Value_t>*, uint64_t> sizes;
+    std::vector<const ExpressionImpl<Value_t>*> stack{root};
+
+    while (!stack.empty()) {
+        const ExpressionImpl<Value_t> *node = stack.back();
+        if (sizes.contains(node)) {
+            stack.pop_back();
+            continue;
+        }
+
+        bool ready = true;
+        for (size_t i = 0; i < node->arity(); i++) {
+            if (!sizes.contains(node->operand(i).get())) {
+                stack.push_back(node->operand(i).get());
+                ready = false;
+            }
+        }
+        if (!ready) continue;
+
+        stack.pop_back();
+        visit(node);
+
+        uint64_t size = 1;
+        for (size_t i = 0; i < node->arity(); i++) {
+            uint64_t operandSize = sizes.at(node->operand(i).get());
+            // Размер дерева с общими подвыражениями может превысить 2^64.
+            size = operandSize > UINT64_MAX - size ? UINT64_MAX : size + operandSize;
+        }
+        sizes.emplace(node, size);
+    }
+
+    return sizes;
+}
+
+template <typename Value_t>
+static std::unordered_map<const ExpressionImpl<Value_t>*, uint64_t> tree_sizes(const ExpressionImpl<Value_t> *root) {
+    return tree_sizes(root, [](const ExpressionImpl<Value_t>*) {});
+}
+
+// Преобразование дерева снизу вверх: операнды крупных узлов обрабатываются параллельно,
+// затем узел собирается из их результатов. Небольшие поддеревья и узлы, для которых
+// whole(node) истинно, передаются serial целиком.
+template <typename Value_t, typename Whole, typename Serial, typename Combine>
+static std::shared_ptr<ExpressionImpl<Value_t>> fork_join_transform(const std::shared_ptr<ExpressionImpl<Value_t>> &root,
+                                                                    ForkJoinPool &pool, uint64_t grain,
+                                                                    Whole whole, Serial serial, Combine combine) {
+    // Узлы выражения не изменяются после создания, а таблица размеров только читается.
+    std::unordered_map<const ExpressionImpl<Value_t>*, uint64_t> sizes = tree_sizes(root.get());
+
+    std::function<std::shared_ptr<ExpressionImpl<Value_t>>(const std::shared_ptr<ExpressionImpl<Value_t>>&)> transform;
+    transform = [&](const std::shared_ptr<ExpressionImpl<Value_t>> &node) {
+        if (node->arity() == 0 || sizes.at(node.get()) <= grain || whole(node)) return serial(node);
+
+        std::shared_ptr<ExpressionImpl<Value_t>> results[2];
+        if (node->arity() == 2) {
+            pool.fork_join([&] { results[0] = transform(node->operand(0)); },
+                           [&] { results[1] = transform(node->operand(1)); });
+        }
+        else {
+            results[0] = transform(node->operand(0));
+        }
+
+        return combine(node, OperandResults<Value_t>(results, node->arity()));
+    };
+
+    std::shared_ptr<ExpressionImpl<Value_t>> result;
+    pool.run([&] { result = transform(root); });
+
+    return result;
+}
+
+template <typename Value_t>
+Expression<Value_t> Expression<Value_t>::diff(const std::string &name, ForkJoinPool &pool, uint64_t grain) const {
+    // Разбиение по поддеревьям рекурсивно, поэтому глубокие выражения обрабатываются последовательно.
+    if (impl_->height() > MAX_RECURSION_DEPTH) return diff(name);
+
+    uint32_t by;
+    if (!find_symbol(name, by)) return Expression<Value_t>(ExpressionImpl<Value_t>::zero());
+
+    // Таблица ответов depends_on общая для всех потоков и подключается в каждом из них.
+    Dependencies<Value_t> dependencies = find_dependencies(impl_.get(), by);
+
+    return Expression<Value_t>(fork_join_transform(impl_, pool, grain,
+        [&](const std::shared_ptr<ExpressionImpl<Value_t>> &node) {
+            DependencyScope<Value_t> scope(dependencies);
+            return !node->depends_on(by);
+        },
+        [&](const std::shared_ptr<ExpressionImpl<Value_t>> &node) {
+            DependencyScope<Value_t> scope(dependencies);
+            return node->diff(by);
+        },
+        [by](const std::shared_ptr<ExpressionImpl<Value_t>> &node, OperandResults<Value_t> diffs) {
+            return node->diff_with(by, diffs);
+        }
+    ));
+}
+
+template <typename Value_t>
+Expression<Value_t> Expression<Value_t>::prettify(ForkJoinPool &pool, uint64_t grain) const {
+    if (impl_->height() > MAX_RECURSION_DEPTH) return prettify();
+
+    return Expression<Value_t>(fork_join_transform(impl_, pool, grain,
+        [](const std::shared_ptr<ExpressionImpl<Value_t>> &) {
+            return false;
+        },
+        [](const std::shared_ptr<ExpressionImpl<Value_t>> &node) {
+            return node->prettify();
+        },
+        [](const std::shared_ptr<ExpressionImpl<Value_t>> &node, OperandResults<Value_t> operands) {
+            return node->prettify_with(operands);
+        }
+    ));
+}
+
+// Размер узла в памяти вместе с блоком управления make_shared (таблица виртуальных функций и два счётчика).
+template <typename Value_t>
+static uint64_t node_footprint(const ExpressionImpl<Value_t> *node) {
+    const uint64_t overhead = sizeof(void*) + 2 * sizeof(int);
+
+    switch (node->type()) {
+        case NODE_VALUE:
+            return overhead + sizeof(Value<Value_t>);
+        // Имя переменной хранится один раз в общей таблице и в размер узла не входит.
+        case NODE_VARIABLE: return overhead + sizeof(Variable<Value_t>);
+        case NODE_ADD: return overhead + sizeof(OperationAdd<Value_t>);
+        case NODE_SUB: return overhead + sizeof(OperationSub<Value_t>);
+        case NODE_MUL: return overhead + sizeof(OperationMul<Value_t>);
+        case NODE_DIV: return overhead + sizeof(OperationDiv<Value_t>);
+        case NODE_POW:
+            if (dynamic_cast<const OperationPowConst<Value_t>*>(node)) return overhead + sizeof(OperationPowConst<Value_t>);
+            return overhead + sizeof(OperationPow<Value_t>);
+        case NODE_SIN: return overhead + sizeof(OperationSin<Value_t>);
+        case NODE_COS: return overhead + sizeof(OperationCos<Value_t>);
+        case NODE_LN:  return overhead + sizeof(OperationLn<Value_t>);
+        case NODE_EXP: return overhead + sizeof(OperationExp<Value_t>);
+    }
+    return 0;
+}
+
+// Обход различных узлов выражения с явным стеком: общие подвыражения посещаются один раз.
+// Операнды узла обходятся, если visit(node) вернула true.
+template <typename Value_t, typename Visit>
+static void for_each_unique(const ExpressionImpl<Value_t> *root, Visit visit) {
+    std::unordered_set<const ExpressionImpl<Value_t>*> visited{root};
+    std::vector<const ExpressionImpl<Value_t>*> stack{root};
+
+    while (!stack.empty()) {
+        const ExpressionImpl<Value_t> *node = stack.back();
+        stack.pop_back();
+
+        if (!visit(node)) continue;
+
+        for (size_t i = 0; i < node->arity(); i++) {
+            if (visited.insert(node->operand(i).get()).second) {
+                stack.push_back(node->operand(i).get());
+            }
+        }
+    }
+}
+
+template <typename Value_t>
+ExpressionMetrics Expression<Value_t>::metrics() const {
+    // Все метрики, кроме глубины, собираются за один проход; глубина хранится в узле.
+    ExpressionMetrics result{0, 0, impl_->height(), {}, {}, 0};
+
+    result.nodes = tree_sizes(impl_.get(), [&](const ExpressionImpl<Value_t> *node) {
+        result.uniqueNodes++;
+        result.histogram[node->type()]++;
+        result.bytes += node_footprint(node);
+        if (node->type() == NODE_VARIABLE) {
+            result.freeVariables.insert(static_cast<const Variable<Value_t>*>(node)->name());
+        }
+    }).at(impl_.get());
+
+    return result;
+}
+
+// Отдельные метрики считают только своё значение.
+template <typename Value_t>
+uint64_t Expression<Value_t>::node_count() const {
+    return tree_sizes(impl_.get()).at(impl_.get());
+}
+
+template <typename Value_t>
+uint64_t Expression<Value_t>::unique_node_count() const {
+    uint64_t count = 0;
+    for_each_unique(impl_.get(), [&](const ExpressionImpl<Value_t>*) {
+        count++;
+        return true;
+    });
+    return count;
+}
+
+template <typename Value_t>
+uint64_t Expression<Value_t>::depth() const {
+    return impl_->height();
+}
+
+template <typename Value_t>
+std::set<std::string> Expression<Value_t>::free_variables() const {
+    // Поддеревья без переменных (пустое множество переменных узла) пропускаются.
+    std::set<std::string> result;
+    for_each_unique(impl_.get(), [&](const ExpressionImpl<Value_t> *node) {
+        if (node->type() == NODE_VARIABLE) {
+            result.insert(static_cast<const Variable<Value_t>*>(node)->name());
+        }
+        return !node->variables().empty();
+    });
+    return result;
+}
+
+template <typename Value_t>
+std::map<NodeType, uint64_t> Expression<Value_t>::histogram() const {
+    std::map<NodeType, uint64_t> result;
+    for_each_unique(impl_.get(), [&](const ExpressionImpl<Value_t> *node) {
+        result[node->type()]++;
+        return true;
+    });
+    return result;
+}
+
+template <typename Value_t>
+uint64_t Expression<Value_t>::byte_footprint() const {
+    uint64_t bytes = 0;
+    for_each_unique(impl_.get(), [&](const ExpressionImpl<Value_t> *node) {
+        bytes += node_footprint(node);
+        return true;
+    });
+    return bytes;
 }
 
 // Определения дружественных функций.
@@ -150,6 +800,97 @@ template Expression<std::complex<long double>> m_var(const char*);
 template class Expression<long double>;
 template class Expression<std::complex<long double>>;
 
+//======================//
+// Класс ExpressionImpl //
+//======================//
+
+template <typename Value_t>
+ExpressionImpl<Value_t>::ExpressionImpl(VariableSet variables, uint32_t height) :
+    variables_ (std::move(variables)),
+    height_    (height)
+{}
+
+template <typename Value_t>
+uint32_t ExpressionImpl<Value_t>::height() const {
+    return height_;
+}
+
+template <typename Value_t>
+void ExpressionImpl<Value_t>::release(std::shared_ptr<ExpressionImpl<Value_t>> &operand) {
+    // Список отложенных операндов освобождаемого в этом потоке выражения.
+    thread_local std::vector<std::shared_ptr<ExpressionImpl<Value_t>>> *pending = nullptr;
+
+    // Листья и общие узлы освобождаются сразу: это не вызывает деструкторов операндов.
+    if (operand.use_count() != 1 || operand->arity() == 0) return;
+
+    if (pending != nullptr) {
+        pending->push_back(std::move(operand));
+        return;
+    }
+
+    std::vector<std::shared_ptr<ExpressionImpl<Value_t>>> list;
+    list.push_back(std::move(operand));
+    pending = &list;
+
+    while (!list.empty()) {
+        std::shared_ptr<ExpressionImpl<Value_t>> node = std::move(list.back());
+        list.pop_back();
+        // Деструктор узла добавляет в список его операнды.
+        node.reset();
+    }
+
+    pending = nullptr;
+}
+
+template <typename Value_t>
+const VariableSet &ExpressionImpl<Value_t>::variables() const {
+    return variables_;
+}
+
+template <typename Value_t>
+bool ExpressionImpl<Value_t>::depends_on(const std::string &name) const {
+    uint32_t id;
+    return find_symbol(name, id) && depends_on(id);
+}
+
+template <typename Value_t>
+bool ExpressionImpl<Value_t>::depends_on(uint32_t id) const {
+    if (!variables_.may_contain(id)) return false;
+    if (id < VariableSet::EXACT_IDS) return true;
+    if (type() == NODE_VARIABLE) return static_cast<const Variable<Value_t>*>(this)->id() == id;
+
+    // Внутри diff ответ берётся из таблицы вызова, иначе поддерево обходится заново.
+    const Dependencies<Value_t> *dependencies = current_dependencies<Value_t>();
+    if (dependencies != nullptr && dependencies->id == id) {
+        auto iter = dependencies->found.find(this);
+        if (iter != dependencies->found.end()) return iter->second;
+    }
+
+    return find_dependencies(this, id).found.at(this);
+}
+
+template <typename Value_t>
+std::shared_ptr<ExpressionImpl<Value_t>> ExpressionImpl<Value_t>::diff(const std::string &by) const {
+    // Имени, которого нет в таблице, нет ни в одном выражении.
+    uint32_t id;
+    if (!find_symbol(by, id)) return zero();
+
+    Dependencies<Value_t> dependencies = find_dependencies(this, id);
+    DependencyScope<Value_t> scope(dependencies);
+
+    return diff(id);
+}
+
+template <typename Value_t>
+const std::shared_ptr<ExpressionImpl<Value_t>> &ExpressionImpl<Value_t>::zero() {
+    // Общий нулевой узел производных независимых подвыражений.
+    static const std::shared_ptr<ExpressionImpl<Value_t>> node = std::make_shared<Value<Value_t>>(Value_t(0.0));
+    return node;
+}
+
+template class ExpressionImpl<long double>;
+template class ExpressionImpl<std::complex<long double>>;
+
 //=============//
 // Класс Value //
 //=============//
@@ -169,10 +910,18 @@ Value_t Value<Value_t>::eval(std::map<std::string, Value_t> &context) const {
 }
 
 template <typename Value_t>
-std::shared_ptr<ExpressionImpl<Value_t>> Value<Value_t>::diff(const std::string &by) const {
+std::shared_ptr<ExpressionImpl<Value_t>> Value<Value_t>::diff(uint32_t by) const {
     (void) by;
 
-    return std::make_shared<Value<Value_t>>(Value(0.0));
+    return ExpressionImpl<Value_t>::zero();
+}
+
+template <typename Value_t>
+std::shared_ptr<ExpressionImpl<Value_t>> Value<Value_t>::diff_with(uint32_t by,
+                                                                   OperandResults<Value_t> diffs) const {
+    (void) diffs;
+
+    return diff(by);
 }
 
 template <typename Value_t>
@@ -187,6 +936,13 @@ std::shared_ptr<ExpressionImpl<Value_t>> Value<Value_t>::prettify() const {
     return std::make_shared<Value<Value_t>>(value_);
 }
 
+template <typename Value_t>
+std::shared_ptr<ExpressionImpl<Value_t>> Value<Value_t>::prettify_with(OperandResults<Value_t> operands) const {
+    (void) operands;
+
+    return prettify();
+}
+
 template <typename Value_t>
 std::string Value<Value_t>::to_string() const {
     return std::to_string(value_);
@@ -197,6 +953,48 @@ std::string Value<std::complex<long double>>::to_string() const {
     return "(" + std::to_string(value_.real()) + " + " + std::to_string(value_.imag()) + "i)";
 }
 
+template <typename Value_t>
+Value_t Value<Value_t>::eval_with(std::map<std::string, Value_t> &context, std::span<const Value_t> operands) const {
+    (void) operands;
+
+    return eval(context);
+}
+
+template <typename Value_t>
+std::shared_ptr<ExpressionImpl<Value_t>> Value<Value_t>::substitute_with(std::map<std::string, Value_t> &context,
+                                                                         OperandResults<Value_t> operands) const {
+    (void) operands;
+
+    return substitute(context);
+}
+
+template <typename Value_t>
+void Value<Value_t>::write(std::string &out, size_t position) const {
+    (void) position;
+
+    out += to_string();
+}
+
+template <typename Value_t>
+NodeType Value<Value_t>::type() const {
+    return NODE_VALUE;
+}
+
+template <typename Value_t>
+size_t Value<Value_t>::arity() const {
+    return 0;
+}
+
+template <typename Value_t>
+const std::shared_ptr<ExpressionImpl<Value_t>> &Value<Value_t>::operand(size_t index) const {
+    throw std::out_of_range("Operand " + std::to_string(index) + " requested from a leaf expression");
+}
+
+template <typename Value_t>
+Value_t Value<Value_t>::value() const {
+    return value_;
+}
+
 template class Value<long double>;
 template class Value<std::complex<long double>>;
 
@@ -206,92 +1004,191 @@ template class Value<std::complex<long double>>;
 
 template <typename Value_t>
 Variable<Value_t>::Variable(const std::string &name) :
-    name_ (name)
+    Variable(intern_symbol(name))
+{}
+
+template <typename Value_t>
+Variable<Value_t>::Variable(uint32_t id) :
+    ExpressionImpl<Value_t>(VariableSet(id)),
+    id_   (id),
+    name_ (&symbol_name(id))
 {}
 
 // Реализация интерфейса ExpressionImpl.
 template <typename Value_t>
 Value_t Variable<Value_t>::eval(std::map<std::string, Value_t> &context) const {
-    auto iter = context.find(name_);
+    auto iter = context.find(*name_);
 
     if (iter == context.end()) {
-        throw std::runtime_error("Variable \"" + name_ + "\" not present in evaluation context");
+        throw std::runtime_error("Variable \"" + *name_ + "\" not present in evaluation context");
     }
 
     return iter->second;
 }
 
 template <typename Value_t>
-std::shared_ptr<ExpressionImpl<Value_t>> Variable<Value_t>::diff(const std::string &by) const {
-    if (by == name_) {
+std::shared_ptr<ExpressionImpl<Value_t>> Variable<Value_t>::diff(uint32_t by) const {
+    if (by == id_) {
         return std::make_shared<Value<Value_t>>(Value<Value_t>(1.0));
     }
-    return std::make_shared<Value<Value_t>>(Value<Value_t>(0.0));
+    return ExpressionImpl<Value_t>::zero();
+}
+
+template <typename Value_t>
+std::shared_ptr<ExpressionImpl<Value_t>> Variable<Value_t>::diff_with(uint32_t by,
+                                                                      OperandResults<Value_t> diffs) const {
+    (void) diffs;
+
+    return diff(by);
 }
 
 template <typename Value_t>
 std::shared_ptr<ExpressionImpl<Value_t>> Variable<Value_t>::substitute(std::map<std::string, Value_t> &context) const {
 
-    auto iter = context.find(name_);
+    auto iter = context.find(*name_);
 
     if (iter != context.end()) {
         return std::make_shared<Value<Value_t>>(Value<Value_t>(iter->second));
     }
 
-    return std::make_shared<Variable<Value_t>>(Variable<Value_t>(name_));
+    return std::make_shared<Variable<Value_t>>(*this);
 }
 
 template <typename Value_t>
 std::shared_ptr<ExpressionImpl<Value_t>> Variable<Value_t>::prettify() const {
-    return std::make_shared<Variable<Value_t>>(name_);
+    return std::make_shared<Variable<Value_t>>(*this);
+}
+
+template <typename Value_t>
+std::shared_ptr<ExpressionImpl<Value_t>> Variable<Value_t>::prettify_with(OperandResults<Value_t> operands) const {
+    (void) operands;
+
+    return prettify();
 }
 
 template <typename Value_t>
 std::string Variable<Value_t>::to_string() const {
-    return name_;
+    return *name_;
 }
 
-template class Variable<long double>;
-template class Variable<std::complex<long double>>;
+template <typename Value_t>
+Value_t Variable<Value_t>::eval_with(std::map<std::string, Value_t> &context, std::span<const Value_t> operands) const {
+    (void) operands;
 
-//====================//
-// Класс OperationAdd //
-//====================//
+    return eval(context);
+}
 
 template <typename Value_t>
-OperationAdd<Value_t>::OperationAdd(const std::shared_ptr<ExpressionImpl<Value_t>> &left,
-                                    const std::shared_ptr<ExpressionImpl<Value_t>> &right) :
-    left_  (left),
-    right_ (right)
-{}
+std::shared_ptr<ExpressionImpl<Value_t>> Variable<Value_t>::substitute_with(std::map<std::string, Value_t> &context,
+                                                                            OperandResults<Value_t> operands) const {
+    (void) operands;
+
+    return substitute(context);
+}
 
 template <typename Value_t>
-Value_t OperationAdd<Value_t>::eval(std::map<std::string, Value_t> &context) const {
-    Value_t value_left  = left_->eval(context);
-    Value_t value_right = right_->eval(context);
+void Variable<Value_t>::write(std::string &out, size_t position) const {
+    (void) position;
 
-    return value_left + value_right;
+    out += to_string();
 }
 
 template <typename Value_t>
-std::shared_ptr<ExpressionImpl<Value_t>> OperationAdd<Value_t>::diff(const std::string &by) const {
-    return std::make_shared<OperationAdd<Value_t>>(left_->diff(by), right_->diff(by));
+NodeType Variable<Value_t>::type() const {
+    return NODE_VARIABLE;
 }
 
 template <typename Value_t>
-std::shared_ptr<ExpressionImpl<Value_t>> OperationAdd<Value_t>::substitute(std::map<std::string, Value_t> &context) const {
-    return std::make_shared<OperationAdd<Value_t>> (
-        left_->substitute(context), right_->substitute(context)
-    );
+size_t Variable<Value_t>::arity() const {
+    return 0;
 }
 
 template <typename Value_t>
-std::shared_ptr<ExpressionImpl<Value_t>> OperationAdd<Value_t>::prettify() const {
-    auto new_left  = left_->prettify();
-    auto new_right = right_->prettify();
+const std::shared_ptr<ExpressionImpl<Value_t>> &Variable<Value_t>::operand(size_t index) const {
+    throw std::out_of_range("Operand " + std::to_string(index) + " requested from a leaf expression");
+}
 
-    if (is_zero(new_left)) return new_right;
-    if (is_zero(new_right)) return new_left;
+template <typename Value_t>
+const std::string &Variable<Value_t>::name() const {
+    return *name_;
+}
+
+template <typename Value_t>
+uint32_t Variable<Value_t>::id() const {
+    return id_;
+}
+
+template class Variable<long double>;
+template class Variable<std::complex<long double>>;
+
+//====================//
+// Класс OperationAdd //
+//====================//
+
+template <typename Value_t>
+OperationAdd<Value_t>::OperationAdd(std::shared_ptr<ExpressionImpl<Value_t>> left,
+                                            std::shared_ptr<ExpressionImpl<Value_t>> right) :
+    ExpressionImpl<Value_t>(left->variables().united(right->variables()), std::max(left->height(), right->height()) + 1),
+    left_  (std::move(left)),
+    right_ (std::move(right))
+{}
+
+template <typename Value_t>
+OperationAdd<Value_t>::~OperationAdd() {
+    ExpressionImpl<Value_t>::release(left_);
+    ExpressionImpl<Value_t>::release(right_);
+}
+
+template <typename Value_t>
+Value_t OperationAdd<Value_t>::eval(std::map<std::string, Value_t> &context) const {
+    Value_t value_left  = left_->eval(context);
+    Value_t value_right = right_->eval(context);
+
+    return value_left + value_right;
+}
+
+template <typename Value_t>
+std::shared_ptr<ExpressionImpl<Value_t>> OperationAdd<Value_t>::diff(uint32_t by) const {
+    // Производная подвыражения, не содержащего переменную, равна нулю.
+    if (!this->depends_on(by)) return ExpressionImpl<Value_t>::zero();
+
+    std::shared_ptr<ExpressionImpl<Value_t>> diffs[] = {left_->diff(by), right_->diff(by)};
+
+    return diff_with(by, diffs);
+}
+
+template <typename Value_t>
+std::shared_ptr<ExpressionImpl<Value_t>> OperationAdd<Value_t>::diff_with(uint32_t by,
+                                                                          OperandResults<Value_t> diffs) const {
+    (void) by;
+
+    if (diffs[0] == ExpressionImpl<Value_t>::zero()) return diffs[1];
+    if (diffs[1] == ExpressionImpl<Value_t>::zero()) return diffs[0];
+
+    return std::make_shared<OperationAdd<Value_t>>(diffs[0], diffs[1]);
+}
+
+template <typename Value_t>
+std::shared_ptr<ExpressionImpl<Value_t>> OperationAdd<Value_t>::substitute(std::map<std::string, Value_t> &context) const {
+    std::shared_ptr<ExpressionImpl<Value_t>> operands[] = {left_->substitute(context), right_->substitute(context)};
+
+    return substitute_with(context, operands);
+}
+
+template <typename Value_t>
+std::shared_ptr<ExpressionImpl<Value_t>> OperationAdd<Value_t>::prettify() const {
+    std::shared_ptr<ExpressionImpl<Value_t>> operands[] = {left_->prettify(), right_->prettify()};
+
+    return prettify_with(operands);
+}
+
+template <typename Value_t>
+std::shared_ptr<ExpressionImpl<Value_t>> OperationAdd<Value_t>::prettify_with(OperandResults<Value_t> operands) const {
+    auto new_left  = operands[0];
+    auto new_right = operands[1];
+
+    if (is_zero(new_left)) return new_right;
+    if (is_zero(new_right)) return new_left;
     if (is_val(new_left) && is_val(new_right)) {
         std::map<std::string, Value_t> emptyContext;
 
@@ -309,6 +1206,43 @@ std::string OperationAdd<Value_t>::to_string() const {
            std::string(")");
 }
 
+template <typename Value_t>
+Value_t OperationAdd<Value_t>::eval_with(std::map<std::string, Value_t> &context, std::span<const Value_t> operands) const {
+    (void) context;
+
+    return operands[0] + operands[1];
+}
+
+template <typename Value_t>
+std::shared_ptr<ExpressionImpl<Value_t>> OperationAdd<Value_t>::substitute_with(std::map<std::string, Value_t> &context,
+                                                                                OperandResults<Value_t> operands) const {
+    (void) context;
+
+    return std::make_shared<OperationAdd<Value_t>>(operands[0], operands[1]);
+}
+
+template <typename Value_t>
+void OperationAdd<Value_t>::write(std::string &out, size_t position) const {
+    static const char *const parts[] = {"(", " + ", ")"};
+
+    out += parts[position];
+}
+
+template <typename Value_t>
+NodeType OperationAdd<Value_t>::type() const {
+    return NODE_ADD;
+}
+
+template <typename Value_t>
+size_t OperationAdd<Value_t>::arity() const {
+    return 2;
+}
+
+template <typename Value_t>
+const std::shared_ptr<ExpressionImpl<Value_t>> &OperationAdd<Value_t>::operand(size_t index) const {
+    return (index == 0) ? left_ : right_;
+}
+
 template class OperationAdd<long double>;
 template class OperationAdd<std::complex<long double>>;
 
@@ -317,12 +1251,19 @@ template class OperationAdd<std::complex<long double>>;
 //====================//
 
 template <typename Value_t>
-OperationSub<Value_t>::OperationSub(const std::shared_ptr<ExpressionImpl<Value_t>> &left,
-                                    const std::shared_ptr<ExpressionImpl<Value_t>> &right) :
-    left_  (left),
-    right_ (right)
+OperationSub<Value_t>::OperationSub(std::shared_ptr<ExpressionImpl<Value_t>> left,
+                                            std::shared_ptr<ExpressionImpl<Value_t>> right) :
+    ExpressionImpl<Value_t>(left->variables().united(right->variables()), std::max(left->height(), right->height()) + 1),
+    left_  (std::move(left)),
+    right_ (std::move(right))
 {}
 
+template <typename Value_t>
+OperationSub<Value_t>::~OperationSub() {
+    ExpressionImpl<Value_t>::release(left_);
+    ExpressionImpl<Value_t>::release(right_);
+}
+
 template <typename Value_t>
 Value_t OperationSub<Value_t>::eval(std::map<std::string, Value_t> &context) const {
     Value_t value_left  = left_->eval(context);
@@ -332,21 +1273,42 @@ Value_t OperationSub<Value_t>::eval(std::map<std::string, Value_t> &context) con
 }
 
 template <typename Value_t>
-std::shared_ptr<ExpressionImpl<Value_t>> OperationSub<Value_t>::diff(const std::string &by) const {
-    return std::make_shared<OperationSub<Value_t>>(left_->diff(by), right_->diff(by));
+std::shared_ptr<ExpressionImpl<Value_t>> OperationSub<Value_t>::diff(uint32_t by) const {
+    if (!this->depends_on(by)) return ExpressionImpl<Value_t>::zero();
+
+    std::shared_ptr<ExpressionImpl<Value_t>> diffs[] = {left_->diff(by), right_->diff(by)};
+
+    return diff_with(by, diffs);
+}
+
+template <typename Value_t>
+std::shared_ptr<ExpressionImpl<Value_t>> OperationSub<Value_t>::diff_with(uint32_t by,
+                                                                          OperandResults<Value_t> diffs) const {
+    (void) by;
+
+    if (diffs[1] == ExpressionImpl<Value_t>::zero()) return diffs[0];
+
+    return std::make_shared<OperationSub<Value_t>>(diffs[0], diffs[1]);
 }
 
 template <typename Value_t>
 std::shared_ptr<ExpressionImpl<Value_t>> OperationSub<Value_t>::substitute(std::map<std::string, Value_t> &context) const {
-    return std::make_shared<OperationSub<Value_t>> (
-        left_->substitute(context), right_->substitute(context)
-    );
+    std::shared_ptr<ExpressionImpl<Value_t>> operands[] = {left_->substitute(context), right_->substitute(context)};
+
+    return substitute_with(context, operands);
 }
 
 template <typename Value_t>
 std::shared_ptr<ExpressionImpl<Value_t>> OperationSub<Value_t>::prettify() const {
-    auto new_left  = left_->prettify();
-    auto new_right = right_->prettify();
+    std::shared_ptr<ExpressionImpl<Value_t>> operands[] = {left_->prettify(), right_->prettify()};
+
+    return prettify_with(operands);
+}
+
+template <typename Value_t>
+std::shared_ptr<ExpressionImpl<Value_t>> OperationSub<Value_t>::prettify_with(OperandResults<Value_t> operands) const {
+    auto new_left  = operands[0];
+    auto new_right = operands[1];
 
     if (is_zero(new_right)) return new_left;
     if (is_val(new_left) && is_val(new_right)) {
@@ -367,6 +1329,43 @@ std::string OperationSub<Value_t>::to_string() const {
            std::string(")");
 }
 
+template <typename Value_t>
+Value_t OperationSub<Value_t>::eval_with(std::map<std::string, Value_t> &context, std::span<const Value_t> operands) const {
+    (void) context;
+
+    return operands[0] - operands[1];
+}
+
+template <typename Value_t>
+std::shared_ptr<ExpressionImpl<Value_t>> OperationSub<Value_t>::substitute_with(std::map<std::string, Value_t> &context,
+                                                                                OperandResults<Value_t> operands) const {
+    (void) context;
+
+    return std::make_shared<OperationSub<Value_t>>(operands[0], operands[1]);
+}
+
+template <typename Value_t>
+void OperationSub<Value_t>::write(std::string &out, size_t position) const {
+    static const char *const parts[] = {"(", " - ", ")"};
+
+    out += parts[position];
+}
+
+template <typename Value_t>
+NodeType OperationSub<Value_t>::type() const {
+    return NODE_SUB;
+}
+
+template <typename Value_t>
+size_t OperationSub<Value_t>::arity() const {
+    return 2;
+}
+
+template <typename Value_t>
+const std::shared_ptr<ExpressionImpl<Value_t>> &OperationSub<Value_t>::operand(size_t index) const {
+    return (index == 0) ? left_ : right_;
+}
+
 template class OperationSub<long double>;
 template class OperationSub<std::complex<long double>>;
 
@@ -375,12 +1374,19 @@ template class OperationSub<std::complex<long double>>;
 //====================//
 
 template <typename Value_t>
-OperationMul<Value_t>::OperationMul(const std::shared_ptr<ExpressionImpl<Value_t>> &left,
-                                    const std::shared_ptr<ExpressionImpl<Value_t>> &right) :
-    left_  (left),
-    right_ (right)
+OperationMul<Value_t>::OperationMul(std::shared_ptr<ExpressionImpl<Value_t>> left,
+                                            std::shared_ptr<ExpressionImpl<Value_t>> right) :
+    ExpressionImpl<Value_t>(left->variables().united(right->variables()), std::max(left->height(), right->height()) + 1),
+    left_  (std::move(left)),
+    right_ (std::move(right))
 {}
 
+template <typename Value_t>
+OperationMul<Value_t>::~OperationMul() {
+    ExpressionImpl<Value_t>::release(left_);
+    ExpressionImpl<Value_t>::release(right_);
+}
+
 template <typename Value_t>
 Value_t OperationMul<Value_t>::eval(std::map<std::string, Value_t> &context) const {
     Value_t value_left  = left_->eval(context);
@@ -390,24 +1396,51 @@ Value_t OperationMul<Value_t>::eval(std::map<std::string, Value_t> &context) con
 }
 
 template <typename Value_t>
-std::shared_ptr<ExpressionImpl<Value_t>> OperationMul<Value_t>::diff(const std::string &by) const {
+std::shared_ptr<ExpressionImpl<Value_t>> OperationMul<Value_t>::diff(uint32_t by) const {
+    if (!this->depends_on(by)) return ExpressionImpl<Value_t>::zero();
+
+    std::shared_ptr<ExpressionImpl<Value_t>> diffs[] = {left_->diff(by), right_->diff(by)};
+
+    return diff_with(by, diffs);
+}
+
+template <typename Value_t>
+std::shared_ptr<ExpressionImpl<Value_t>> OperationMul<Value_t>::diff_with(uint32_t by,
+                                                                          OperandResults<Value_t> diffs) const {
+    (void) by;
+
+    // Множитель, не зависящий от переменной, не даёт слагаемого в правиле произведения.
+    if (diffs[0] == ExpressionImpl<Value_t>::zero()) {
+        return std::make_shared<OperationMul<Value_t>>(left_, diffs[1]);
+    }
+    if (diffs[1] == ExpressionImpl<Value_t>::zero()) {
+        return std::make_shared<OperationMul<Value_t>>(diffs[0], right_);
+    }
+
     return std::make_shared<OperationAdd<Value_t>> (
-        std::make_shared<OperationMul<Value_t>>(left_->diff(by), right_),
-        std::make_shared<OperationMul<Value_t>>(left_, right_->diff(by))
+        std::make_shared<OperationMul<Value_t>>(diffs[0], right_),
+        std::make_shared<OperationMul<Value_t>>(left_, diffs[1])
     );
 }
 
 template <typename Value_t>
 std::shared_ptr<ExpressionImpl<Value_t>> OperationMul<Value_t>::substitute(std::map<std::string, Value_t> &context) const {
-    return std::make_shared<OperationMul<Value_t>> (
-        left_->substitute(context), right_->substitute(context)
-    );
+    std::shared_ptr<ExpressionImpl<Value_t>> operands[] = {left_->substitute(context), right_->substitute(context)};
+
+    return substitute_with(context, operands);
 }
 
 template <typename Value_t>
 std::shared_ptr<ExpressionImpl<Value_t>> OperationMul<Value_t>::prettify() const {
-    auto new_left  = left_->prettify();
-    auto new_right = right_->prettify();
+    std::shared_ptr<ExpressionImpl<Value_t>> operands[] = {left_->prettify(), right_->prettify()};
+
+    return prettify_with(operands);
+}
+
+template <typename Value_t>
+std::shared_ptr<ExpressionImpl<Value_t>> OperationMul<Value_t>::prettify_with(OperandResults<Value_t> operands) const {
+    auto new_left  = operands[0];
+    auto new_right = operands[1];
 
     if (is_one(new_left)) return new_right;
     if (is_one(new_right)) return new_left;
@@ -431,6 +1464,43 @@ std::string OperationMul<Value_t>::to_string() const {
            std::string(")");
 }
 
+template <typename Value_t>
+Value_t OperationMul<Value_t>::eval_with(std::map<std::string, Value_t> &context, std::span<const Value_t> operands) const {
+    (void) context;
+
+    return operands[0] * operands[1];
+}
+
+template <typename Value_t>
+std::shared_ptr<ExpressionImpl<Value_t>> OperationMul<Value_t>::substitute_with(std::map<std::string, Value_t> &context,
+                                                                                OperandResults<Value_t> operands) const {
+    (void) context;
+
+    return std::make_shared<OperationMul<Value_t>>(operands[0], operands[1]);
+}
+
+template <typename Value_t>
+void OperationMul<Value_t>::write(std::string &out, size_t position) const {
+    static const char *const parts[] = {"(", " * ", ")"};
+
+    out += parts[position];
+}
+
+template <typename Value_t>
+NodeType OperationMul<Value_t>::type() const {
+    return NODE_MUL;
+}
+
+template <typename Value_t>
+size_t OperationMul<Value_t>::arity() const {
+    return 2;
+}
+
+template <typename Value_t>
+const std::shared_ptr<ExpressionImpl<Value_t>> &OperationMul<Value_t>::operand(size_t index) const {
+    return (index == 0) ? left_ : right_;
+}
+
 template class OperationMul<long double>;
 template class OperationMul<std::complex<long double>>;
 
@@ -439,12 +1509,19 @@ template class OperationMul<std::complex<long double>>;
 //====================//
 
 template <typename Value_t>
-OperationDiv<Value_t>::OperationDiv(const std::shared_ptr<ExpressionImpl<Value_t>> &left,
-                                    const std::shared_ptr<ExpressionImpl<Value_t>> &right) :
-    left_  (left),
-    right_ (right)
+OperationDiv<Value_t>::OperationDiv(std::shared_ptr<ExpressionImpl<Value_t>> left,
+                                            std::shared_ptr<ExpressionImpl<Value_t>> right) :
+    ExpressionImpl<Value_t>(left->variables().united(right->variables()), std::max(left->height(), right->height()) + 1),
+    left_  (std::move(left)),
+    right_ (std::move(right))
 {}
 
+template <typename Value_t>
+OperationDiv<Value_t>::~OperationDiv() {
+    ExpressionImpl<Value_t>::release(left_);
+    ExpressionImpl<Value_t>::release(right_);
+}
+
 template <typename Value_t>
 Value_t OperationDiv<Value_t>::eval(std::map<std::string, Value_t> &context) const {
     Value_t value_left  = left_->eval(context);
@@ -454,31 +1531,52 @@ Value_t OperationDiv<Value_t>::eval(std::map<std::string, Value_t> &context) con
 }
 
 template <typename Value_t>
-std::shared_ptr<ExpressionImpl<Value_t>> OperationDiv<Value_t>::diff(const std::string &by) const {
+std::shared_ptr<ExpressionImpl<Value_t>> OperationDiv<Value_t>::diff(uint32_t by) const {
+    if (!this->depends_on(by)) return ExpressionImpl<Value_t>::zero();
+
+    std::shared_ptr<ExpressionImpl<Value_t>> diffs[] = {left_->diff(by), right_->diff(by)};
+
+    return diff_with(by, diffs);
+}
+
+template <typename Value_t>
+std::shared_ptr<ExpressionImpl<Value_t>> OperationDiv<Value_t>::diff_with(uint32_t by,
+                                                                          OperandResults<Value_t> diffs) const {
+    (void) by;
+
+    // Постоянный знаменатель: (left_' * right_) / right_^2 = left_' / right_.
+    if (diffs[1] == ExpressionImpl<Value_t>::zero()) {
+        return std::make_shared<OperationDiv<Value_t>>(diffs[0], right_);
+    }
+
     auto numerator = std::make_shared<OperationSub<Value_t>> (
-        std::make_shared<OperationMul<Value_t>>(left_->diff(by), right_),
-        std::make_shared<OperationMul<Value_t>>(left_, right_->diff(by))
+        std::make_shared<OperationMul<Value_t>>(diffs[0], right_),
+        std::make_shared<OperationMul<Value_t>>(left_, diffs[1])
     );
 
-    auto denominator = std::make_shared<OperationPow<Value_t>>(
-        right_,
-        std::make_shared<Value<Value_t>>(2.0)
-    );
+    auto denominator = std::make_shared<OperationPowConst<Value_t>>(right_, Value_t(2.0));
 
     return std::make_shared<OperationDiv<Value_t>>(numerator, denominator);
 }
 
 template <typename Value_t>
 std::shared_ptr<ExpressionImpl<Value_t>> OperationDiv<Value_t>::substitute(std::map<std::string, Value_t> &context) const {
-    return std::make_shared<OperationDiv<Value_t>> (
-        left_->substitute(context), right_->substitute(context)
-    );
+    std::shared_ptr<ExpressionImpl<Value_t>> operands[] = {left_->substitute(context), right_->substitute(context)};
+
+    return substitute_with(context, operands);
 }
 
 template <typename Value_t>
 std::shared_ptr<ExpressionImpl<Value_t>> OperationDiv<Value_t>::prettify() const {
-    auto new_left  = left_->prettify();
-    auto new_right = right_->prettify();
+    std::shared_ptr<ExpressionImpl<Value_t>> operands[] = {left_->prettify(), right_->prettify()};
+
+    return prettify_with(operands);
+}
+
+template <typename Value_t>
+std::shared_ptr<ExpressionImpl<Value_t>> OperationDiv<Value_t>::prettify_with(OperandResults<Value_t> operands) const {
+    auto new_left  = operands[0];
+    auto new_right = operands[1];
 
     if (is_one(new_right)) return new_left;
     if (is_zero(new_left)) return std::make_shared<Value<Value_t>>(0.0);
@@ -500,6 +1598,43 @@ std::string OperationDiv<Value_t>::to_string() const {
            std::string(")");
 }
 
+template <typename Value_t>
+Value_t OperationDiv<Value_t>::eval_with(std::map<std::string, Value_t> &context, std::span<const Value_t> operands) const {
+    (void) context;
+
+    return operands[0] / operands[1];
+}
+
+template <typename Value_t>
+std::shared_ptr<ExpressionImpl<Value_t>> OperationDiv<Value_t>::substitute_with(std::map<std::string, Value_t> &context,
+                                                                                OperandResults<Value_t> operands) const {
+    (void) context;
+
+    return std::make_shared<OperationDiv<Value_t>>(operands[0], operands[1]);
+}
+
+template <typename Value_t>
+void OperationDiv<Value_t>::write(std::string &out, size_t position) const {
+    static const char *const parts[] = {"(", " / ", ")"};
+
+    out += parts[position];
+}
+
+template <typename Value_t>
+NodeType OperationDiv<Value_t>::type() const {
+    return NODE_DIV;
+}
+
+template <typename Value_t>
+size_t OperationDiv<Value_t>::arity() const {
+    return 2;
+}
+
+template <typename Value_t>
+const std::shared_ptr<ExpressionImpl<Value_t>> &OperationDiv<Value_t>::operand(size_t index) const {
+    return (index == 0) ? left_ : right_;
+}
+
 template class OperationDiv<long double>;
 template class OperationDiv<std::complex<long double>>;
 
@@ -508,33 +1643,67 @@ template class OperationDiv<std::complex<long double>>;
 //====================//
 
 template <typename Value_t>
-OperationPow<Value_t>::OperationPow(const std::shared_ptr<ExpressionImpl<Value_t>> &left,
-                                    const std::shared_ptr<ExpressionImpl<Value_t>> &right) :
-    left_  (left),
-    right_ (right)
+OperationPow<Value_t>::OperationPow(std::shared_ptr<ExpressionImpl<Value_t>> left,
+                                            std::shared_ptr<ExpressionImpl<Value_t>> right) :
+    ExpressionImpl<Value_t>(left->variables().united(right->variables()), std::max(left->height(), right->height()) + 1),
+    left_  (std::move(left)),
+    right_ (std::move(right))
 {}
 
+template <typename Value_t>
+OperationPow<Value_t>::~OperationPow() {
+    ExpressionImpl<Value_t>::release(left_);
+    ExpressionImpl<Value_t>::release(right_);
+}
+
 template <typename Value_t>
 Value_t OperationPow<Value_t>::eval(std::map<std::string, Value_t> &context) const {
     Value_t value_left  = left_->eval(context);
     Value_t value_right = right_->eval(context);
 
-    return pow(value_left, value_right);
+    return power(value_left, value_right);
+}
+
+template <typename Value_t>
+std::shared_ptr<ExpressionImpl<Value_t>> OperationPow<Value_t>::diff(uint32_t by) const {
+    if (!this->depends_on(by)) return ExpressionImpl<Value_t>::zero();
+
+    std::shared_ptr<ExpressionImpl<Value_t>> diffs[] = {left_->diff(by), right_->diff(by)};
+
+    return diff_with(by, diffs);
 }
 
 template <typename Value_t>
-std::shared_ptr<ExpressionImpl<Value_t>> OperationPow<Value_t>::diff(const std::string &by) const {
+std::shared_ptr<ExpressionImpl<Value_t>> OperationPow<Value_t>::diff_with(uint32_t by,
+                                                                          OperandResults<Value_t> diffs) const {
+    (void) by;
+
     // left_^right_ * (right_' * ln(left_) + (right_ * left_') / left_)
 
+    // Постоянный показатель: слагаемое с ln(left_) не строится (и не даёт NaN при left_ < 0).
+    if (diffs[1] == ExpressionImpl<Value_t>::zero()) {
+        return std::make_shared<OperationMul<Value_t>> (
+            std::make_shared<OperationPow<Value_t>>(left_, right_),
+            std::make_shared<OperationDiv<Value_t>>(std::make_shared<OperationMul<Value_t>>(right_, diffs[0]), left_)
+        );
+    }
+    // Постоянное основание.
+    if (diffs[0] == ExpressionImpl<Value_t>::zero()) {
+        return std::make_shared<OperationMul<Value_t>> (
+            std::make_shared<OperationPow<Value_t>>(left_, right_),
+            std::make_shared<OperationMul<Value_t>>(diffs[1], std::make_shared<OperationLn<Value_t>>(left_))
+        );
+    }
+
     // right_' * ln(left_)
     auto term1 = std::make_shared<OperationMul<Value_t>> (
-        right_->diff(by),
+        diffs[1],
         std::make_shared<OperationLn<Value_t>>(left_)
     );
 
     // (right_ * left_') / left_
     auto term2 = std::make_shared<OperationDiv<Value_t>> (
-        std::make_shared<OperationMul<Value_t>>(right_, left_->diff(by)),
+        std::make_shared<OperationMul<Value_t>>(right_, diffs[0]),
         left_
     );
 
@@ -547,15 +1716,22 @@ std::shared_ptr<ExpressionImpl<Value_t>> OperationPow<Value_t>::diff(const std::
 
 template <typename Value_t>
 std::shared_ptr<ExpressionImpl<Value_t>> OperationPow<Value_t>::substitute(std::map<std::string, Value_t> &context) const {
-    return std::make_shared<OperationPow<Value_t>> (
-        left_->substitute(context), right_->substitute(context)
-    );
+    std::shared_ptr<ExpressionImpl<Value_t>> operands[] = {left_->substitute(context), right_->substitute(context)};
+
+    return substitute_with(context, operands);
 }
 
 template <typename Value_t>
 std::shared_ptr<ExpressionImpl<Value_t>> OperationPow<Value_t>::prettify() const {
-    auto new_left = left_->prettify();
-    auto new_right = right_->prettify();
+    std::shared_ptr<ExpressionImpl<Value_t>> operands[] = {left_->prettify(), right_->prettify()};
+
+    return prettify_with(operands);
+}
+
+template <typename Value_t>
+std::shared_ptr<ExpressionImpl<Value_t>> OperationPow<Value_t>::prettify_with(OperandResults<Value_t> operands) const {
+    auto new_left = operands[0];
+    auto new_right = operands[1];
 
     if (is_zero(new_left)) return std::make_shared<Value<Value_t>>(0.0L);
     if (is_zero(new_right) || is_one(new_left))
@@ -569,7 +1745,7 @@ std::shared_ptr<ExpressionImpl<Value_t>> OperationPow<Value_t>::prettify() const
         );
     }
 
-    return std::make_shared<OperationPow<Value_t>>(new_left, new_right);
+    return make_power(new_left, new_right);
 }
 
 template <typename Value_t>
@@ -579,18 +1755,283 @@ std::string OperationPow<Value_t>::to_string() const {
            std::string(")");
 }
 
+template <typename Value_t>
+Value_t OperationPow<Value_t>::eval_with(std::map<std::string, Value_t> &context, std::span<const Value_t> operands) const {
+    (void) context;
+
+    return power(operands[0], operands[1]);
+}
+
+template <typename Value_t>
+std::shared_ptr<ExpressionImpl<Value_t>> OperationPow<Value_t>::substitute_with(std::map<std::string, Value_t> &context,
+                                                                                OperandResults<Value_t> operands) const {
+    (void) context;
+
+    return make_power(operands[0], operands[1]);
+}
+
+template <typename Value_t>
+void OperationPow<Value_t>::write(std::string &out, size_t position) const {
+    static const char *const parts[] = {"(", " ^ ", ")"};
+
+    out += parts[position];
+}
+
+template <typename Value_t>
+NodeType OperationPow<Value_t>::type() const {
+    return NODE_POW;
+}
+
+template <typename Value_t>
+size_t OperationPow<Value_t>::arity() const {
+    return 2;
+}
+
+template <typename Value_t>
+const std::shared_ptr<ExpressionImpl<Value_t>> &OperationPow<Value_t>::operand(size_t index) const {
+    return (index == 0) ? left_ : right_;
+}
+
 template class OperationPow<long double>;
 template class OperationPow<std::complex<long double>>;
 
+//=====================//
+// Класс PowerExponent //
+//=====================//
+
+template <typename Value_t>
+PowerExponent<Value_t>::PowerExponent(Value_t exponent) :
+    exponent_ (exponent),
+    twice_    (-1),
+    negative_ (false)
+{
+    // Разбор без вызовов библиотечных функций: power() выполняет его при каждом вычислении.
+    long double real = 0;
+    bool isReal = true;
+    if constexpr (std::is_same_v<Value_t, long double>) {
+        real = exponent;
+    }
+    else {
+        real = exponent.real();
+        isReal = exponent.imag() == 0;
+    }
+
+    long double twice = real < 0 ? -2 * real : 2 * real;
+    if (!isReal || !(twice <= 2 * MAX_SQUARING + 1)) return;
+
+    int n = static_cast<int>(twice);
+    if (twice != n) return;
+
+    twice_    = n;
+    negative_ = real < 0;
+}
+
+template <typename Value_t>
+Value_t PowerExponent<Value_t>::apply(const Value_t &base) const {
+    using std::sqrt;
+
+    if (twice_ < 0) return pow(base, exponent_);
+
+    // |exponent_| = n или n + 1/2.
+    Value_t result = (twice_ & 1) ? sqrt(base) : Value_t(1.0);
+    Value_t square = base;
+
+    for (int n = twice_ >> 1; n != 0; n >>= 1) {
+        if (n & 1) result *= square;
+        if (n > 1) square *= square;
+    }
+
+    return negative_ ? Value_t(1.0) / result : result;
+}
+
+template <typename Value_t>
+Value_t PowerExponent<Value_t>::value() const {
+    return exponent_;
+}
+
+template class PowerExponent<long double>;
+template class PowerExponent<std::complex<long double>>;
+
+//=========================//
+// Класс OperationPowConst //
+//=========================//
+
+template <typename Value_t>
+OperationPowConst<Value_t>::OperationPowConst(std::shared_ptr<ExpressionImpl<Value_t>> left, Value_t exponent) :
+    ExpressionImpl<Value_t>(left->variables(), left->height() + 1),
+    left_     (std::move(left)),
+    right_    (std::make_shared<Value<Value_t>>(exponent)),
+    exponent_ (exponent)
+{}
+
+template <typename Value_t>
+OperationPowConst<Value_t>::~OperationPowConst() {
+    ExpressionImpl<Value_t>::release(left_);
+}
+
+template <typename Value_t>
+Value_t OperationPowConst<Value_t>::eval(std::map<std::string, Value_t> &context) const {
+    return exponent_.apply(left_->eval(context));
+}
+
+template <typename Value_t>
+std::shared_ptr<ExpressionImpl<Value_t>> OperationPowConst<Value_t>::diff(uint32_t by) const {
+    if (!this->depends_on(by)) return ExpressionImpl<Value_t>::zero();
+
+    std::shared_ptr<ExpressionImpl<Value_t>> diffs[] = {left_->diff(by), ExpressionImpl<Value_t>::zero()};
+
+    return diff_with(by, diffs);
+}
+
+template <typename Value_t>
+std::shared_ptr<ExpressionImpl<Value_t>> OperationPowConst<Value_t>::diff_with(uint32_t by,
+                                                                               OperandResults<Value_t> diffs) const {
+    (void) by;
+
+    // n * left_^(n - 1) * left_'
+    if (exponent_.value() == Value_t(0.0) || diffs[0] == ExpressionImpl<Value_t>::zero()) {
+        return ExpressionImpl<Value_t>::zero();
+    }
+
+    Value_t lowered = exponent_.value() - Value_t(1.0);
+    std::shared_ptr<ExpressionImpl<Value_t>> derivative = std::make_shared<Value<Value_t>>(exponent_.value());
+
+    if (lowered == Value_t(1.0)) {
+        derivative = std::make_shared<OperationMul<Value_t>>(derivative, left_);
+    }
+    else if (lowered != Value_t(0.0)) {
+        derivative = std::make_shared<OperationMul<Value_t>>(
+            derivative, std::make_shared<OperationPowConst<Value_t>>(left_, lowered)
+        );
+    }
+
+    if (is_one(diffs[0])) return derivative;
+
+    return std::make_shared<OperationMul<Value_t>>(derivative, diffs[0]);
+}
+
+template <typename Value_t>
+std::shared_ptr<ExpressionImpl<Value_t>> OperationPowConst<Value_t>::substitute(std::map<std::string, Value_t> &context) const {
+    // Показатель не содержит переменных и не подставляется.
+    std::shared_ptr<ExpressionImpl<Value_t>> operands[] = {left_->substitute(context), right_};
+
+    return substitute_with(context, operands);
+}
+
+template <typename Value_t>
+std::shared_ptr<ExpressionImpl<Value_t>> OperationPowConst<Value_t>::prettify() const {
+    std::shared_ptr<ExpressionImpl<Value_t>> operands[] = {left_->prettify(), right_};
+
+    return prettify_with(operands);
+}
+
+template <typename Value_t>
+std::shared_ptr<ExpressionImpl<Value_t>> OperationPowConst<Value_t>::prettify_with(OperandResults<Value_t> operands) const {
+    auto new_left = operands[0];
+
+    if (is_zero(new_left)) return std::make_shared<Value<Value_t>>(0.0L);
+    if (exponent_.value() == Value_t(0.0) || is_one(new_left))
+        return std::make_shared<Value<Value_t>>(1.0);
+    if (exponent_.value() == Value_t(1.0)) return new_left;
+    if (is_val(new_left)) {
+        std::map<std::string, Value_t> emptyContext;
+
+        return std::make_shared<Value<Value_t>>(exponent_.apply(new_left->eval(emptyContext)));
+    }
+
+    return std::make_shared<OperationPowConst<Value_t>>(new_left, exponent_.value());
+}
+
+template <typename Value_t>
+std::string OperationPowConst<Value_t>::to_string() const {
+    return std::string("(")   + left_->to_string()  +
+           std::string(" ^ ") + right_->to_string() +
+           std::string(")");
+}
+
+template <typename Value_t>
+Value_t OperationPowConst<Value_t>::eval_with(std::map<std::string, Value_t> &context, std::span<const Value_t> operands) const {
+    (void) context;
+
+    return exponent_.apply(operands[0]);
+}
+
+template <typename Value_t>
+std::shared_ptr<ExpressionImpl<Value_t>> OperationPowConst<Value_t>::substitute_with(std::map<std::string, Value_t> &context,
+                                                                                     OperandResults<Value_t> operands) const {
+    (void) context;
+
+    return std::make_shared<OperationPowConst<Value_t>>(operands[0], exponent_.value());
+}
+
+template <typename Value_t>
+void OperationPowConst<Value_t>::write(std::string &out, size_t position) const {
+    static const char *const parts[] = {"(", " ^ ", ")"};
+
+    out += parts[position];
+}
+
+template <typename Value_t>
+NodeType OperationPowConst<Value_t>::type() const {
+    return NODE_POW;
+}
+
+template <typename Value_t>
+size_t OperationPowConst<Value_t>::arity() const {
+    return 2;
+}
+
+template <typename Value_t>
+const std::shared_ptr<ExpressionImpl<Value_t>> &OperationPowConst<Value_t>::operand(size_t index) const {
+    return (index == 0) ? left_ : right_;
+}
+
+template <typename Value_t>
+Value_t OperationPowConst<Value_t>::exponent() const {
+    return exponent_.value();
+}
+
+template class OperationPowConst<long double>;
+template class OperationPowConst<std::complex<long double>>;
+
+template <typename Value_t>
+Value_t power(const Value_t &base, const Value_t &exponent) {
+    return PowerExponent<Value_t>(exponent).apply(base);
+}
+
+template long double power(const long double &base, const long double &exponent);
+template std::complex<long double> power(const std::complex<long double> &base, const std::complex<long double> &exponent);
+
+template <typename Value_t>
+std::shared_ptr<ExpressionImpl<Value_t>> make_power(std::shared_ptr<ExpressionImpl<Value_t>> left,
+                                                    std::shared_ptr<ExpressionImpl<Value_t>> right) {
+    if (const Value<Value_t> *value = dynamic_cast<const Value<Value_t>*>(right.get())) {
+        return std::make_shared<OperationPowConst<Value_t>>(std::move(left), value->value());
+    }
+
+    return std::make_shared<OperationPow<Value_t>>(std::move(left), std::move(right));
+}
+
+template std::shared_ptr<ExpressionImpl<long double>> make_power(
+    std::shared_ptr<ExpressionImpl<long double>> left, std::shared_ptr<ExpressionImpl<long double>> right);
+template std::shared_ptr<ExpressionImpl<std::complex<long double>>> make_power(
+    std::shared_ptr<ExpressionImpl<std::complex<long double>>> left, std::shared_ptr<ExpressionImpl<std::complex<long double>>> right);
+
 //====================//
 // Класс OperationSin //
 //====================//
 
 template <typename Value_t>
-OperationSin<Value_t>::OperationSin(const std::shared_ptr<ExpressionImpl<Value_t>> &argument) :
-    argument_(argument)
+OperationSin<Value_t>::OperationSin(std::shared_ptr<ExpressionImpl<Value_t>> argument) :
+    ExpressionImpl<Value_t>(argument->variables(), argument->height() + 1),
+    argument_(std::move(argument))
 {}
 
+template <typename Value_t>
+OperationSin<Value_t>::~OperationSin() {
+    ExpressionImpl<Value_t>::release(argument_);
+}
+
 template <typename Value_t>
 Value_t OperationSin<Value_t>::eval(std::map<std::string, Value_t> &context) const {
     Value_t value  = argument_->eval(context);
@@ -599,19 +2040,40 @@ Value_t OperationSin<Value_t>::eval(std::map<std::string, Value_t> &context) con
 }
 
 template <typename Value_t>
-std::shared_ptr<ExpressionImpl<Value_t>> OperationSin<Value_t>::diff(const std::string &by) const {
+std::shared_ptr<ExpressionImpl<Value_t>> OperationSin<Value_t>::diff(uint32_t by) const {
+    if (!this->depends_on(by)) return ExpressionImpl<Value_t>::zero();
+
+    std::shared_ptr<ExpressionImpl<Value_t>> diffs[] = {argument_->diff(by)};
+
+    return diff_with(by, diffs);
+}
+
+template <typename Value_t>
+std::shared_ptr<ExpressionImpl<Value_t>> OperationSin<Value_t>::diff_with(uint32_t by,
+                                                                          OperandResults<Value_t> diffs) const {
+    (void) by;
+
     auto sin_diff = std::make_shared<OperationCos<Value_t>>(argument_);
-    return std::make_shared<OperationMul<Value_t>>(sin_diff, argument_->diff(by));
+    return std::make_shared<OperationMul<Value_t>>(sin_diff, diffs[0]);
 }
 
 template <typename Value_t>
 std::shared_ptr<ExpressionImpl<Value_t>> OperationSin<Value_t>::substitute(std::map<std::string, Value_t> &context) const {
-    return std::make_shared<OperationSin<Value_t>>(argument_->substitute(context));
+    std::shared_ptr<ExpressionImpl<Value_t>> operands[] = {argument_->substitute(context)};
+
+    return substitute_with(context, operands);
 }
 
 template <typename Value_t>
 std::shared_ptr<ExpressionImpl<Value_t>> OperationSin<Value_t>::prettify() const {
-    auto new_arg = argument_->prettify();
+    std::shared_ptr<ExpressionImpl<Value_t>> operands[] = {argument_->prettify()};
+
+    return prettify_with(operands);
+}
+
+template <typename Value_t>
+std::shared_ptr<ExpressionImpl<Value_t>> OperationSin<Value_t>::prettify_with(OperandResults<Value_t> operands) const {
+    auto new_arg = operands[0];
 
     if (is_val(new_arg)) {
         std::map<std::string, Value_t> emptyContext;
@@ -626,6 +2088,45 @@ std::string OperationSin<Value_t>::to_string() const {
     return "sin(" + argument_->to_string() + ")";
 }
 
+template <typename Value_t>
+Value_t OperationSin<Value_t>::eval_with(std::map<std::string, Value_t> &context, std::span<const Value_t> operands) const {
+    (void) context;
+
+    return sin(operands[0]);
+}
+
+template <typename Value_t>
+std::shared_ptr<ExpressionImpl<Value_t>> OperationSin<Value_t>::substitute_with(std::map<std::string, Value_t> &context,
+                                                                                OperandResults<Value_t> operands) const {
+    (void) context;
+
+    return std::make_shared<OperationSin<Value_t>>(operands[0]);
+}
+
+template <typename Value_t>
+void OperationSin<Value_t>::write(std::string &out, size_t position) const {
+    static const char *const parts[] = {"sin(", ")"};
+
+    out += parts[position];
+}
+
+template <typename Value_t>
+NodeType OperationSin<Value_t>::type() const {
+    return NODE_SIN;
+}
+
+template <typename Value_t>
+size_t OperationSin<Value_t>::arity() const {
+    return 1;
+}
+
+template <typename Value_t>
+const std::shared_ptr<ExpressionImpl<Value_t>> &OperationSin<Value_t>::operand(size_t index) const {
+    (void) index;
+
+    return argument_;
+}
+
 template class OperationSin<long double>;
 template class OperationSin<std::complex<long double>>;
 
@@ -634,10 +2135,16 @@ template class OperationSin<std::complex<long double>>;
 //====================//
 
 template <typename Value_t>
-OperationCos<Value_t>::OperationCos(const std::shared_ptr<ExpressionImpl<Value_t>> &argument) :
-    argument_(argument)
+OperationCos<Value_t>::OperationCos(std::shared_ptr<ExpressionImpl<Value_t>> argument) :
+    ExpressionImpl<Value_t>(argument->variables(), argument->height() + 1),
+    argument_(std::move(argument))
 {}
 
+template <typename Value_t>
+OperationCos<Value_t>::~OperationCos() {
+    ExpressionImpl<Value_t>::release(argument_);
+}
+
 template <typename Value_t>
 Value_t OperationCos<Value_t>::eval(std::map<std::string, Value_t> &context) const {
     Value_t value  = argument_->eval(context);
@@ -646,23 +2153,44 @@ Value_t OperationCos<Value_t>::eval(std::map<std::string, Value_t> &context) con
 }
 
 template <typename Value_t>
-std::shared_ptr<ExpressionImpl<Value_t>> OperationCos<Value_t>::diff(const std::string &by) const {
+std::shared_ptr<ExpressionImpl<Value_t>> OperationCos<Value_t>::diff(uint32_t by) const {
+    if (!this->depends_on(by)) return ExpressionImpl<Value_t>::zero();
+
+    std::shared_ptr<ExpressionImpl<Value_t>> diffs[] = {argument_->diff(by)};
+
+    return diff_with(by, diffs);
+}
+
+template <typename Value_t>
+std::shared_ptr<ExpressionImpl<Value_t>> OperationCos<Value_t>::diff_with(uint32_t by,
+                                                                          OperandResults<Value_t> diffs) const {
+    (void) by;
+
     auto cos_diff = std::make_shared<OperationMul<Value_t>> (
         std::make_shared<Value<Value_t>>(Value<Value_t>(-1.0)),
         std::make_shared<OperationSin<Value_t>>(argument_)
     );
 
-    return std::make_shared<OperationMul<Value_t>>(cos_diff, argument_->diff(by));
+    return std::make_shared<OperationMul<Value_t>>(cos_diff, diffs[0]);
 }
 
 template <typename Value_t>
 std::shared_ptr<ExpressionImpl<Value_t>> OperationCos<Value_t>::substitute(std::map<std::string, Value_t> &context) const {
-    return std::make_shared<OperationCos<Value_t>>(argument_->substitute(context));
+    std::shared_ptr<ExpressionImpl<Value_t>> operands[] = {argument_->substitute(context)};
+
+    return substitute_with(context, operands);
 }
 
 template <typename Value_t>
 std::shared_ptr<ExpressionImpl<Value_t>> OperationCos<Value_t>::prettify() const {
-    auto new_arg = argument_->prettify();
+    std::shared_ptr<ExpressionImpl<Value_t>> operands[] = {argument_->prettify()};
+
+    return prettify_with(operands);
+}
+
+template <typename Value_t>
+std::shared_ptr<ExpressionImpl<Value_t>> OperationCos<Value_t>::prettify_with(OperandResults<Value_t> operands) const {
+    auto new_arg = operands[0];
 
     if (is_val(new_arg)) {
         std::map<std::string, Value_t> emptyContext;
@@ -677,6 +2205,45 @@ std::string OperationCos<Value_t>::to_string() const {
     return "cos(" + argument_->to_string() + ")";
 }
 
+template <typename Value_t>
+Value_t OperationCos<Value_t>::eval_with(std::map<std::string, Value_t> &context, std::span<const Value_t> operands) const {
+    (void) context;
+
+    return cos(operands[0]);
+}
+
+template <typename Value_t>
+std::shared_ptr<ExpressionImpl<Value_t>> OperationCos<Value_t>::substitute_with(std::map<std::string, Value_t> &context,
+                                                                                OperandResults<Value_t> operands) const {
+    (void) context;
+
+    return std::make_shared<OperationCos<Value_t>>(operands[0]);
+}
+
+template <typename Value_t>
+void OperationCos<Value_t>::write(std::string &out, size_t position) const {
+    static const char *const parts[] = {"cos(", ")"};
+
+    out += parts[position];
+}
+
+template <typename Value_t>
+NodeType OperationCos<Value_t>::type() const {
+    return NODE_COS;
+}
+
+template <typename Value_t>
+size_t OperationCos<Value_t>::arity() const {
+    return 1;
+}
+
+template <typename Value_t>
+const std::shared_ptr<ExpressionImpl<Value_t>> &OperationCos<Value_t>::operand(size_t index) const {
+    (void) index;
+
+    return argument_;
+}
+
 template class OperationCos<long double>;
 template class OperationCos<std::complex<long double>>;
 
@@ -685,10 +2252,16 @@ template class OperationCos<std::complex<long double>>;
 //===================//
 
 template <typename Value_t>
-OperationLn<Value_t>::OperationLn(const std::shared_ptr<ExpressionImpl<Value_t>> &argument) :
-    argument_(argument)
+OperationLn<Value_t>::OperationLn(std::shared_ptr<ExpressionImpl<Value_t>> argument) :
+    ExpressionImpl<Value_t>(argument->variables(), argument->height() + 1),
+    argument_(std::move(argument))
 {}
 
+template <typename Value_t>
+OperationLn<Value_t>::~OperationLn() {
+    ExpressionImpl<Value_t>::release(argument_);
+}
+
 template <typename Value_t>
 Value_t OperationLn<Value_t>::eval(std::map<std::string, Value_t> &context) const {
     Value_t value  = argument_->eval(context);
@@ -697,23 +2270,44 @@ Value_t OperationLn<Value_t>::eval(std::map<std::string, Value_t> &context) cons
 }
 
 template <typename Value_t>
-std::shared_ptr<ExpressionImpl<Value_t>> OperationLn<Value_t>::diff(const std::string &by) const {
+std::shared_ptr<ExpressionImpl<Value_t>> OperationLn<Value_t>::diff(uint32_t by) const {
+    if (!this->depends_on(by)) return ExpressionImpl<Value_t>::zero();
+
+    std::shared_ptr<ExpressionImpl<Value_t>> diffs[] = {argument_->diff(by)};
+
+    return diff_with(by, diffs);
+}
+
+template <typename Value_t>
+std::shared_ptr<ExpressionImpl<Value_t>> OperationLn<Value_t>::diff_with(uint32_t by,
+                                                                         OperandResults<Value_t> diffs) const {
+    (void) by;
+
     auto ln_diff = std::make_shared<OperationDiv<Value_t>> (
         std::make_shared<Value<Value_t>>(Value<Value_t>(1.0)),
         argument_
     );
 
-    return std::make_shared<OperationMul<Value_t>>(ln_diff, argument_->diff(by));
+    return std::make_shared<OperationMul<Value_t>>(ln_diff, diffs[0]);
 }
 
 template <typename Value_t>
 std::shared_ptr<ExpressionImpl<Value_t>> OperationLn<Value_t>::substitute(std::map<std::string, Value_t> &context) const {
-    return std::make_shared<OperationLn<Value_t>>(argument_->substitute(context));
+    std::shared_ptr<ExpressionImpl<Value_t>> operands[] = {argument_->substitute(context)};
+
+    return substitute_with(context, operands);
 }
 
 template <typename Value_t>
 std::shared_ptr<ExpressionImpl<Value_t>> OperationLn<Value_t>::prettify() const {
-    auto new_arg = argument_->prettify();
+    std::shared_ptr<ExpressionImpl<Value_t>> operands[] = {argument_->prettify()};
+
+    return prettify_with(operands);
+}
+
+template <typename Value_t>
+std::shared_ptr<ExpressionImpl<Value_t>> OperationLn<Value_t>::prettify_with(OperandResults<Value_t> operands) const {
+    auto new_arg = operands[0];
 
     if (is_val(new_arg)) {
         std::map<std::string, Value_t> emptyContext;
@@ -728,6 +2322,45 @@ std::string OperationLn<Value_t>::to_string() const {
     return "ln(" + argument_->to_string() + ")";
 }
 
+template <typename Value_t>
+Value_t OperationLn<Value_t>::eval_with(std::map<std::string, Value_t> &context, std::span<const Value_t> operands) const {
+    (void) context;
+
+    return log(operands[0]);
+}
+
+template <typename Value_t>
+std::shared_ptr<ExpressionImpl<Value_t>> OperationLn<Value_t>::substitute_with(std::map<std::string, Value_t> &context,
+                                                                               OperandResults<Value_t> operands) const {
+    (void) context;
+
+    return std::make_shared<OperationLn<Value_t>>(operands[0]);
+}
+
+template <typename Value_t>
+void OperationLn<Value_t>::write(std::string &out, size_t position) const {
+    static const char *const parts[] = {"ln(", ")"};
+
+    out += parts[position];
+}
+
+template <typename Value_t>
+NodeType OperationLn<Value_t>::type() const {
+    return NODE_LN;
+}
+
+template <typename Value_t>
+size_t OperationLn<Value_t>::arity() const {
+    return 1;
+}
+
+template <typename Value_t>
+const std::shared_ptr<ExpressionImpl<Value_t>> &OperationLn<Value_t>::operand(size_t index) const {
+    (void) index;
+
+    return argument_;
+}
+
 template class OperationLn<long double>;
 template class OperationLn<std::complex<long double>>;
 
@@ -736,10 +2369,16 @@ template class OperationLn<std::complex<long double>>;
 //====================//
 
 template <typename Value_t>
-OperationExp<Value_t>::OperationExp(const std::shared_ptr<ExpressionImpl<Value_t>> &argument) :
-    argument_(argument)
+OperationExp<Value_t>::OperationExp(std::shared_ptr<ExpressionImpl<Value_t>> argument) :
+    ExpressionImpl<Value_t>(argument->variables(), argument->height() + 1),
+    argument_(std::move(argument))
 {}
 
+template <typename Value_t>
+OperationExp<Value_t>::~OperationExp() {
+    ExpressionImpl<Value_t>::release(argument_);
+}
+
 template <typename Value_t>
 Value_t OperationExp<Value_t>::eval(std::map<std::string, Value_t> &context) const {
     Value_t value  = argument_->eval(context);
@@ -748,19 +2387,40 @@ Value_t OperationExp<Value_t>::eval(std::map<std::string, Value_t> &context) con
 }
 
 template <typename Value_t>
-std::shared_ptr<ExpressionImpl<Value_t>> OperationExp<Value_t>::diff(const std::string &by) const {
+std::shared_ptr<ExpressionImpl<Value_t>> OperationExp<Value_t>::diff(uint32_t by) const {
+    if (!this->depends_on(by)) return ExpressionImpl<Value_t>::zero();
+
+    std::shared_ptr<ExpressionImpl<Value_t>> diffs[] = {argument_->diff(by)};
+
+    return diff_with(by, diffs);
+}
+
+template <typename Value_t>
+std::shared_ptr<ExpressionImpl<Value_t>> OperationExp<Value_t>::diff_with(uint32_t by,
+                                                                          OperandResults<Value_t> diffs) const {
+    (void) by;
+
     auto exp_diff = std::make_shared<OperationExp<Value_t>>(argument_);
-    return std::make_shared<OperationMul<Value_t>>(exp_diff, argument_->diff(by));
+    return std::make_shared<OperationMul<Value_t>>(exp_diff, diffs[0]);
 }
 
 template <typename Value_t>
 std::shared_ptr<ExpressionImpl<Value_t>> OperationExp<Value_t>::substitute(std::map<std::string, Value_t> &context) const {
-    return std::make_shared<OperationExp<Value_t>>(argument_->substitute(context));
+    std::shared_ptr<ExpressionImpl<Value_t>> operands[] = {argument_->substitute(context)};
+
+    return substitute_with(context, operands);
 }
 
 template <typename Value_t>
 std::shared_ptr<ExpressionImpl<Value_t>> OperationExp<Value_t>::prettify() const {
-    auto new_arg = argument_->prettify();
+    std::shared_ptr<ExpressionImpl<Value_t>> operands[] = {argument_->prettify()};
+
+    return prettify_with(operands);
+}
+
+template <typename Value_t>
+std::shared_ptr<ExpressionImpl<Value_t>> OperationExp<Value_t>::prettify_with(OperandResults<Value_t> operands) const {
+    auto new_arg = operands[0];
 
     if (is_val(new_arg)) {
         std::map<std::string, Value_t> emptyContext;
@@ -775,5 +2435,44 @@ std::string OperationExp<Value_t>::to_string() const {
     return "exp(" + argument_->to_string() + ")";
 }
 
+template <typename Value_t>
+Value_t OperationExp<Value_t>::eval_with(std::map<std::string, Value_t> &context, std::span<const Value_t> operands) const {
+    (void) context;
+
+    return exp(operands[0]);
+}
+
+template <typename Value_t>
+std::shared_ptr<ExpressionImpl<Value_t>> OperationExp<Value_t>::substitute_with(std::map<std::string, Value_t> &context,
+                                                                                OperandResults<Value_t> operands) const {
+    (void) context;
+
+    return std::make_shared<OperationExp<Value_t>>(operands[0]);
+}
+
+template <typename Value_t>
+void OperationExp<Value_t>::write(std::string &out, size_t position) const {
+    static const char *const parts[] = {"exp(", ")"};
+
+    out += parts[position];
+}
+
+template <typename Value_t>
+NodeType OperationExp<Value_t>::type() const {
+    return NODE_EXP;
+}
+
+template <typename Value_t>
+size_t OperationExp<Value_t>::arity() const {
+    return 1;
+}
+
+template <typename Value_t>
+const std::shared_ptr<ExpressionImpl<Value_t>> &OperationExp<Value_t>::operand(size_t index) const {
+    (void) index;
+
+    return argument_;
+}
+
 template class OperationExp<long double>;
 template class OperationExp<std::complex<long double>>;
\ No newline at end of file
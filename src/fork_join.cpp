@@ -0,0 +1,209 @@
+#include <fork_join.hpp>
+
+#include <algorithm>
+
+// Пул и номер исполнителя, выполняющего текущий поток.
+static thread_local ForkJoinPool *currentPool = nullptr;
+static thread_local size_t currentWorker = 0;
+
+ForkJoinPool::ForkJoinPool(size_t workers) :
+    workers_   (),
+    injected_  (),
+    pending_   (0),
+    stopping_  (false),
+    mutex_     (),
+    available_ (),
+    finished_  ()
+{
+    if (workers == 0) {
+        workers = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // Очереди создаются до запуска потоков, так как исполнители крадут задачи друг у друга.
+    workers_.reserve(workers);
+    for (size_t i = 0; i < workers; i++) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < workers; i++) {
+        workers_[i]->thread = std::thread([this, i] { work(i); });
+    }
+}
+
+ForkJoinPool::~ForkJoinPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    available_.notify_all();
+
+    for (std::unique_ptr<Worker> &worker : workers_) {
+        worker->thread.join();
+    }
+}
+
+void ForkJoinPool::run(const std::function<void()> &task) {
+    // Задача исполнителя этого же пула выполняется на месте, чтобы не ждать саму себя.
+    if (currentPool == this) {
+        task();
+        return;
+    }
+
+    Task root{&task, false, nullptr, true};
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        injected_.push_back(&root);
+        pending_++;
+    }
+    available_.notify_one();
+
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        finished_.wait(lock, [&root] { return root.done.load(); });
+    }
+
+    if (root.error) std::rethrow_exception(root.error);
+}
+
+void ForkJoinPool::fork_join(const std::function<void()> &first, const std::function<void()> &second) {
+    if (currentPool != this) {
+        first();
+        second();
+        return;
+    }
+
+    size_t index = currentWorker;
+    Worker &worker = *workers_[index];
+
+    // Счётчик увеличивается до постановки, чтобы кража не могла опередить его увеличение.
+    Task forked{&second, false, nullptr, false};
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_++;
+    }
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.tasks.push_back(&forked);
+    }
+    available_.notify_one();
+
+    std::exception_ptr error;
+    try {
+        first();
+    }
+    catch (...) {
+        error = std::current_exception();
+    }
+
+    // Вложенные вызовы fork_join к этому моменту завершены, поэтому
+    // неукраденная вторая задача находится в конце своей очереди.
+    bool stolen = true;
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (!worker.tasks.empty() && worker.tasks.back() == &forked) {
+            worker.tasks.pop_back();
+            stolen = false;
+        }
+    }
+
+    if (!stolen) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending_--;
+        }
+        execute(&forked);
+    }
+    else {
+        // Пока украденная задача выполняется, исполнитель помогает с другими задачами.
+        while (!forked.done.load(std::memory_order_acquire)) {
+            if (Task *other = take(index)) {
+                execute(other);
+            }
+            else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    if (error) std::rethrow_exception(error);
+    if (forked.error) std::rethrow_exception(forked.error);
+}
+
+size_t ForkJoinPool::size() const {
+    return workers_.size();
+}
+
+ForkJoinPool::Task *ForkJoinPool::take(size_t index) {
+    Task *task = nullptr;
+
+    {
+        Worker &own = *workers_[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = own.tasks.back();
+            own.tasks.pop_back();
+        }
+    }
+
+    if (task == nullptr) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!injected_.empty()) {
+            task = injected_.front();
+            injected_.pop_front();
+            pending_--;
+            return task;
+        }
+    }
+
+    for (size_t i = 1; task == nullptr && i < workers_.size(); i++) {
+        Worker &victim = *workers_[(index + i) % workers_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+        }
+    }
+
+    if (task != nullptr) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_--;
+    }
+
+    return task;
+}
+
+void ForkJoinPool::execute(Task *task) {
+    try {
+        (*task->function)();
+    }
+    catch (...) {
+        task->error = std::current_exception();
+    }
+
+    if (task->external) {
+        // Признак выставляется под блокировкой, чтобы ожидающий не пропустил уведомление.
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            task->done.store(true, std::memory_order_release);
+        }
+        finished_.notify_all();
+    }
+    else {
+        task->done.store(true, std::memory_order_release);
+    }
+}
+
+void ForkJoinPool::work(size_t index) {
+    currentPool = this;
+    currentWorker = index;
+
+    while (true) {
+        if (Task *task = take(index)) {
+            execute(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        available_.wait(lock, [this] { return pending_ > 0 || stopping_; });
+        if (stopping_ && pending_ == 0) return;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,482 @@
+#include <frozen.hpp>
+
+#include <stdexcept>
+#include <cmath>
+#include <complex>
+#include <unordered_map>
+
+namespace {
+
+// Номер узла вместо нулевой производной (ExpressionImpl::zero() в дереве).
+const uint32_t NO_NODE = UINT32_MAX;
+
+} // namespace
+
+template <typename Value_t>
+FrozenExpression<Value_t>::FrozenExpression(const Expression<Value_t> &expr) :
+    nodes_     (),
+    constants_ (),
+    variables_ ()
+{
+    std::unordered_map<const ExpressionImpl<Value_t>*, uint32_t> frozen;
+    std::unordered_map<uint32_t, uint32_t> variableIndex;
+
+    // Обход в глубину с явным стеком: узел записывается после всех своих операндов.
+    std::vector<const ExpressionImpl<Value_t>*> stack{expr.impl().get()};
+
+    while (!stack.empty()) {
+        const ExpressionImpl<Value_t> *node = stack.back();
+
+        if (frozen.contains(node)) {
+            stack.pop_back();
+            continue;
+        }
+
+        bool ready = true;
+        for (size_t i = 0; i < node->arity(); i++) {
+            const ExpressionImpl<Value_t> *operand = node->operand(i).get();
+
+            if (!frozen.contains(operand)) {
+                stack.push_back(operand);
+                ready = false;
+            }
+        }
+        if (!ready) continue;
+
+        stack.pop_back();
+
+        FrozenNode result{node->type(), 0, 0};
+
+        if (node->type() == NODE_VALUE) {
+            result.left = static_cast<uint32_t>(constants_.size());
+            constants_.push_back(static_cast<const Value<Value_t>*>(node)->value());
+        }
+        else if (node->type() == NODE_VARIABLE) {
+            uint32_t id = static_cast<const Variable<Value_t>*>(node)->id();
+
+            auto [iter, inserted] = variableIndex.try_emplace(id, static_cast<uint32_t>(variables_.size()));
+            if (inserted) {
+                variables_.push_back(id);
+            }
+            result.left = iter->second;
+        }
+        else {
+            result.left  = frozen.at(node->operand(0).get());
+            result.right = (node->arity() == 2) ? frozen.at(node->operand(1).get()) : 0;
+        }
+
+        frozen.emplace(node, static_cast<uint32_t>(nodes_.size()));
+        nodes_.push_back(result);
+    }
+}
+
+template <typename Value_t>
+Expression<Value_t> FrozenExpression<Value_t>::expression() const {
+    // Каждый узел превращается ровно в один узел дерева, поэтому общие подвыражения сохраняются.
+    std::vector<std::shared_ptr<ExpressionImpl<Value_t>>> nodes(nodes_.size());
+
+    for (size_t i = 0; i < nodes_.size(); i++) {
+        const FrozenNode &node = nodes_[i];
+
+        if (node.type == NODE_VALUE) {
+            nodes[i] = std::make_shared<Value<Value_t>>(constants_[node.left]);
+            continue;
+        }
+        if (node.type == NODE_VARIABLE) {
+            nodes[i] = std::make_shared<Variable<Value_t>>(variables_[node.left]);
+            continue;
+        }
+
+        const std::shared_ptr<ExpressionImpl<Value_t>> &left  = nodes[node.left];
+        const std::shared_ptr<ExpressionImpl<Value_t>> &right = nodes[node.right];
+
+        switch (node.type) {
+            case NODE_ADD: nodes[i] = std::make_shared<OperationAdd<Value_t>>(left, right); break;
+            case NODE_SUB: nodes[i] = std::make_shared<OperationSub<Value_t>>(left, right); break;
+            case NODE_MUL: nodes[i] = std::make_shared<OperationMul<Value_t>>(left, right); break;
+            case NODE_DIV: nodes[i] = std::make_shared<OperationDiv<Value_t>>(left, right); break;
+            case NODE_POW: nodes[i] = make_power(left, right);                             break;
+            case NODE_SIN: nodes[i] = std::make_shared<OperationSin<Value_t>>(left);        break;
+            case NODE_COS: nodes[i] = std::make_shared<OperationCos<Value_t>>(left);        break;
+            case NODE_LN:  nodes[i] = std::make_shared<OperationLn<Value_t>>(left);         break;
+            case NODE_EXP: nodes[i] = std::make_shared<OperationExp<Value_t>>(left);        break;
+            default:                                                                        break;
+        }
+    }
+
+    return Expression<Value_t>(nodes.back());
+}
+
+template <typename Value_t>
+Value_t FrozenExpression<Value_t>::eval(std::map<std::string, Value_t> &context) const {
+    std::vector<Value_t> values;
+    values.reserve(variables_.size());
+
+    for (uint32_t id : variables_) {
+        const std::string &name = symbol_name(id);
+        auto iter = context.find(name);
+
+        if (iter == context.end()) {
+            throw std::runtime_error("Variable \"" + name + "\" not present in evaluation context");
+        }
+
+        values.push_back(iter->second);
+    }
+
+    return eval(values.data());
+}
+
+template <typename Value_t>
+Value_t FrozenExpression<Value_t>::eval(const Value_t *variables) const {
+    thread_local std::vector<Value_t> registers;
+    if (registers.size() < nodes_.size()) registers.resize(nodes_.size());
+
+    return eval(variables, registers.data());
+}
+
+template <typename Value_t>
+Value_t FrozenExpression<Value_t>::eval(const Value_t *variables, Value_t *registers) const {
+    for (size_t i = 0; i < nodes_.size(); i++) {
+        const FrozenNode &node = nodes_[i];
+
+        switch (node.type) {
+            case NODE_VALUE:    registers[i] = constants_[node.left];                              break;
+            case NODE_VARIABLE: registers[i] = variables[node.left];                               break;
+            case NODE_ADD:      registers[i] = registers[node.left] + registers[node.right];       break;
+            case NODE_SUB:      registers[i] = registers[node.left] - registers[node.right];       break;
+            case NODE_MUL:      registers[i] = registers[node.left] * registers[node.right];       break;
+            case NODE_DIV:      registers[i] = registers[node.left] / registers[node.right];       break;
+            case NODE_POW:      registers[i] = power(registers[node.left], registers[node.right]); break;
+            case NODE_SIN:      registers[i] = sin(registers[node.left]);                          break;
+            case NODE_COS:      registers[i] = cos(registers[node.left]);                          break;
+            case NODE_LN:       registers[i] = log(registers[node.left]);                          break;
+            case NODE_EXP:      registers[i] = exp(registers[node.left]);                          break;
+        }
+    }
+
+    return registers[nodes_.size() - 1];
+}
+
+template <typename Value_t>
+FrozenExpression<Value_t> FrozenExpression<Value_t>::diff(const std::string &by) const {
+    FrozenExpression<Value_t> result(*this);
+
+    // Номер переменной дифференцирования в таблице; выражение без неё имеет нулевую производную.
+    uint32_t variable = NO_NODE;
+    uint32_t id;
+    if (find_symbol(by, id)) {
+        for (size_t k = 0; k < variables_.size(); k++) {
+            if (variables_[k] == id) variable = static_cast<uint32_t>(k);
+        }
+    }
+
+    // Производные узлов строятся по правилам diff_with; NO_NODE - нулевая производная.
+    std::vector<uint32_t> diffs(nodes_.size(), NO_NODE);
+    std::vector<bool> depends(nodes_.size(), false);
+    uint32_t zero = NO_NODE;
+
+    auto materialize = [&](uint32_t diff) {
+        if (diff != NO_NODE) return diff;
+        if (zero == NO_NODE) zero = result.append_value(Value_t(0.0));
+        return zero;
+    };
+
+    for (uint32_t i = 0; i < nodes_.size(); i++) {
+        const FrozenNode node = nodes_[i];
+
+        switch (node.type) {
+            case NODE_VALUE:    depends[i] = false;                                          break;
+            case NODE_VARIABLE: depends[i] = node.left == variable;                          break;
+            case NODE_SIN:
+            case NODE_COS:
+            case NODE_LN:
+            case NODE_EXP:      depends[i] = depends[node.left];                             break;
+            default:            depends[i] = depends[node.left] || depends[node.right];      break;
+        }
+        if (!depends[i]) continue;
+
+        uint32_t left  = node.left;
+        uint32_t right = node.right;
+        uint32_t dl = node.type != NODE_VARIABLE ? diffs[left] : NO_NODE;
+        uint32_t dr = (node.type >= NODE_ADD && node.type <= NODE_POW) ? diffs[right] : NO_NODE;
+
+        switch (node.type) {
+            case NODE_VARIABLE:
+                diffs[i] = result.append_value(Value_t(1.0));
+                break;
+            case NODE_ADD:
+                if (dl == NO_NODE)      diffs[i] = dr;
+                else if (dr == NO_NODE) diffs[i] = dl;
+                else                    diffs[i] = result.append(NODE_ADD, dl, dr);
+                break;
+            case NODE_SUB:
+                if (dr == NO_NODE) diffs[i] = dl;
+                else               diffs[i] = result.append(NODE_SUB, materialize(dl), dr);
+                break;
+            case NODE_MUL:
+                if (dl == NO_NODE)      diffs[i] = result.append(NODE_MUL, left, materialize(dr));
+                else if (dr == NO_NODE) diffs[i] = result.append(NODE_MUL, dl, right);
+                else diffs[i] = result.append(NODE_ADD, result.append(NODE_MUL, dl, right),
+                                                        result.append(NODE_MUL, left, dr));
+                break;
+            case NODE_DIV:
+                if (dr == NO_NODE) {
+                    diffs[i] = result.append(NODE_DIV, materialize(dl), right);
+                }
+                else {
+                    uint32_t numerator = result.append(NODE_SUB, result.append(NODE_MUL, materialize(dl), right),
+                                                                 result.append(NODE_MUL, left, dr));
+                    uint32_t denominator = result.append(NODE_POW, right, result.append_value(Value_t(2.0)));
+                    diffs[i] = result.append(NODE_DIV, numerator, denominator);
+                }
+                break;
+            case NODE_POW:
+                if (is_value(right)) {
+                    // n * left^(n - 1) * left', как в OperationPowConst.
+                    Value_t exponent = value(right);
+                    if (exponent == Value_t(0.0) || dl == NO_NODE) break;
+
+                    Value_t lowered = exponent - Value_t(1.0);
+                    uint32_t derivative = result.append_value(exponent);
+
+                    if (lowered == Value_t(1.0)) {
+                        derivative = result.append(NODE_MUL, derivative, left);
+                    }
+                    else if (lowered != Value_t(0.0)) {
+                        derivative = result.append(NODE_MUL, derivative,
+                                                   result.append(NODE_POW, left, result.append_value(lowered)));
+                    }
+
+                    bool unit = result.is_value(dl) && result.value(dl) == Value_t(1.0);
+                    diffs[i] = unit ? derivative : result.append(NODE_MUL, derivative, dl);
+                }
+                else if (dr == NO_NODE) {
+                    diffs[i] = result.append(NODE_MUL, i,
+                                             result.append(NODE_DIV, result.append(NODE_MUL, right, materialize(dl)), left));
+                }
+                else if (dl == NO_NODE) {
+                    diffs[i] = result.append(NODE_MUL, i,
+                                             result.append(NODE_MUL, dr, result.append(NODE_LN, left)));
+                }
+                else {
+                    uint32_t term1 = result.append(NODE_MUL, dr, result.append(NODE_LN, left));
+                    uint32_t term2 = result.append(NODE_DIV, result.append(NODE_MUL, right, dl), left);
+                    diffs[i] = result.append(NODE_MUL, i, result.append(NODE_ADD, term1, term2));
+                }
+                break;
+            case NODE_SIN:
+                diffs[i] = result.append(NODE_MUL, result.append(NODE_COS, left), materialize(dl));
+                break;
+            case NODE_COS: {
+                uint32_t sine = result.append(NODE_MUL, result.append_value(Value_t(-1.0)), result.append(NODE_SIN, left));
+                diffs[i] = result.append(NODE_MUL, sine, materialize(dl));
+                break;
+            }
+            case NODE_LN:
+                diffs[i] = result.append(NODE_MUL, result.append(NODE_DIV, result.append_value(Value_t(1.0)), left),
+                                         materialize(dl));
+                break;
+            case NODE_EXP:
+                diffs[i] = result.append(NODE_MUL, i, materialize(dl));
+                break;
+            default:
+                break;
+        }
+    }
+
+    result.compact(materialize(diffs.back()));
+    return result;
+}
+
+template <typename Value_t>
+FrozenExpression<Value_t> FrozenExpression<Value_t>::prettify() const {
+    FrozenExpression<Value_t> result(*this);
+
+    // Упрощённые узлы строятся по правилам prettify_with; неизменившийся узел остаётся на месте.
+    std::vector<uint32_t> pretty(nodes_.size());
+
+    for (uint32_t i = 0; i < nodes_.size(); i++) {
+        const FrozenNode node = nodes_[i];
+
+        if (node.type == NODE_VALUE || node.type == NODE_VARIABLE) {
+            pretty[i] = i;
+            continue;
+        }
+
+        uint32_t left  = pretty[node.left];
+        bool unary = node.type >= NODE_SIN;
+        uint32_t right = unary ? 0 : pretty[node.right];
+
+        bool leftValue  = result.is_value(left);
+        bool rightValue = !unary && result.is_value(right);
+        Value_t a = leftValue  ? result.value(left)  : Value_t(0.0);
+        Value_t b = rightValue ? result.value(right) : Value_t(0.0);
+
+        bool leftZero  = leftValue  && a == Value_t(0.0);
+        bool leftOne   = leftValue  && a == Value_t(1.0);
+        bool rightZero = rightValue && b == Value_t(0.0);
+        bool rightOne  = rightValue && b == Value_t(1.0);
+
+        uint32_t rebuilt = NO_NODE;
+        auto rebuild = [&] {
+            if (left == node.left && (unary || right == node.right)) return i;
+            return result.append(node.type, left, right);
+        };
+
+        switch (node.type) {
+            case NODE_ADD:
+                if (leftZero)                     rebuilt = right;
+                else if (rightZero)               rebuilt = left;
+                else if (leftValue && rightValue) rebuilt = result.append_value(a + b);
+                else                              rebuilt = rebuild();
+                break;
+            case NODE_SUB:
+                if (rightZero)                    rebuilt = left;
+                else if (leftValue && rightValue) rebuilt = result.append_value(a - b);
+                else                              rebuilt = rebuild();
+                break;
+            case NODE_MUL:
+                if (leftOne)                      rebuilt = right;
+                else if (rightOne)                rebuilt = left;
+                else if (leftZero || rightZero)   rebuilt = result.append_value(Value_t(0.0));
+                else if (leftValue && rightValue) rebuilt = result.append_value(a * b);
+                else                              rebuilt = rebuild();
+                break;
+            case NODE_DIV:
+                if (rightOne)                     rebuilt = left;
+                else if (leftZero)                rebuilt = result.append_value(Value_t(0.0));
+                else if (leftValue && rightValue) rebuilt = result.append_value(a / b);
+                else                              rebuilt = rebuild();
+                break;
+            case NODE_POW:
+                // Числовой показатель исходного узла - правила OperationPowConst, иначе OperationPow.
+                if (is_value(node.right)) {
+                    if (leftZero)                                      rebuilt = result.append_value(Value_t(0.0));
+                    else if (b == Value_t(0.0) || leftOne)             rebuilt = result.append_value(Value_t(1.0));
+                    else if (b == Value_t(1.0))                        rebuilt = left;
+                    else if (leftValue)                                rebuilt = result.append_value(power(a, b));
+                    else                                               rebuilt = rebuild();
+                }
+                else {
+                    if (leftZero)                                      rebuilt = result.append_value(Value_t(0.0));
+                    else if (rightZero || leftOne)                     rebuilt = result.append_value(Value_t(1.0));
+                    else if (rightOne)                                 rebuilt = left;
+                    else if (leftValue && rightValue)                  rebuilt = result.append_value(pow(a, b));
+                    else                                               rebuilt = rebuild();
+                }
+                break;
+            case NODE_SIN: rebuilt = leftValue ? result.append_value(sin(a)) : rebuild(); break;
+            case NODE_COS: rebuilt = leftValue ? result.append_value(cos(a)) : rebuild(); break;
+            case NODE_LN:  rebuilt = leftValue ? result.append_value(log(a)) : rebuild(); break;
+            case NODE_EXP: rebuilt = leftValue ? result.append_value(exp(a)) : rebuild(); break;
+            default: break;
+        }
+
+        pretty[i] = rebuilt;
+    }
+
+    result.compact(pretty.back());
+    return result;
+}
+
+template <typename Value_t>
+uint32_t FrozenExpression<Value_t>::append(NodeType type, uint32_t left, uint32_t right) {
+    nodes_.push_back(FrozenNode{type, left, right});
+    return static_cast<uint32_t>(nodes_.size() - 1);
+}
+
+template <typename Value_t>
+uint32_t FrozenExpression<Value_t>::append_value(Value_t value) {
+    constants_.push_back(value);
+    return append(NODE_VALUE, static_cast<uint32_t>(constants_.size() - 1));
+}
+
+template <typename Value_t>
+bool FrozenExpression<Value_t>::is_value(uint32_t node) const {
+    return nodes_[node].type == NODE_VALUE;
+}
+
+template <typename Value_t>
+Value_t FrozenExpression<Value_t>::value(uint32_t node) const {
+    return constants_[nodes_[node].left];
+}
+
+template <typename Value_t>
+void FrozenExpression<Value_t>::compact(uint32_t root) {
+    // Операнды расположены раньше операций, поэтому достижимость отмечается одним обратным проходом.
+    std::vector<bool> reachable(root + 1, false);
+    reachable[root] = true;
+
+    for (uint32_t i = root + 1; i-- > 0;) {
+        if (!reachable[i]) continue;
+
+        const FrozenNode &node = nodes_[i];
+        if (node.type == NODE_VALUE || node.type == NODE_VARIABLE) continue;
+
+        reachable[node.left] = true;
+        if (node.type < NODE_SIN) reachable[node.right] = true;
+    }
+
+    std::vector<uint32_t> renumbered(root + 1, NO_NODE);
+    std::vector<uint32_t> variableIndex(variables_.size(), NO_NODE);
+    std::vector<FrozenNode> nodes;
+    std::vector<Value_t> constants;
+    std::vector<uint32_t> variables;
+
+    for (uint32_t i = 0; i <= root; i++) {
+        if (!reachable[i]) continue;
+
+        FrozenNode node = nodes_[i];
+        if (node.type == NODE_VALUE) {
+            constants.push_back(constants_[node.left]);
+            node.left = static_cast<uint32_t>(constants.size() - 1);
+        }
+        else if (node.type == NODE_VARIABLE) {
+            if (variableIndex[node.left] == NO_NODE) {
+                variableIndex[node.left] = static_cast<uint32_t>(variables.size());
+                variables.push_back(variables_[node.left]);
+            }
+            node.left = variableIndex[node.left];
+        }
+        else {
+            node.left  = renumbered[node.left];
+            node.right = node.type < NODE_SIN ? renumbered[node.right] : 0;
+        }
+
+        renumbered[i] = static_cast<uint32_t>(nodes.size());
+        nodes.push_back(node);
+    }
+
+    nodes_     = std::move(nodes);
+    constants_ = std::move(constants);
+    variables_ = std::move(variables);
+}
+
+template <typename Value_t>
+size_t FrozenExpression<Value_t>::size() const {
+    return nodes_.size();
+}
+
+template <typename Value_t>
+uint64_t FrozenExpression<Value_t>::byte_footprint() const {
+    return sizeof(*this) + nodes_.size() * sizeof(FrozenNode) +
+           constants_.size() * sizeof(Value_t) + variables_.size() * sizeof(uint32_t);
+}
+
+template <typename Value_t>
+const std::vector<FrozenNode> &FrozenExpression<Value_t>::nodes() const {
+    return nodes_;
+}
+
+template <typename Value_t>
+const std::vector<Value_t> &FrozenExpression<Value_t>::constants() const {
+    return constants_;
+}
+
+template <typename Value_t>
+const std::vector<uint32_t> &FrozenExpression<Value_t>::variables() const {
+    return variables_;
+}
+
+template class FrozenExpression<long double>;
+template class FrozenExpression<std::complex<long double>>;
\ No newline at end of file
@@ -0,0 +1,326 @@
+#include <generator.hpp>
+
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+
+#include <tape.hpp>
+
+namespace {
+
+// Размер выборки подвыражений для повторного использования.
+const size_t RESERVOIR_SIZE = 4096;
+
+// Порог промежуточных значений, выше которого точка считается плохо обусловленной.
+const long double ILL_CONDITIONED = 1e12L;
+// Порог аргумента sin и cos: абсолютная погрешность большого аргумента становится ошибкой фазы.
+const long double LARGE_PHASE = 1e6L;
+
+bool is_unary(NodeType type) {
+    return type == NODE_SIN || type == NODE_COS || type == NODE_LN || type == NODE_EXP;
+}
+
+// Наибольшее число узлов в дереве заданной высоты (с насыщением).
+size_t capacity(size_t height) {
+    return height >= 63 ? SIZE_MAX : (size_t(1) << (height + 1)) - 1;
+}
+
+// Имя переменной по номеру (имена переменных состоят только из букв).
+std::string variable_name(size_t index) {
+    if (index < 3) return std::string(1, char('x' + index));
+
+    std::string name = "v";
+    do {
+        name += char('a' + index % 26);
+        index /= 26;
+    } while (index != 0);
+    return name;
+}
+
+const char *operation_symbol(NodeType type) {
+    switch (type) {
+        case NODE_ADD: return " + ";
+        case NODE_SUB: return " - ";
+        case NODE_MUL: return " * ";
+        case NODE_DIV: return " / ";
+        case NODE_POW: return " ^ ";
+        case NODE_SIN: return "sin(";
+        case NODE_COS: return "cos(";
+        case NODE_LN:  return "ln(";
+        case NODE_EXP: return "exp(";
+        default:       return "";
+    }
+}
+
+} // namespace
+
+ExpressionGenerator::ExpressionGenerator(const GeneratorOptions &options) :
+    options_   (options),
+    random_    (options.seed),
+    variables_ (),
+    reservoir_ (),
+    built_     (0)
+{
+    if (options_.variables == 0) {
+        throw std::invalid_argument("Generator needs at least one variable");
+    }
+
+    for (size_t i = 0; i < options_.variables; i++) {
+        variables_.push_back(variable_name(i));
+    }
+}
+
+Expression<ExpressionGenerator::Value_t> ExpressionGenerator::expression() {
+    reservoir_.clear();
+    built_ = 0;
+
+    return Expression<Value_t>(build(std::max<size_t>(options_.nodes, 1), options_.depth).node);
+}
+
+ExpressionGenerator::Built ExpressionGenerator::build(size_t budget, size_t depth) {
+    if (budget == 1 || depth == 0) return leaf();
+
+    // Выбор операции среди допустимых при оставшемся числе узлов и глубине:
+    // бинарной операции нужно хотя бы три узла, унарной - место для остальных узлов под ней.
+    auto allowed = [&](NodeType type) {
+        return is_unary(type) ? budget - 1 <= capacity(depth - 1) : budget >= 3;
+    };
+
+    double total = 0.0;
+    for (const auto &[type, weight] : options_.mix) {
+        if (allowed(type)) total += weight;
+    }
+    if (total <= 0.0) return leaf();
+
+    NodeType type = NODE_ADD;
+    double choice = uniform_real() * total;
+    for (const auto &[candidate, weight] : options_.mix) {
+        if (!allowed(candidate)) continue;
+
+        type = candidate;
+        if (choice < weight) break;
+        choice -= weight;
+    }
+
+    Built result;
+    if (is_unary(type)) {
+        Built argument = build(budget - 1, depth - 1);
+        result.height = argument.height + 1;
+        result.nodes = argument.nodes + 1;
+
+        switch (type) {
+            case NODE_SIN: result.node = std::make_shared<OperationSin<Value_t>>(argument.node); break;
+            case NODE_COS: result.node = std::make_shared<OperationCos<Value_t>>(argument.node); break;
+            case NODE_LN:  result.node = std::make_shared<OperationLn<Value_t>>(argument.node);  break;
+            default:       result.node = std::make_shared<OperationExp<Value_t>>(argument.node); break;
+        }
+    }
+    else {
+        size_t rest = budget - 1;
+        Built left, right;
+
+        if (rest <= capacity(depth - 1) && share(depth - 1, left)) {
+            // Один из операндов ссылается на построенное ранее подвыражение,
+            // второй получает все оставшиеся узлы.
+            right = build(rest, depth - 1);
+            if (uniform(2) == 0) std::swap(left, right);
+        }
+        else {
+            // Разбиение оставшихся узлов между операндами с учётом ограничения глубины;
+            // узлы, не использованные левым операндом, достаются правому.
+            size_t limit = capacity(depth - 1);
+            size_t low = rest > limit ? rest - limit : 1;
+            size_t high = std::min(rest - 1, limit);
+            size_t leftBudget = low <= high ? low + uniform(high - low + 1) : rest / 2;
+
+            left = build(leftBudget, depth - 1);
+            right = build(rest - left.nodes, depth - 1);
+        }
+        result.height = std::max(left.height, right.height) + 1;
+        result.nodes = left.nodes + right.nodes + 1;
+
+        switch (type) {
+            case NODE_ADD: result.node = std::make_shared<OperationAdd<Value_t>>(left.node, right.node); break;
+            case NODE_SUB: result.node = std::make_shared<OperationSub<Value_t>>(left.node, right.node); break;
+            case NODE_MUL: result.node = std::make_shared<OperationMul<Value_t>>(left.node, right.node); break;
+            case NODE_DIV: result.node = std::make_shared<OperationDiv<Value_t>>(left.node, right.node); break;
+            default:       result.node = make_power(left.node, right.node);                         break;
+        }
+    }
+
+    remember(result);
+    return result;
+}
+
+ExpressionGenerator::Built ExpressionGenerator::leaf() {
+    Built result;
+    result.height = 0;
+    result.nodes = 1;
+
+    // Только положительные константы: отрицательные числа не разбираются парсером.
+    if (uniform(2) == 0) {
+        result.node = std::make_shared<Value<Value_t>>(Value_t(1 + uniform(9)));
+    }
+    else {
+        result.node = std::make_shared<Variable<Value_t>>(variables_[uniform(variables_.size())]);
+    }
+
+    remember(result);
+    return result;
+}
+
+bool ExpressionGenerator::share(size_t depth, Built &shared) {
+    if (reservoir_.empty() || uniform_real() >= options_.sharing) return false;
+
+    const Built &candidate = reservoir_[uniform(reservoir_.size())];
+    if (candidate.height > depth) return false;
+
+    shared = Built{candidate.node, candidate.height, 0};
+    return true;
+}
+
+void ExpressionGenerator::remember(const Built &built) {
+    // Равномерная выборка фиксированного размера из всех построенных подвыражений.
+    built_++;
+    if (reservoir_.size() < RESERVOIR_SIZE) {
+        reservoir_.push_back(built);
+        return;
+    }
+
+    uint64_t slot = uniform(built_);
+    if (slot < RESERVOIR_SIZE) reservoir_[slot] = built;
+}
+
+std::string ExpressionGenerator::text(const Expression<Value_t> &expr) {
+    // Обход с явным стеком из узлов и фрагментов текста.
+    struct Item {
+        const ExpressionImpl<Value_t> *node;
+        const char *text;
+    };
+
+    std::string result;
+    std::vector<Item> stack{{expr.impl().get(), nullptr}};
+
+    while (!stack.empty()) {
+        Item item = stack.back();
+        stack.pop_back();
+
+        if (item.text != nullptr) {
+            result += item.text;
+            continue;
+        }
+
+        const ExpressionImpl<Value_t> *node = item.node;
+        switch (node->type()) {
+            case NODE_VALUE:
+                result += std::to_string(static_cast<const Value<Value_t>*>(node)->value());
+                break;
+            case NODE_VARIABLE:
+                result += static_cast<const Variable<Value_t>*>(node)->name();
+                break;
+            case NODE_SIN:
+            case NODE_COS:
+            case NODE_LN:
+            case NODE_EXP:
+                stack.push_back({nullptr, ")"});
+                stack.push_back({node->operand(0).get(), nullptr});
+                stack.push_back({nullptr, operation_symbol(node->type())});
+                break;
+            default:
+                stack.push_back({nullptr, ")"});
+                stack.push_back({node->operand(1).get(), nullptr});
+                stack.push_back({nullptr, operation_symbol(node->type())});
+                stack.push_back({node->operand(0).get(), nullptr});
+                stack.push_back({nullptr, "("});
+                break;
+        }
+    }
+
+    return result;
+}
+
+const std::vector<std::string> &ExpressionGenerator::variables() const {
+    return variables_;
+}
+
+std::map<std::string, ExpressionGenerator::Value_t> ExpressionGenerator::point() {
+    std::map<std::string, Value_t> result;
+
+    for (const std::string &name : variables_) {
+        result[name] = options_.pointMin + (options_.pointMax - options_.pointMin) * Value_t(uniform_real());
+    }
+
+    return result;
+}
+
+DerivativeCheck ExpressionGenerator::check_derivative(const Expression<Value_t> &expr,
+                                                      const Expression<Value_t> &derivative,
+                                                      const std::string &by, size_t points, Value_t tolerance) {
+    // Вычисление по лентам не повторяет работу для общих подвыражений.
+    Tape<Value_t> function(expr);
+    Tape<Value_t> symbolic(derivative);
+
+    const std::vector<std::string> &names = function.variables();
+    size_t byIndex = std::find(names.begin(), names.end(), by) - names.begin();
+
+    std::vector<Value_t> values(names.size());
+    std::vector<Value_t> registers(function.size());
+
+    auto at = [&](Value_t value) {
+        if (byIndex < values.size()) values[byIndex] = value;
+        function.run(values.data(), registers.data());
+        return registers[function.outputs()[0]];
+    };
+
+    DerivativeCheck check{0, 0, 0, 0.0L};
+
+    for (size_t i = 0; i < points; i++) {
+        std::map<std::string, Value_t> context = point();
+        context.emplace(by, options_.pointMin);
+
+        for (size_t j = 0; j < names.size(); j++) {
+            values[j] = context.at(names[j]);
+        }
+        Value_t center = context[by];
+
+        // Большие промежуточные значения поглощают малые слагаемые при округлении,
+        // и разностная производная в такой точке не отражает символьную.
+        at(center);
+        bool conditioned = true;
+        for (Value_t value : registers) {
+            if (!(std::fabs(value) < ILL_CONDITIONED)) conditioned = false;
+        }
+        for (const TapeInstruction &instr : function.code()) {
+            bool periodic = instr.type == NODE_SIN || instr.type == NODE_COS;
+            if (periodic && !(std::fabs(registers[instr.left]) < LARGE_PHASE)) conditioned = false;
+        }
+
+        // Центральные разности с двумя шагами: их расхождение оценивает погрешность самой разности.
+        Value_t step = std::cbrt(LDBL_EPSILON) * std::max(1.0L, std::fabs(center));
+        Value_t coarse = (at(center + step) - at(center - step)) / (2 * step);
+        Value_t fine = (at(center + step / 2) - at(center - step / 2)) / step;
+
+        Value_t exact = symbolic.eval(context);
+        if (!conditioned || !std::isfinite(exact) || !std::isfinite(coarse) || !std::isfinite(fine) ||
+            std::fabs(coarse - fine) / std::max(1.0L, std::fabs(fine)) > tolerance) {
+            check.skipped++;
+            continue;
+        }
+
+        Value_t error = std::fabs(exact - fine) / std::max({1.0L, std::fabs(exact), std::fabs(fine)});
+        check.points++;
+        check.maxError = std::max(check.maxError, error);
+        if (error > tolerance) check.mismatches++;
+    }
+
+    return check;
+}
+
+uint64_t ExpressionGenerator::uniform(uint64_t bound) {
+    return bound == 0 ? 0 : random_() % bound;
+}
+
+double ExpressionGenerator::uniform_real() {
+    return double(random_() >> 11) * 0x1.0p-53;
+}
\ No newline at end of file
@@ -0,0 +1,122 @@
+#include <hash.hpp>
+
+#include <vector>
+#include <unordered_map>
+#include <set>
+#include <utility>
+#include <functional>
+#include <complex>
+
+namespace {
+
+// Перемешивание битов (финализатор splitmix64).
+uint64_t mix(uint64_t value) {
+    value += 0x9e3779b97f4a7c15ULL;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+    return value ^ (value >> 31);
+}
+
+uint64_t combine(uint64_t seed, uint64_t value) {
+    return mix(seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2)));
+}
+
+// Хеш числа по значению (байты выравнивания long double не учитываются).
+uint64_t hash_number(long double value) {
+    return std::hash<long double>{}(value);
+}
+
+uint64_t hash_number(std::complex<long double> value) {
+    return combine(hash_number(value.real()), hash_number(value.imag()));
+}
+
+// Хеш содержимого листа либо типа операции.
+template <typename Value_t>
+uint64_t hash_payload(const ExpressionImpl<Value_t> *node) {
+    uint64_t seed = mix(node->type());
+
+    if (node->type() == NODE_VALUE) {
+        return combine(seed, hash_number(static_cast<const Value<Value_t>*>(node)->value()));
+    }
+    if (node->type() == NODE_VARIABLE) {
+        return combine(seed, std::hash<std::string>{}(static_cast<const Variable<Value_t>*>(node)->name()));
+    }
+
+    return seed;
+}
+
+} // namespace
+
+template <typename Value_t>
+uint64_t structural_hash(const Expression<Value_t> &expr) {
+    // Хеши уже обработанных узлов: каждый разделяемый узел хешируется один раз.
+    std::unordered_map<const ExpressionImpl<Value_t>*, uint64_t> hashes;
+    std::vector<const ExpressionImpl<Value_t>*> stack{expr.impl().get()};
+
+    while (!stack.empty()) {
+        const ExpressionImpl<Value_t> *node = stack.back();
+
+        if (hashes.contains(node)) {
+            stack.pop_back();
+            continue;
+        }
+
+        bool ready = true;
+        for (size_t i = 0; i < node->arity(); i++) {
+            if (!hashes.contains(node->operand(i).get())) {
+                stack.push_back(node->operand(i).get());
+                ready = false;
+            }
+        }
+        if (!ready) continue;
+
+        stack.pop_back();
+
+        uint64_t hash = hash_payload(node);
+        for (size_t i = 0; i < node->arity(); i++) {
+            hash = combine(hash, hashes.at(node->operand(i).get()));
+        }
+        hashes.emplace(node, hash);
+    }
+
+    return hashes.at(expr.impl().get());
+}
+
+template <typename Value_t>
+bool structurally_equal(const Expression<Value_t> &first, const Expression<Value_t> &second) {
+    using NodePair = std::pair<const ExpressionImpl<Value_t>*, const ExpressionImpl<Value_t>*>;
+
+    // Уже сравненные пары узлов: разделяемые подвыражения сравниваются один раз.
+    std::set<NodePair> compared;
+    std::vector<NodePair> stack{{first.impl().get(), second.impl().get()}};
+
+    while (!stack.empty()) {
+        auto [left, right] = stack.back();
+        stack.pop_back();
+
+        if (left == right || !compared.insert({left, right}).second) continue;
+
+        if (left->type() != right->type()) return false;
+
+        if (left->type() == NODE_VALUE) {
+            if (static_cast<const Value<Value_t>*>(left)->value() !=
+                static_cast<const Value<Value_t>*>(right)->value()) return false;
+        }
+        else if (left->type() == NODE_VARIABLE) {
+            if (static_cast<const Variable<Value_t>*>(left)->name() !=
+                static_cast<const Variable<Value_t>*>(right)->name()) return false;
+        }
+
+        for (size_t i = 0; i < left->arity(); i++) {
+            stack.push_back({left->operand(i).get(), right->operand(i).get()});
+        }
+    }
+
+    return true;
+}
+
+template uint64_t structural_hash(const Expression<long double>&);
+template uint64_t structural_hash(const Expression<std::complex<long double>>&);
+
+template bool structurally_equal(const Expression<long double>&, const Expression<long double>&);
+template bool structurally_equal(const Expression<std::complex<long double>>&, const Expression<std::complex<long double>>&);
\ No newline at end of file
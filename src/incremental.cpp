@@ -0,0 +1,146 @@
+#include <incremental.hpp>
+
+#include <stdexcept>
+#include <complex>
+#include <algorithm>
+#include <bit>
+
+template <typename Value_t>
+IncrementalEvaluator<Value_t>::IncrementalEvaluator(const Expression<Value_t> &expr, std::map<std::string, Value_t> &context) :
+    tape_             (expr),
+    variableIndex_    (),
+    values_           (),
+    registers_        (tape_.size()),
+    dependentOffsets_ (),
+    dependents_       (),
+    dirty_            (),
+    pending_          (),
+    merged_           (),
+    recomputed_       (0)
+{
+    const std::vector<std::string> &variables = tape_.variables();
+    const std::vector<TapeInstruction> &code = tape_.code();
+
+    values_.reserve(variables.size());
+    for (size_t v = 0; v < variables.size(); v++) {
+        auto iter = context.find(variables[v]);
+
+        if (iter == context.end()) {
+            throw std::runtime_error("Variable \"" + variables[v] + "\" not present in evaluation context");
+        }
+
+        values_.push_back(iter->second);
+        variableIndex_.emplace(variables[v], static_cast<uint32_t>(v));
+    }
+
+    // Зависимости распространяются по ленте для блоков по 64 переменные: бит маски
+    // инструкции установлен, если от переменной зависит хотя бы один операнд.
+    // Второй проход по маскам блока раскладывает номера инструкций по спискам переменных.
+    std::vector<uint64_t> depends(code.size());
+    std::vector<uint32_t> cursor;
+
+    dependentOffsets_.assign(variables.size() + 1, 0);
+
+    for (size_t block = 0; block < variables.size(); block += 64) {
+        size_t width = std::min<size_t>(64, variables.size() - block);
+        cursor.assign(width, 0);
+
+        for (size_t i = 0; i < code.size(); i++) {
+            const TapeInstruction &instr = code[i];
+
+            switch (instr.type) {
+                case NODE_VALUE:
+                    depends[i] = 0;
+                    break;
+                case NODE_VARIABLE:
+                    depends[i] = instr.left >= block && instr.left < block + width ? 1ULL << (instr.left - block) : 0;
+                    break;
+                case NODE_ADD:
+                case NODE_SUB:
+                case NODE_MUL:
+                case NODE_DIV:
+                case NODE_POW:
+                    depends[i] = depends[instr.left] | depends[instr.right];
+                    break;
+                default:
+                    depends[i] = depends[instr.left];
+                    break;
+            }
+
+            for (uint64_t bits = depends[i]; bits != 0; bits &= bits - 1) {
+                cursor[std::countr_zero(bits)]++;
+            }
+        }
+
+        for (size_t b = 0; b < width; b++) {
+            uint32_t start = dependentOffsets_[block + b];
+            dependentOffsets_[block + b + 1] = start + cursor[b];
+            cursor[b] = start;
+        }
+        dependents_.resize(dependentOffsets_[block + width]);
+
+        for (size_t i = 0; i < code.size(); i++) {
+            for (uint64_t bits = depends[i]; bits != 0; bits &= bits - 1) {
+                dependents_[cursor[std::countr_zero(bits)]++] = static_cast<uint32_t>(i);
+            }
+        }
+    }
+
+    tape_.run(values_.data(), registers_.data());
+    recomputed_ = code.size();
+}
+
+template <typename Value_t>
+void IncrementalEvaluator<Value_t>::set(const std::string &name, Value_t value) {
+    auto iter = variableIndex_.find(name);
+    if (iter == variableIndex_.end()) return;
+
+    uint32_t v = iter->second;
+    if (values_[v] == value) return;
+
+    values_[v] = value;
+    dirty_.push_back(v);
+}
+
+template <typename Value_t>
+Value_t IncrementalEvaluator<Value_t>::value() {
+    if (!dirty_.empty()) {
+        // Объединение зависящих инструкций всех изменённых переменных в порядке ленты
+        // слиянием упорядоченных списков.
+        pending_.clear();
+        for (uint32_t v : dirty_) {
+            const uint32_t *next = dependents_.data() + dependentOffsets_[v];
+            const uint32_t *last = dependents_.data() + dependentOffsets_[v + 1];
+
+            merged_.clear();
+            size_t k = 0;
+            while (k < pending_.size() && next != last) {
+                if (pending_[k] < *next) {
+                    merged_.push_back(pending_[k++]);
+                }
+                else {
+                    if (pending_[k] == *next) k++;
+                    merged_.push_back(*next++);
+                }
+            }
+            merged_.insert(merged_.end(), pending_.begin() + k, pending_.end());
+            merged_.insert(merged_.end(), next, last);
+
+            pending_.swap(merged_);
+        }
+
+        tape_.run(values_.data(), registers_.data(), pending_);
+        recomputed_ = pending_.size();
+        dirty_.clear();
+    }
+
+    return registers_[tape_.outputs()[0]];
+}
+
+template <typename Value_t>
+size_t IncrementalEvaluator<Value_t>::recomputed() const {
+    return recomputed_;
+}
+
+template class IncrementalEvaluator<long double>;
+template class IncrementalEvaluator<std::complex<long double>>;
\ No newline at end of file
@@ -0,0 +1,177 @@
+#include <jacobian.hpp>
+
+#include <stdexcept>
+#include <complex>
+#include <set>
+
+template <typename Value_t>
+SparseJacobian<Value_t>::SparseJacobian(const std::vector<Expression<Value_t>> &functions,
+                                        const std::vector<std::string> &variables) :
+    variables_   (variables),
+    rowOffsets_  (),
+    columns_     (),
+    derivatives_ (),
+    tape_        (std::vector<Expression<Value_t>>{}),
+    positions_   ()
+{
+    build_pattern(functions);
+
+    for (size_t row = 0; row < functions.size(); row++) {
+        for (size_t k = rowOffsets_[row]; k < rowOffsets_[row + 1]; k++) {
+            derivatives_.push_back(functions[row].diff(variables_[columns_[k]]).prettify());
+        }
+    }
+
+    compile();
+}
+
+template <typename Value_t>
+SparseJacobian<Value_t>::SparseJacobian(const std::vector<Expression<Value_t>> &functions,
+                                        const std::vector<std::string> &variables, ThreadPool &pool) :
+    variables_   (variables),
+    rowOffsets_  (),
+    columns_     (),
+    derivatives_ (),
+    tape_        (std::vector<Expression<Value_t>>{}),
+    positions_   ()
+{
+    build_pattern(functions);
+
+    std::vector<size_t> rowOf(columns_.size());
+    for (size_t row = 0; row < functions.size(); row++) {
+        for (size_t k = rowOffsets_[row]; k < rowOffsets_[row + 1]; k++) rowOf[k] = row;
+    }
+
+    // Узлы выражений не изменяются после создания, поэтому элементы можно дифференцировать параллельно.
+    std::vector<std::shared_ptr<ExpressionImpl<Value_t>>> results(columns_.size());
+    pool.parallel_for(columns_.size(), [&](size_t k) {
+        results[k] = functions[rowOf[k]].diff(variables_[columns_[k]]).prettify().impl();
+    });
+    derivatives_.assign(results.begin(), results.end());
+
+    compile();
+}
+
+template <typename Value_t>
+void SparseJacobian<Value_t>::build_pattern(const std::vector<Expression<Value_t>> &functions) {
+    std::map<std::string, size_t> columnOf;
+    for (size_t column = 0; column < variables_.size(); column++) {
+        if (!columnOf.emplace(variables_[column], column).second) {
+            throw std::runtime_error("Variable \"" + variables_[column] + "\" is repeated in Jacobian");
+        }
+    }
+
+    rowOffsets_.push_back(0);
+    for (const Expression<Value_t> &function : functions) {
+        // Свободные переменные упорядочены по имени, а столбцы - по порядку переменных.
+        std::set<size_t> row;
+        for (const std::string &name : function.free_variables()) {
+            auto iter = columnOf.find(name);
+            if (iter != columnOf.end()) row.insert(iter->second);
+        }
+
+        columns_.insert(columns_.end(), row.begin(), row.end());
+        rowOffsets_.push_back(columns_.size());
+    }
+}
+
+template <typename Value_t>
+void SparseJacobian<Value_t>::compile() {
+    tape_ = Tape<Value_t>(derivatives_);
+
+    std::map<std::string, size_t> columnOf;
+    for (size_t column = 0; column < variables_.size(); column++) {
+        columnOf.emplace(variables_[column], column);
+    }
+
+    // Переменные вне набора матрицы (параметры) допустимы только при вычислении по контексту.
+    for (const std::string &name : tape_.variables()) {
+        auto iter = columnOf.find(name);
+        positions_.push_back(iter == columnOf.end() ? variables_.size() : iter->second);
+    }
+}
+
+template <typename Value_t>
+size_t SparseJacobian<Value_t>::rows() const {
+    return rowOffsets_.size() - 1;
+}
+
+template <typename Value_t>
+size_t SparseJacobian<Value_t>::cols() const {
+    return variables_.size();
+}
+
+template <typename Value_t>
+size_t SparseJacobian<Value_t>::nonzeros() const {
+    return columns_.size();
+}
+
+template <typename Value_t>
+const std::vector<size_t> &SparseJacobian<Value_t>::row_offsets() const {
+    return rowOffsets_;
+}
+
+template <typename Value_t>
+const std::vector<size_t> &SparseJacobian<Value_t>::columns() const {
+    return columns_;
+}
+
+template <typename Value_t>
+const std::vector<Expression<Value_t>> &SparseJacobian<Value_t>::derivatives() const {
+    return derivatives_;
+}
+
+template <typename Value_t>
+std::vector<size_t> SparseJacobian<Value_t>::row_indices() const {
+    std::vector<size_t> result;
+    result.reserve(columns_.size());
+
+    for (size_t row = 0; row + 1 < rowOffsets_.size(); row++) {
+        result.insert(result.end(), rowOffsets_[row + 1] - rowOffsets_[row], row);
+    }
+
+    return result;
+}
+
+template <typename Value_t>
+std::vector<Value_t> SparseJacobian<Value_t>::eval(std::map<std::string, Value_t> &context) const {
+    return tape_.eval_all(context);
+}
+
+template <typename Value_t>
+std::vector<std::vector<Value_t>> SparseJacobian<Value_t>::eval_batch(const std::vector<std::vector<Value_t>> &points) const {
+    for (size_t i = 0; i < positions_.size(); i++) {
+        if (positions_[i] == variables_.size()) {
+            throw std::runtime_error("Variable \"" + tape_.variables()[i] + "\" not present in evaluation context");
+        }
+    }
+
+    std::vector<Value_t> values(positions_.size());
+    std::vector<Value_t> registers(tape_.size());
+    std::vector<std::vector<Value_t>> result;
+    result.reserve(points.size());
+
+    for (const std::vector<Value_t> &point : points) {
+        if (point.size() != variables_.size()) {
+            throw std::runtime_error("Point has " + std::to_string(point.size()) + " values, expected " +
+                                     std::to_string(variables_.size()));
+        }
+
+        for (size_t i = 0; i < positions_.size(); i++) {
+            values[i] = point[positions_[i]];
+        }
+        tape_.run(values.data(), registers.data());
+
+        std::vector<Value_t> entries;
+        entries.reserve(tape_.outputs().size());
+        for (uint32_t output : tape_.outputs()) {
+            entries.push_back(registers[output]);
+        }
+        result.push_back(std::move(entries));
+    }
+
+    return result;
+}
+
+template class SparseJacobian<long double>;
+template class SparseJacobian<std::complex<long double>>;
\ No newline at end of file
@@ -5,13 +5,38 @@ Lexer::Lexer(const std::string& input) :
     input_  (input),
     pos_    (),
     end_    (),
-    column_ (0)
+    column_ (0),
+    replay_ (false),
+    tokens_ (),
+    next_   (0)
 {
     pos_ = input_.c_str();
     end_ = pos_ + input_.size();
 }
 
+Lexer::Lexer(std::vector<Token> tokens) :
+    Lexer(std::string())
+{
+    replay_ = true;
+    tokens_ = std::move(tokens);
+}
+
+std::vector<Token> Lexer::tokenize() {
+    std::vector<Token> tokens;
+
+    do {
+        tokens.push_back(getNextToken());
+    } while (tokens.back().type != TOK_EOF);
+
+    return tokens;
+}
+
 Token Lexer::getNextToken() {
+    // Выдача заранее считанных лексем.
+    if (replay_) {
+        return next_ < tokens_.size() ? std::move(tokens_[next_++]) : Token{TOK_EOF, "", column_};
+    }
+
     // Пропускаем пробельные символы до начала лексемы.
     skipSpaceSequence();
 
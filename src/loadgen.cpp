@@ -0,0 +1,125 @@
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// Генератор нагрузки для серверного режима: несколько соединений параллельно
+// отправляют один и тот же запрос и измеряют время до получения ответа.
+
+// Подключение к серверу по локальному сокету.
+int connect_to(const std::string &path) {
+    int connection = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (connection < 0) return -1;
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+    if (connect(connection, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        close(connection);
+        return -1;
+    }
+
+    return connection;
+}
+
+// Отправка запроса и чтение строки ответа.
+bool roundtrip(int connection, const std::string &request, std::string &response) {
+    for (size_t sent = 0; sent < request.size();) {
+        ssize_t written = send(connection, request.data() + sent, request.size() - sent, MSG_NOSIGNAL);
+        if (written <= 0) return false;
+        sent += size_t(written);
+    }
+
+    response.clear();
+    char chunk[4096];
+    while (response.empty() || response.back() != '\n') {
+        ssize_t received = recv(connection, chunk, sizeof(chunk), 0);
+        if (received <= 0) return false;
+        response.append(chunk, size_t(received));
+    }
+
+    return true;
+}
+
+// Значение процентиля по отсортированной выборке.
+double percentile(const std::vector<double> &sorted, double fraction) {
+    if (sorted.empty()) return 0.0;
+
+    size_t index = static_cast<size_t>(fraction * double(sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 5) {
+        fprintf(stderr, "Usage: loadgen <socket> <connections> <requests per connection> <request>\n");
+        return EXIT_FAILURE;
+    }
+
+    std::string path = argv[1];
+    size_t connections = std::stoul(argv[2]);
+    size_t requests = std::stoul(argv[3]);
+    std::string request = std::string(argv[4]) + "\n";
+
+    // Задержки каждого соединения собираются отдельно, чтобы не синхронизировать потоки.
+    std::vector<std::vector<double>> latencies(connections);
+    std::atomic<size_t> failures{0};
+    std::atomic<size_t> errors{0};
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> clients;
+    for (size_t c = 0; c < connections; c++) {
+        clients.emplace_back([&, c] {
+            int connection = connect_to(path);
+            if (connection < 0) {
+                failures += requests;
+                return;
+            }
+
+            std::string response;
+            for (size_t r = 0; r < requests; r++) {
+                auto sendTime = std::chrono::steady_clock::now();
+                if (!roundtrip(connection, request, response)) {
+                    failures += requests - r;
+                    break;
+                }
+                auto receiveTime = std::chrono::steady_clock::now();
+
+                latencies[c].push_back(std::chrono::duration<double, std::micro>(receiveTime - sendTime).count());
+                if (response.compare(0, 3, "ERR") == 0) errors++;
+            }
+
+            close(connection);
+        });
+    }
+
+    for (std::thread &client : clients) {
+        client.join();
+    }
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<double> all;
+    for (const std::vector<double> &part : latencies) {
+        all.insert(all.end(), part.begin(), part.end());
+    }
+    std::sort(all.begin(), all.end());
+
+    printf("requests    %zu (failed %zu, error responses %zu)\n", all.size(), failures.load(), errors.load());
+    printf("throughput  %.1f req/s\n", double(all.size()) / elapsed);
+    printf("latency us  p50 %.1f  p90 %.1f  p99 %.1f  p99.9 %.1f  max %.1f\n",
+           percentile(all, 0.50), percentile(all, 0.90), percentile(all, 0.99),
+           percentile(all, 0.999), all.empty() ? 0.0 : all.back());
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include <parser.hpp>
 
 #include <stdexcept>
+#include <utility>
 
 template <typename Value_t>
 Parser<Value_t>::Parser(Lexer& lexer) :
@@ -70,7 +71,7 @@ Expression<Value_t> Parser<Value_t>::parseExpr() {
             Expression<Value_t> term = parseTerm();
 
             // Обновляем выражение для суммы.
-            expr += term;
+            expr += std::move(term);
         }
         else {
             // Считываем символ '-' в обязательном порядке.
@@ -80,7 +81,7 @@ Expression<Value_t> Parser<Value_t>::parseExpr() {
             Expression<Value_t> term = parseTerm();
 
             // Обновляем выражение для суммы.
-            expr -= term;
+            expr -= std::move(term);
         }
     }
 
@@ -103,7 +104,7 @@ Expression<Value_t> Parser<Value_t>::parseTerm() {
             Expression<Value_t> factor = parseFactor();
 
             // Обновляем выражение для произведения.
-            term *= factor;
+            term *= std::move(factor);
         }
         else {
             // Считываем символ '/' в обязательном порядке.
@@ -113,7 +114,7 @@ Expression<Value_t> Parser<Value_t>::parseTerm() {
             Expression<Value_t> factor = parseFactor();
 
             // Обновляем выражение для произведения.
-            term /= factor;
+            term /= std::move(factor);
         }
     }
 
@@ -135,7 +136,7 @@ Expression<Value_t> Parser<Value_t>::parseFactor() {
         Expression<Value_t> power = parsePower();
 
         // Обновляем выражение для степени.
-        factor ^= power;
+        factor ^= std::move(power);
     }
 
     return factor;
@@ -0,0 +1,393 @@
+#include <polynomial.hpp>
+
+#include <cmath>
+#include <complex>
+#include <unordered_map>
+
+namespace {
+
+// Результат анализа узла: многочлен (variable пусто для постоянных) либо не многочлен.
+// expanded - многочлен записан в раскрытом виде (суммы одночленов), см. is_expanded.
+template <typename Value_t>
+struct Analysis {
+    bool polynomial;
+    std::string variable;
+    std::vector<Value_t> coefficients;
+    bool expanded = false;
+};
+
+template <typename Value_t>
+Analysis<Value_t> not_polynomial() {
+    return Analysis<Value_t>{false, "", {}};
+}
+
+template <typename Value_t>
+bool is_constant(const Analysis<Value_t> &analysis) {
+    return analysis.polynomial && analysis.coefficients.size() == 1;
+}
+
+// Общая переменная двух многочленов; false, если переменные различны.
+template <typename Value_t>
+bool unify(const Analysis<Value_t> &left, const Analysis<Value_t> &right, std::string &variable) {
+    if (!left.polynomial || !right.polynomial) return false;
+    if (!left.variable.empty() && !right.variable.empty() && left.variable != right.variable) return false;
+
+    variable = left.variable.empty() ? right.variable : left.variable;
+    return true;
+}
+
+// Удаление нулевых старших коэффициентов.
+template <typename Value_t>
+Analysis<Value_t> normalized(Analysis<Value_t> analysis) {
+    while (analysis.coefficients.size() > 1 && analysis.coefficients.back() == Value_t(0.0)) {
+        analysis.coefficients.pop_back();
+    }
+    if (analysis.coefficients.size() == 1) analysis.variable.clear();
+    return analysis;
+}
+
+template <typename Value_t>
+Analysis<Value_t> multiply(const Analysis<Value_t> &left, const Analysis<Value_t> &right, const std::string &variable) {
+    if (left.coefficients.size() + right.coefficients.size() - 2 > Polynomial<Value_t>::MAX_DEGREE) {
+        return not_polynomial<Value_t>();
+    }
+
+    std::vector<Value_t> product(left.coefficients.size() + right.coefficients.size() - 1, Value_t(0.0));
+    for (size_t i = 0; i < left.coefficients.size(); i++) {
+        for (size_t j = 0; j < right.coefficients.size(); j++) {
+            product[i + j] += left.coefficients[i] * right.coefficients[j];
+        }
+    }
+
+    return normalized(Analysis<Value_t>{true, variable, product});
+}
+
+// Натуральный показатель степени.
+template <typename Value_t>
+bool natural_exponent(const Value_t &exponent, size_t &power) {
+    long double real = std::real(exponent);
+    if (std::imag(exponent) != 0 || real < 0 || real > Polynomial<Value_t>::MAX_DEGREE || real != std::floor(real)) {
+        return false;
+    }
+
+    power = static_cast<size_t>(real);
+    return true;
+}
+
+template <typename Value_t>
+Analysis<Value_t> analyze_node(const ExpressionImpl<Value_t> *node, const Analysis<Value_t> *left,
+                               const Analysis<Value_t> *right) {
+    std::string variable;
+
+    switch (node->type()) {
+        case NODE_VALUE:
+            return Analysis<Value_t>{true, "", {static_cast<const Value<Value_t>*>(node)->value()}};
+        case NODE_VARIABLE:
+            return Analysis<Value_t>{true, static_cast<const Variable<Value_t>*>(node)->name(),
+                                     {Value_t(0.0), Value_t(1.0)}};
+        case NODE_ADD:
+        case NODE_SUB: {
+            if (!unify(*left, *right, variable)) return not_polynomial<Value_t>();
+
+            Value_t sign = node->type() == NODE_ADD ? Value_t(1.0) : Value_t(-1.0);
+            std::vector<Value_t> sum(std::max(left->coefficients.size(), right->coefficients.size()), Value_t(0.0));
+            for (size_t i = 0; i < left->coefficients.size(); i++)  sum[i] += left->coefficients[i];
+            for (size_t i = 0; i < right->coefficients.size(); i++) sum[i] += sign * right->coefficients[i];
+
+            return normalized(Analysis<Value_t>{true, variable, sum});
+        }
+        case NODE_MUL:
+            if (!unify(*left, *right, variable)) return not_polynomial<Value_t>();
+            return multiply(*left, *right, variable);
+        case NODE_DIV: {
+            if (!left->polynomial || !is_constant(*right)) return not_polynomial<Value_t>();
+
+            Analysis<Value_t> quotient = *left;
+            for (Value_t &coefficient : quotient.coefficients) coefficient /= right->coefficients[0];
+            return normalized(quotient);
+        }
+        case NODE_POW: {
+            size_t power = 0;
+            if (!left->polynomial || !is_constant(*right)) return not_polynomial<Value_t>();
+            if (is_constant(*left)) {
+                return Analysis<Value_t>{true, "", {pow(left->coefficients[0], right->coefficients[0])}};
+            }
+            if (!natural_exponent(right->coefficients[0], power)) return not_polynomial<Value_t>();
+
+            Analysis<Value_t> result{true, "", {Value_t(1.0)}};
+            for (size_t i = 0; i < power && result.polynomial; i++) {
+                result = multiply(result, *left, left->variable);
+            }
+            return result;
+        }
+        case NODE_SIN:
+        case NODE_COS:
+        case NODE_LN:
+        case NODE_EXP: {
+            // Функции от числа сворачиваются в число.
+            if (!is_constant(*left)) return not_polynomial<Value_t>();
+
+            Value_t argument = left->coefficients[0];
+            switch (node->type()) {
+                case NODE_SIN: return Analysis<Value_t>{true, "", {sin(argument)}};
+                case NODE_COS: return Analysis<Value_t>{true, "", {cos(argument)}};
+                case NODE_LN:  return Analysis<Value_t>{true, "", {log(argument)}};
+                default:       return Analysis<Value_t>{true, "", {exp(argument)}};
+            }
+        }
+    }
+
+    return not_polynomial<Value_t>();
+}
+
+// Одночлен c x^k (в том числе число).
+template <typename Value_t>
+bool is_monomial(const Analysis<Value_t> &analysis) {
+    size_t terms = 0;
+    for (const Value_t &coefficient : analysis.coefficients) {
+        if (coefficient != Value_t(0.0)) terms++;
+    }
+    return analysis.polynomial && terms <= 1;
+}
+
+// Многочлен уже записан суммой одночленов, и схема Горнера не раскрывает скобок.
+// Степени и произведения многочленов, не являющихся одночленами ((x - 1)^20, (x - 1)(x + 1)),
+// при раскрытии теряют точность вблизи корней, поэтому сохраняются.
+template <typename Value_t>
+bool is_expanded(const ExpressionImpl<Value_t> *node, const Analysis<Value_t> &analysis,
+                 const Analysis<Value_t> *left, const Analysis<Value_t> *right) {
+    if (!analysis.polynomial) return false;
+    if (is_constant(analysis)) return true;
+
+    switch (node->type()) {
+        case NODE_VARIABLE: return true;
+        case NODE_ADD:
+        case NODE_SUB:      return left->expanded && right->expanded;
+        case NODE_MUL:      return left->expanded && right->expanded && (is_monomial(*left) || is_monomial(*right));
+        case NODE_DIV:      return left->expanded;
+        case NODE_POW:      return left->expanded && is_monomial(*left);
+        default:            return false;
+    }
+}
+
+// Анализ всех различных узлов выражения (обход с явным стеком).
+template <typename Value_t>
+std::unordered_map<const ExpressionImpl<Value_t>*, Analysis<Value_t>> analyze(const ExpressionImpl<Value_t> *root) {
+    std::unordered_map<const ExpressionImpl<Value_t>*, Analysis<Value_t>> analyzed;
+    std::vector<const ExpressionImpl<Value_t>*> stack{root};
+
+    while (!stack.empty()) {
+        const ExpressionImpl<Value_t> *node = stack.back();
+        if (analyzed.contains(node)) {
+            stack.pop_back();
+            continue;
+        }
+
+        bool ready = true;
+        for (size_t i = 0; i < node->arity(); i++) {
+            if (!analyzed.contains(node->operand(i).get())) {
+                stack.push_back(node->operand(i).get());
+                ready = false;
+            }
+        }
+        if (!ready) continue;
+
+        stack.pop_back();
+
+        const Analysis<Value_t> *left  = node->arity() > 0 ? &analyzed.at(node->operand(0).get()) : nullptr;
+        const Analysis<Value_t> *right = node->arity() > 1 ? &analyzed.at(node->operand(1).get()) : nullptr;
+        Analysis<Value_t> analysis = analyze_node(node, left, right);
+        analysis.expanded = is_expanded(node, analysis, left, right);
+        analyzed.emplace(node, analysis);
+    }
+
+    return analyzed;
+}
+
+// Узел того же типа с новыми операндами.
+template <typename Value_t>
+std::shared_ptr<ExpressionImpl<Value_t>> rebuild(const ExpressionImpl<Value_t> *node,
+                                                 const std::shared_ptr<ExpressionImpl<Value_t>> &left,
+                                                 const std::shared_ptr<ExpressionImpl<Value_t>> &right) {
+    switch (node->type()) {
+        case NODE_ADD: return std::make_shared<OperationAdd<Value_t>>(left, right);
+        case NODE_SUB: return std::make_shared<OperationSub<Value_t>>(left, right);
+        case NODE_MUL: return std::make_shared<OperationMul<Value_t>>(left, right);
+        case NODE_DIV: return std::make_shared<OperationDiv<Value_t>>(left, right);
+        case NODE_POW: return make_power(left, right);
+        case NODE_SIN: return std::make_shared<OperationSin<Value_t>>(left);
+        case NODE_COS: return std::make_shared<OperationCos<Value_t>>(left);
+        case NODE_LN:  return std::make_shared<OperationLn<Value_t>>(left);
+        case NODE_EXP: return std::make_shared<OperationExp<Value_t>>(left);
+        default:       return nullptr;
+    }
+}
+
+} // namespace
+
+//==================//
+// Класс Polynomial //
+//==================//
+
+template <typename Value_t>
+Polynomial<Value_t>::Polynomial(const std::string &variable, const std::vector<Value_t> &coefficients) :
+    variable_     (variable),
+    coefficients_ (coefficients)
+{
+    if (coefficients_.empty()) coefficients_.push_back(Value_t(0.0));
+}
+
+template <typename Value_t>
+bool Polynomial<Value_t>::recognize(const Expression<Value_t> &expr, Polynomial &result) {
+    Analysis<Value_t> analysis = analyze(expr.impl().get()).at(expr.impl().get());
+    if (!analysis.polynomial) return false;
+
+    result = Polynomial(analysis.variable, analysis.coefficients);
+    return true;
+}
+
+template <typename Value_t>
+const std::string &Polynomial<Value_t>::variable() const {
+    return variable_;
+}
+
+template <typename Value_t>
+const std::vector<Value_t> &Polynomial<Value_t>::coefficients() const {
+    return coefficients_;
+}
+
+template <typename Value_t>
+size_t Polynomial<Value_t>::degree() const {
+    return coefficients_.size() - 1;
+}
+
+template <typename Value_t>
+Value_t Polynomial<Value_t>::eval(Value_t x) const {
+    Value_t result = coefficients_.back();
+    for (size_t i = coefficients_.size() - 1; i-- > 0;) {
+        result = result * x + coefficients_[i];
+    }
+    return result;
+}
+
+template <typename Value_t>
+Value_t Polynomial<Value_t>::eval_estrin(Value_t x) const {
+    std::vector<Value_t> terms = coefficients_;
+
+    // На каждом шаге пары (a + b x) независимы, а x заменяется на x^2.
+    while (terms.size() > 1) {
+        size_t half = (terms.size() + 1) / 2;
+        for (size_t i = 0; i < half; i++) {
+            terms[i] = 2 * i + 1 < terms.size() ? terms[2 * i] + terms[2 * i + 1] * x : terms[2 * i];
+        }
+        terms.resize(half);
+        x = x * x;
+    }
+
+    return terms[0];
+}
+
+template <typename Value_t>
+void Polynomial<Value_t>::eval(const Value_t *points, Value_t *results, size_t count) const {
+    for (size_t j = 0; j < count; j++) {
+        results[j] = coefficients_.back();
+    }
+    for (size_t i = coefficients_.size() - 1; i-- > 0;) {
+        const Value_t coefficient = coefficients_[i];
+        for (size_t j = 0; j < count; j++) {
+            results[j] = results[j] * points[j] + coefficient;
+        }
+    }
+}
+
+template <typename Value_t>
+Polynomial<Value_t> Polynomial<Value_t>::derivative() const {
+    std::vector<Value_t> result;
+    for (size_t i = 1; i < coefficients_.size(); i++) {
+        result.push_back(Value_t(double(i)) * coefficients_[i]);
+    }
+
+    return Polynomial(result.size() > 1 ? variable_ : "", result);
+}
+
+template <typename Value_t>
+Expression<Value_t> Polynomial<Value_t>::to_expression() const {
+    std::shared_ptr<ExpressionImpl<Value_t>> result = std::make_shared<Value<Value_t>>(coefficients_.back());
+    if (coefficients_.size() == 1) return Expression<Value_t>(result);
+
+    std::shared_ptr<ExpressionImpl<Value_t>> x = std::make_shared<Variable<Value_t>>(variable_);
+    bool one = coefficients_.back() == Value_t(1.0);
+
+    for (size_t i = coefficients_.size() - 1; i-- > 0;) {
+        result = one ? x : std::make_shared<OperationMul<Value_t>>(result, x);
+        one = false;
+
+        if (coefficients_[i] != Value_t(0.0)) {
+            result = std::make_shared<OperationAdd<Value_t>>(result, std::make_shared<Value<Value_t>>(coefficients_[i]));
+        }
+    }
+
+    return Expression<Value_t>(result);
+}
+
+template class Polynomial<long double>;
+template class Polynomial<std::complex<long double>>;
+
+//=============================//
+// Приведение к схеме Горнера //
+//=============================//
+
+template <typename Value_t>
+Expression<Value_t> horner_form(const Expression<Value_t> &expr) {
+    std::unordered_map<const ExpressionImpl<Value_t>*, Analysis<Value_t>> analyzed = analyze(expr.impl().get());
+    std::unordered_map<const ExpressionImpl<Value_t>*, std::shared_ptr<ExpressionImpl<Value_t>>> rewritten;
+
+    // Операнды переписываются раньше узла; порядок обхода тот же, что и при анализе.
+    std::vector<const std::shared_ptr<ExpressionImpl<Value_t>>*> stack{&expr.impl()};
+
+    while (!stack.empty()) {
+        const std::shared_ptr<ExpressionImpl<Value_t>> &node = *stack.back();
+        if (rewritten.contains(node.get())) {
+            stack.pop_back();
+            continue;
+        }
+
+        const Analysis<Value_t> &analysis = analyzed.at(node.get());
+        bool replace = analysis.expanded && node->arity() > 0 &&
+                       (analysis.coefficients.size() > 2 || analysis.variable.empty());
+        if (replace) {
+            stack.pop_back();
+            rewritten.emplace(node.get(), Polynomial<Value_t>(analysis.variable, analysis.coefficients).to_expression().impl());
+            continue;
+        }
+
+        bool ready = true;
+        for (size_t i = 0; i < node->arity(); i++) {
+            if (!rewritten.contains(node->operand(i).get())) {
+                stack.push_back(&node->operand(i));
+                ready = false;
+            }
+        }
+        if (!ready) continue;
+
+        stack.pop_back();
+
+        std::shared_ptr<ExpressionImpl<Value_t>> result = node;
+        if (node->arity() > 0) {
+            const std::shared_ptr<ExpressionImpl<Value_t>> &left = rewritten.at(node->operand(0).get());
+            const std::shared_ptr<ExpressionImpl<Value_t>> &right =
+                node->arity() > 1 ? rewritten.at(node->operand(1).get()) : left;
+
+            // Узел без изменившихся операндов остаётся прежним.
+            if (left != node->operand(0) || (node->arity() > 1 && right != node->operand(1))) {
+                result = rebuild(node.get(), left, right);
+            }
+        }
+        rewritten.emplace(node.get(), result);
+    }
+
+    return Expression<Value_t>(rewritten.at(expr.impl().get()));
+}
+
+template Expression<long double> horner_form(const Expression<long double> &expr);
+template Expression<std::complex<long double>> horner_form(const Expression<std::complex<long double>> &expr);
\ No newline at end of file
@@ -0,0 +1,213 @@
+#include <profiler.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace {
+
+// Счётчик тактов процессора (при его отсутствии - наносекунды).
+inline uint64_t read_cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// Признак отсутствия операнда в дереве путей (корень не бывает операндом).
+const uint32_t NO_PATH = 0;
+
+} // namespace
+
+const char *node_type_name(NodeType type) {
+    switch (type) {
+        case NODE_VALUE:    return "Value";
+        case NODE_VARIABLE: return "Variable";
+        case NODE_ADD:      return "OperationAdd";
+        case NODE_SUB:      return "OperationSub";
+        case NODE_MUL:      return "OperationMul";
+        case NODE_DIV:      return "OperationDiv";
+        case NODE_POW:      return "OperationPow";
+        case NODE_SIN:      return "OperationSin";
+        case NODE_COS:      return "OperationCos";
+        case NODE_LN:       return "OperationLn";
+        case NODE_EXP:      return "OperationExp";
+        default:            return "Unknown";
+    }
+}
+
+template <typename Value_t>
+Profiler<Value_t>::Profiler(const Expression<Value_t> &expr) :
+    expr_  (expr),
+    paths_ ()
+{
+    reset();
+}
+
+template <typename Value_t>
+void Profiler<Value_t>::reset() {
+    paths_.clear();
+    paths_.push_back(Path{expr_.impl().get(), NO_PATH, 0, {NO_PATH, NO_PATH}, 0, 0});
+}
+
+template <typename Value_t>
+Value_t Profiler<Value_t>::eval(std::map<std::string, Value_t> &context) {
+    return visit(0, context);
+}
+
+template <typename Value_t>
+uint32_t Profiler<Value_t>::child(uint32_t path, uint32_t slot) {
+    if (paths_[path].children[slot] == NO_PATH) {
+        const ExpressionImpl<Value_t> *operand = paths_[path].node->operand(slot).get();
+
+        paths_[path].children[slot] = static_cast<uint32_t>(paths_.size());
+        paths_.push_back(Path{operand, path, slot, {NO_PATH, NO_PATH}, 0, 0});
+    }
+
+    return paths_[path].children[slot];
+}
+
+template <typename Value_t>
+Value_t Profiler<Value_t>::visit(uint32_t root, std::map<std::string, Value_t> &context) {
+    // Обход с явным стеком, чтобы глубина выражения не ограничивалась стеком вызовов.
+    // Кадр хранит номер пути, момент входа в узел и количество уже вычисленных операндов.
+    struct Frame {
+        uint32_t path;
+        uint64_t start;
+        size_t done;
+    };
+
+    std::vector<Frame> stack{{root, read_cycles(), 0}};
+    std::vector<Value_t> values;
+
+    while (!stack.empty()) {
+        // Ссылки на элементы paths_ и stack не сохраняются: векторы растут при обходе операндов.
+        uint32_t path = stack.back().path;
+        const ExpressionImpl<Value_t> *node = paths_[path].node;
+
+        if (stack.back().done < node->arity()) {
+            uint32_t operand = child(path, static_cast<uint32_t>(stack.back().done++));
+            stack.push_back(Frame{operand, read_cycles(), 0});
+            continue;
+        }
+
+        Value_t result;
+
+        switch (node->type()) {
+            case NODE_VALUE:
+            case NODE_VARIABLE:
+                result = node->eval(context);
+                break;
+            case NODE_SIN: result = sin(values.back()); values.pop_back(); break;
+            case NODE_COS: result = cos(values.back()); values.pop_back(); break;
+            case NODE_LN:  result = log(values.back()); values.pop_back(); break;
+            case NODE_EXP: result = exp(values.back()); values.pop_back(); break;
+            default: {
+                Value_t right = values.back();
+                values.pop_back();
+                Value_t left  = values.back();
+                values.pop_back();
+
+                switch (node->type()) {
+                    case NODE_ADD: result = left + right;     break;
+                    case NODE_SUB: result = left - right;     break;
+                    case NODE_MUL: result = left * right;     break;
+                    case NODE_DIV: result = left / right;     break;
+                    default:       result = pow(left, right); break;
+                }
+                break;
+            }
+        }
+
+        paths_[path].calls++;
+        paths_[path].cycles += read_cycles() - stack.back().start;
+
+        stack.pop_back();
+        values.push_back(result);
+    }
+
+    return values.back();
+}
+
+template <typename Value_t>
+uint64_t Profiler<Value_t>::children_cycles(const Path &path) const {
+    uint64_t cycles = 0;
+    for (uint32_t child : path.children) {
+        if (child != NO_PATH) cycles += paths_[child].cycles;
+    }
+    return cycles;
+}
+
+template <typename Value_t>
+std::map<NodeType, ProfileCounters> Profiler<Value_t>::by_type() const {
+    std::map<NodeType, ProfileCounters> result;
+
+    for (const Path &path : paths_) {
+        ProfileCounters &counters = result[path.node->type()];
+        counters.calls += path.calls;
+        counters.cycles += path.cycles;
+        counters.selfCycles += path.cycles - children_cycles(path);
+    }
+
+    return result;
+}
+
+template <typename Value_t>
+std::unordered_map<const ExpressionImpl<Value_t>*, ProfileCounters> Profiler<Value_t>::by_node() const {
+    std::unordered_map<const ExpressionImpl<Value_t>*, ProfileCounters> result;
+
+    for (const Path &path : paths_) {
+        ProfileCounters &counters = result[path.node];
+        counters.calls += path.calls;
+        counters.cycles += path.cycles;
+        counters.selfCycles += path.cycles - children_cycles(path);
+    }
+
+    return result;
+}
+
+template <typename Value_t>
+std::string Profiler<Value_t>::folded() const {
+    std::string result;
+
+    // Обход дерева путей в глубину; для каждого пути хранится длина стека его родителя.
+    std::vector<std::pair<uint32_t, size_t>> pending{{0, 0}};
+    std::string stack;
+
+    while (!pending.empty()) {
+        auto [index, prefix] = pending.back();
+        pending.pop_back();
+
+        const Path &path = paths_[index];
+
+        stack.resize(prefix);
+        if (index != 0) {
+            stack += ";";
+        }
+        stack += node_type_name(path.node->type());
+        if (index != 0) {
+            stack += "#" + std::to_string(path.slot);
+        }
+
+        uint64_t self = path.cycles - children_cycles(path);
+        if (self > 0) {
+            result += stack + " " + std::to_string(self) + "\n";
+        }
+
+        for (size_t slot = 2; slot-- > 0;) {
+            if (path.children[slot] != NO_PATH) pending.emplace_back(path.children[slot], stack.size());
+        }
+    }
+
+    return result;
+}
+
+template class Profiler<long double>;
+template class Profiler<std::complex<long double>>;
\ No newline at end of file
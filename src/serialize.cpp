@@ -0,0 +1,262 @@
+#include <serialize.hpp>
+
+#include <stdexcept>
+#include <fstream>
+#include <complex>
+#include <cstring>
+#include <cstddef>
+#include <cstdint>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Записи узлов переносятся между файлом и лентой побайтово.
+static_assert(sizeof(TapeInstruction) == 12);
+static_assert(offsetof(TapeInstruction, left)  == 4);
+static_assert(offsetof(TapeInstruction, right) == 8);
+
+namespace {
+
+// Выравнивание секций двоичного файла.
+constexpr size_t SECTION_ALIGNMENT = 16;
+
+// Арифметика смещений с проверкой переполнения: размеры в заголовке не доверенные.
+bool checked_add(size_t a, uint64_t b, size_t &result) {
+    return b <= SIZE_MAX && !__builtin_add_overflow(a, size_t(b), &result);
+}
+
+bool checked_section(size_t offset, uint64_t count, size_t size, size_t &result) {
+    size_t bytes = 0;
+    return count <= SIZE_MAX && !__builtin_mul_overflow(size_t(count), size, &bytes) &&
+           checked_add(offset, bytes, result);
+}
+
+bool align_section(size_t offset, size_t &result) {
+    if (!checked_add(offset, SECTION_ALIGNMENT - 1, result)) {
+        return false;
+    }
+    result = result / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+    return true;
+}
+
+// Вид чисел в таблице констант.
+template <typename Value_t> constexpr uint32_t value_kind = 0;
+template <> constexpr uint32_t value_kind<std::complex<long double>> = 1;
+
+// Смещения секций относительно начала файла.
+struct SectionLayout {
+    size_t nodes;
+    size_t outputs;
+    size_t constants;
+    size_t nameOffsets;
+    size_t names;
+    size_t end;
+};
+
+// false, если смещения не помещаются в size_t.
+template <typename Value_t>
+bool layout(const BinaryHeader &header, SectionLayout &sections) {
+    size_t offset = 0;
+
+    return align_section(sizeof(BinaryHeader), sections.nodes) &&
+           checked_section(sections.nodes, header.node_count, sizeof(TapeInstruction), offset) &&
+           align_section(offset, sections.outputs) &&
+           checked_section(sections.outputs, header.output_count, sizeof(uint32_t), offset) &&
+           align_section(offset, sections.constants) &&
+           checked_section(sections.constants, header.constant_count, sizeof(Value_t), offset) &&
+           align_section(offset, sections.nameOffsets) &&
+           checked_section(sections.nameOffsets, uint64_t(header.variable_count) + 1, sizeof(uint32_t), sections.names) &&
+           checked_add(sections.names, header.names_size, sections.end);
+}
+
+} // namespace
+
+//===========================//
+// Сохранение в двоичный вид //
+//===========================//
+
+template <typename Value_t>
+void save_binary(const std::string &path, const Tape<Value_t> &tape) {
+    BinaryHeader header{};
+    header.magic          = BINARY_MAGIC;
+    header.version        = BINARY_VERSION;
+    header.value_size     = sizeof(Value_t);
+    header.value_kind     = value_kind<Value_t>;
+    header.node_count     = static_cast<uint32_t>(tape.code().size());
+    header.output_count   = static_cast<uint32_t>(tape.outputs().size());
+    header.constant_count = static_cast<uint32_t>(tape.constants().size());
+    header.variable_count = static_cast<uint32_t>(tape.variables().size());
+
+    for (const std::string &name : tape.variables()) {
+        header.names_size += name.size();
+    }
+
+    SectionLayout sections{};
+    if (!layout<Value_t>(header, sections)) {
+        throw std::runtime_error("Binary expression file \"" + path + "\" is too large");
+    }
+
+    // Неиспользуемые байты (выравнивание секций и записей) заполняются нулями.
+    std::string buffer(sections.end, '\0');
+    char *data = buffer.data();
+
+    std::memcpy(data, &header, sizeof(header));
+
+    for (size_t i = 0; i < tape.code().size(); i++) {
+        const TapeInstruction &instr = tape.code()[i];
+        char *record = data + sections.nodes + i * sizeof(TapeInstruction);
+
+        std::memcpy(record + offsetof(TapeInstruction, type),  &instr.type,  sizeof(instr.type));
+        std::memcpy(record + offsetof(TapeInstruction, left),  &instr.left,  sizeof(instr.left));
+        std::memcpy(record + offsetof(TapeInstruction, right), &instr.right, sizeof(instr.right));
+    }
+
+    std::memcpy(data + sections.outputs, tape.outputs().data(), tape.outputs().size() * sizeof(uint32_t));
+    std::memcpy(data + sections.constants, tape.constants().data(), tape.constants().size() * sizeof(Value_t));
+
+    uint32_t nameOffset = 0;
+    for (size_t i = 0; i < tape.variables().size(); i++) {
+        const std::string &name = tape.variables()[i];
+
+        std::memcpy(data + sections.nameOffsets + i * sizeof(uint32_t), &nameOffset, sizeof(uint32_t));
+        std::memcpy(data + sections.names + nameOffset, name.data(), name.size());
+        nameOffset += static_cast<uint32_t>(name.size());
+    }
+    std::memcpy(data + sections.nameOffsets + tape.variables().size() * sizeof(uint32_t), &nameOffset, sizeof(uint32_t));
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+
+    if (!file) {
+        throw std::runtime_error("Unable to write binary expression file \"" + path + "\"");
+    }
+}
+
+template <typename Value_t>
+void save_binary(const std::string &path, const std::vector<Expression<Value_t>> &exprs) {
+    save_binary(path, Tape<Value_t>(exprs));
+}
+
+template void save_binary(const std::string&, const Tape<long double>&);
+template void save_binary(const std::string&, const Tape<std::complex<long double>>&);
+
+template void save_binary(const std::string&, const std::vector<Expression<long double>>&);
+template void save_binary(const std::string&, const std::vector<Expression<std::complex<long double>>>&);
+
+//===================//
+// Класс BinaryImage //
+//===================//
+
+template <typename Value_t>
+BinaryImage<Value_t>::BinaryImage(const std::string &path) :
+    data_        (MAP_FAILED),
+    length_      (0),
+    header_      (nullptr),
+    nodes_       (nullptr),
+    outputs_     (nullptr),
+    constants_   (nullptr),
+    nameOffsets_ (nullptr),
+    names_       (nullptr)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Unable to open binary expression file \"" + path + "\"");
+    }
+
+    struct stat status{};
+    if (fstat(fd, &status) != 0 || size_t(status.st_size) < sizeof(BinaryHeader)) {
+        close(fd);
+        throw std::runtime_error("Binary expression file \"" + path + "\" is truncated");
+    }
+
+    length_ = size_t(status.st_size);
+    data_   = mmap(nullptr, length_, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (data_ == MAP_FAILED) {
+        throw std::runtime_error("Unable to map binary expression file \"" + path + "\"");
+    }
+
+    const char *base = static_cast<const char*>(data_);
+    header_ = reinterpret_cast<const BinaryHeader*>(base);
+
+    auto fail = [&](const std::string &reason) {
+        munmap(data_, length_);
+        throw std::runtime_error("Binary expression file \"" + path + "\": " + reason);
+    };
+
+    if (header_->magic != BINARY_MAGIC)               fail("bad signature");
+    if (header_->version != BINARY_VERSION)           fail("unsupported version " + std::to_string(header_->version));
+    if (header_->value_size != sizeof(Value_t) ||
+        header_->value_kind != value_kind<Value_t>)   fail("value type mismatch");
+
+    SectionLayout sections{};
+    if (!layout<Value_t>(*header_, sections))         fail("section sizes overflow");
+    if (sections.end > length_)                       fail("truncated");
+
+    nodes_       = reinterpret_cast<const TapeInstruction*>(base + sections.nodes);
+    outputs_     = reinterpret_cast<const uint32_t*>(base + sections.outputs);
+    constants_   = reinterpret_cast<const Value_t*>(base + sections.constants);
+    nameOffsets_ = reinterpret_cast<const uint32_t*>(base + sections.nameOffsets);
+    names_       = base + sections.names;
+
+    for (uint32_t i = 0; i < header_->variable_count; i++) {
+        if (nameOffsets_[i] > nameOffsets_[i + 1] || nameOffsets_[i + 1] > header_->names_size) {
+            fail("malformed variable table");
+        }
+    }
+}
+
+template <typename Value_t>
+BinaryImage<Value_t>::BinaryImage(BinaryImage &&other) :
+    data_        (other.data_),
+    length_      (other.length_),
+    header_      (other.header_),
+    nodes_       (other.nodes_),
+    outputs_     (other.outputs_),
+    constants_   (other.constants_),
+    nameOffsets_ (other.nameOffsets_),
+    names_       (other.names_)
+{
+    other.data_ = MAP_FAILED;
+}
+
+template <typename Value_t>
+BinaryImage<Value_t>::~BinaryImage() {
+    if (data_ != MAP_FAILED) {
+        munmap(data_, length_);
+    }
+}
+
+template <typename Value_t>
+size_t BinaryImage<Value_t>::size() const {
+    return header_->output_count;
+}
+
+template <typename Value_t>
+Tape<Value_t> BinaryImage<Value_t>::tape() const {
+    std::vector<std::string> variables;
+    variables.reserve(header_->variable_count);
+
+    for (uint32_t i = 0; i < header_->variable_count; i++) {
+        variables.emplace_back(names_ + nameOffsets_[i], names_ + nameOffsets_[i + 1]);
+    }
+
+    // Таблицы копируются целиком, ссылки между узлами проверяются конструктором ленты.
+    return Tape<Value_t>(
+        std::vector<TapeInstruction>(nodes_, nodes_ + header_->node_count),
+        std::vector<Value_t>(constants_, constants_ + header_->constant_count),
+        std::move(variables),
+        std::vector<uint32_t>(outputs_, outputs_ + header_->output_count)
+    );
+}
+
+template <typename Value_t>
+std::vector<Expression<Value_t>> BinaryImage<Value_t>::expressions() const {
+    return tape().expressions();
+}
+
+template class BinaryImage<long double>;
+template class BinaryImage<std::complex<long double>>;
\ No newline at end of file
@@ -0,0 +1,527 @@
+#include <server.hpp>
+
+#include <stdexcept>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+
+#include <lexer.hpp>
+#include <parser.hpp>
+
+//===================//
+// Класс SharedCache //
+//===================//
+
+template <typename Value>
+SharedCache<Value>::SharedCache(size_t capacity) :
+    capacity_ (capacity == 0 ? 1 : capacity),
+    mutex_    (),
+    recency_  (),
+    entries_  (),
+    hits_     (0),
+    misses_   (0)
+{}
+
+template <typename Value>
+bool SharedCache<Value>::find(const std::string &key, Value &value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto iter = entries_.find(key);
+    if (iter == entries_.end()) {
+        misses_++;
+        return false;
+    }
+
+    recency_.splice(recency_.begin(), recency_, iter->second.position);
+    value = iter->second.value;
+    hits_++;
+    return true;
+}
+
+template <typename Value>
+void SharedCache<Value>::insert(const std::string &key, const Value &value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Значение могло быть добавлено параллельным запросом.
+    if (entries_.contains(key)) return;
+
+    recency_.push_front(key);
+    entries_.emplace(key, Entry{value, recency_.begin()});
+
+    while (entries_.size() > capacity_) {
+        entries_.erase(recency_.back());
+        recency_.pop_back();
+    }
+}
+
+template <typename Value>
+uint64_t SharedCache<Value>::hits() const {
+    return hits_.load();
+}
+
+template <typename Value>
+uint64_t SharedCache<Value>::misses() const {
+    return misses_.load();
+}
+
+//======================//
+// Разбор полей запроса //
+//======================//
+
+namespace {
+
+std::string trim(const std::string &text) {
+    size_t begin = text.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) return "";
+
+    size_t end = text.find_last_not_of(" \t\r\n");
+    return text.substr(begin, end - begin + 1);
+}
+
+std::vector<std::string> split(const std::string &text, char separator) {
+    std::vector<std::string> parts;
+    std::string part;
+    std::istringstream stream(text);
+
+    while (std::getline(stream, part, separator)) {
+        parts.push_back(trim(part));
+    }
+
+    return parts;
+}
+
+std::vector<std::string> words(const std::string &text) {
+    std::vector<std::string> result;
+    std::string word;
+    std::istringstream stream(text);
+
+    while (stream >> word) {
+        result.push_back(word);
+    }
+
+    return result;
+}
+
+// Разбор присваиваний вида "x=1 y=2" с сохранением порядка переменных.
+std::vector<std::pair<std::string, long double>> assignments(const std::string &text) {
+    std::vector<std::pair<std::string, long double>> result;
+
+    for (const std::string &word : words(text)) {
+        size_t equalsPos = word.find('=');
+        if (equalsPos == std::string::npos) {
+            throw std::runtime_error("Expected assignment \"var=value\", got \"" + word + "\"");
+        }
+        result.emplace_back(word.substr(0, equalsPos), std::stold(word.substr(equalsPos + 1)));
+    }
+
+    return result;
+}
+
+// Перевод дескриптора в неблокирующий режим.
+void set_nonblocking(int descriptor) {
+    int flags = fcntl(descriptor, F_GETFL, 0);
+    if (flags >= 0) fcntl(descriptor, F_SETFL, flags | O_NONBLOCK);
+}
+
+std::string format_value(long double value) {
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%.18Lg", value);
+    return buffer;
+}
+
+} // namespace
+
+//==============//
+// Класс Server //
+//==============//
+
+Server::Server(const std::string &socketPath, size_t workers, size_t queueCapacity, size_t cacheCapacity) :
+    socketPath_  (socketPath),
+    listener_    (-1),
+    stopping_    (false),
+    wakeup_      {-1, -1},
+    expressions_ (cacheCapacity),
+    derivatives_ (cacheCapacity),
+    tapes_       (cacheCapacity),
+    pool_        (workers, queueCapacity)
+{
+    if (pipe(wakeup_) != 0) {
+        throw std::runtime_error(std::string("Unable to create pipe: ") + std::strerror(errno));
+    }
+    // Переполненный канал уже прерывает poll(), поэтому запись в него не ждёт.
+    set_nonblocking(wakeup_[0]);
+    set_nonblocking(wakeup_[1]);
+}
+
+Server::~Server() {
+    stop();
+    // Исполнители пишут в канал после ответа.
+    pool_.wait();
+
+    close(wakeup_[0]);
+    close(wakeup_[1]);
+}
+
+void Server::run() {
+    listener_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener_ < 0) {
+        throw std::runtime_error(std::string("Unable to create socket: ") + std::strerror(errno));
+    }
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socketPath_.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("Socket path \"" + socketPath_ + "\" is too long");
+    }
+    std::strncpy(address.sun_path, socketPath_.c_str(), sizeof(address.sun_path) - 1);
+
+    unlink(socketPath_.c_str());
+    if (stopping_ || bind(listener_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listener_, SOMAXCONN) != 0) {
+        throw std::runtime_error("Unable to listen on \"" + socketPath_ + "\": " + std::strerror(errno));
+    }
+
+    std::unordered_map<int, std::shared_ptr<Connection>> connections;
+    std::vector<pollfd> polled;
+    bool listening = true;
+
+    while (listening || !connections.empty()) {
+        // После stop() новые соединения и запросы не принимаются, а открытые соединения
+        // закрываются после ответов на уже поставленные в пул запросы.
+        if (stopping_ && listening) {
+            listening = false;
+            close(listener_);
+            unlink(socketPath_.c_str());
+
+            for (const auto &[socket, connection] : connections) {
+                shutdown(socket, SHUT_RD);
+                connection->finished = true;
+                connection->buffer.clear();
+                connection->lines = 0;
+            }
+        }
+
+        // Строки соединений ставятся в пул по одной от каждого соединения по кругу,
+        // пока в очереди есть место, чтобы одно соединение не занимало всю очередь.
+        for (bool progress = true; progress;) {
+            progress = false;
+            for (const auto &[socket, connection] : connections) {
+                progress = submit(connection) || progress;
+            }
+        }
+
+        for (auto iter = connections.begin(); iter != connections.end();) {
+            Connection &connection = *iter->second;
+            flush(connection);
+
+            bool done = connection.finished && connection.lines == 0 &&
+                        connection.collected == connection.submitted && connection.output.empty();
+            if (connection.broken || done) {
+                close(connection.socket);
+                iter = connections.erase(iter);
+            }
+            else {
+                ++iter;
+            }
+        }
+        if (!listening && connections.empty()) break;
+
+        // Канал пробуждения, слушающий сокет, затем открытые соединения.
+        polled.clear();
+        polled.push_back(pollfd{wakeup_[0], POLLIN, 0});
+        polled.push_back(pollfd{listening ? listener_ : -1, POLLIN, 0});
+        for (const auto &[socket, connection] : connections) {
+            bool reading = !connection->finished && connection->lines == 0 &&
+                           connection->submitted - connection->collected < MAX_PENDING_REQUESTS &&
+                           connection->output.size() < MAX_REQUEST_SIZE;
+            short events = short((reading ? POLLIN : 0) | (connection->output.empty() ? 0 : POLLOUT));
+            polled.push_back(pollfd{socket, events, 0});
+        }
+
+        if (poll(polled.data(), polled.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        if (polled[0].revents != 0) {
+            char signals[256];
+            while (read(wakeup_[0], signals, sizeof(signals)) > 0) {}
+        }
+
+        if (polled[1].revents != 0) {
+            int socket = accept(listener_, nullptr, nullptr);
+            if (socket >= 0) {
+                set_nonblocking(socket);
+                auto connection = std::make_shared<Connection>();
+                connection->socket = socket;
+                connections.emplace(socket, connection);
+            }
+        }
+
+        for (size_t i = 2; i < polled.size(); i++) {
+            if (polled[i].revents == 0) continue;
+
+            Connection &connection = *connections.at(polled[i].fd);
+            if (polled[i].revents & POLLOUT) {
+                flush(connection);
+            }
+            if (polled[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+                if (polled[i].events & POLLIN) {
+                    receive(connection);
+                }
+                else {
+                    // Клиент закрыл соединение, не дождавшись ответов.
+                    connection.broken = true;
+                }
+            }
+        }
+    }
+
+    if (listening) {
+        close(listener_);
+        unlink(socketPath_.c_str());
+    }
+    for (const auto &[socket, connection] : connections) {
+        close(socket);
+    }
+}
+
+void Server::stop() {
+    if (stopping_.exchange(true)) return;
+
+    wake();
+}
+
+void Server::wake() {
+    char signal = 0;
+    ssize_t written = write(wakeup_[1], &signal, 1);
+    (void) written;
+}
+
+void Server::receive(Connection &connection) {
+    char chunk[4096];
+
+    ssize_t received = recv(connection.socket, chunk, sizeof(chunk), 0);
+    if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) return;
+    if (received <= 0) {
+        connection.finished = true;
+        return;
+    }
+
+    connection.buffer.append(chunk, size_t(received));
+    connection.lines += size_t(std::count(chunk, chunk + received, '\n'));
+
+    // Клиент, не завершающий строку, не может занять неограниченный объём памяти.
+    // Ошибка отправляется после ответов на предыдущие запросы.
+    if (connection.lines == 0 && connection.buffer.size() > MAX_REQUEST_SIZE) {
+        connection.buffer.clear();
+        connection.finished = true;
+        respond(connection, connection.submitted++, "ERR Request exceeds " + std::to_string(MAX_REQUEST_SIZE) + " bytes");
+    }
+}
+
+bool Server::submit(const std::shared_ptr<Connection> &connection) {
+    if (connection->lines == 0 || connection->submitted - connection->collected >= MAX_PENDING_REQUESTS ||
+        connection->output.size() >= MAX_REQUEST_SIZE) {
+        return false;
+    }
+
+    size_t newline = connection->buffer.find('\n');
+    uint64_t sequence = connection->submitted;
+    std::string request = connection->buffer.substr(0, newline);
+
+    bool submitted = pool_.try_submit([this, connection, sequence, request = std::move(request)] {
+        respond(*connection, sequence, handle(request));
+    });
+    if (!submitted) return false;
+
+    connection->buffer.erase(0, newline + 1);
+    connection->lines--;
+    connection->submitted++;
+    return true;
+}
+
+void Server::respond(Connection &connection, uint64_t sequence, std::string response) {
+    {
+        std::lock_guard<std::mutex> lock(connection.mutex);
+        connection.ready.emplace(sequence, std::move(response) + "\n");
+    }
+
+    wake();
+}
+
+void Server::flush(Connection &connection) {
+    {
+        // Ответы переносятся в порядке запросов: ответ ждёт готовности всех предыдущих.
+        std::lock_guard<std::mutex> lock(connection.mutex);
+
+        while (!connection.ready.empty() && connection.ready.begin()->first == connection.collected) {
+            if (!connection.broken) connection.output += connection.ready.begin()->second;
+            connection.ready.erase(connection.ready.begin());
+            connection.collected++;
+        }
+    }
+
+    // Отправка без удержания мьютекса; остаток ждёт готовности сокета к записи.
+    while (!connection.output.empty() && !connection.broken) {
+        ssize_t written = send(connection.socket, connection.output.data(), connection.output.size(), MSG_NOSIGNAL);
+        if (written < 0 && errno == EINTR) continue;
+        if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (written <= 0) {
+            connection.broken = true;
+            break;
+        }
+        connection.output.erase(0, size_t(written));
+    }
+}
+
+std::string Server::handle(const std::string &request) {
+    try {
+        std::string line = trim(request);
+        size_t space = line.find(' ');
+
+        std::string command = line.substr(0, space);
+        std::vector<std::string> fields = split(space == std::string::npos ? "" : line.substr(space + 1), '|');
+
+        if (command == "EVAL")  return handleEval(fields);
+        if (command == "DIFF")  return handleDiff(fields);
+        if (command == "GRAD")  return handleGrad(fields);
+        if (command == "BATCH") return handleBatch(fields);
+        if (command == "STATS") {
+            return "OK hits=" + std::to_string(expressions_.hits() + derivatives_.hits() + tapes_.hits()) +
+                   " misses=" + std::to_string(expressions_.misses() + derivatives_.misses() + tapes_.misses());
+        }
+
+        return "ERR Unknown command \"" + command + "\"";
+    }
+    catch (const std::exception &error) {
+        return std::string("ERR ") + error.what();
+    }
+}
+
+std::shared_ptr<Expression<Server::Value_t>> Server::expression(const std::string &text) {
+    std::shared_ptr<Expression<Value_t>> expr;
+    if (expressions_.find(text, expr)) return expr;
+
+    Lexer lexer{text};
+    Parser<Value_t> parser{lexer};
+    expr = std::make_shared<Expression<Value_t>>(parser.parseExpression());
+
+    expressions_.insert(text, expr);
+    return expr;
+}
+
+std::shared_ptr<Expression<Server::Value_t>> Server::derivative(const std::string &text, const std::string &by) {
+    std::string key = text + "\n" + by;
+
+    std::shared_ptr<Expression<Value_t>> result;
+    if (derivatives_.find(key, result)) return result;
+
+    result = std::make_shared<Expression<Value_t>>(expression(text)->diff(by).prettify());
+
+    derivatives_.insert(key, result);
+    return result;
+}
+
+std::shared_ptr<Tape<Server::Value_t>> Server::tape(const std::string &key, const std::vector<Expression<Value_t>> &exprs) {
+    std::shared_ptr<Tape<Value_t>> result;
+    if (tapes_.find(key, result)) return result;
+
+    result = std::make_shared<Tape<Value_t>>(exprs);
+
+    tapes_.insert(key, result);
+    return result;
+}
+
+std::string Server::handleEval(const std::vector<std::string> &fields) {
+    if (fields.empty()) throw std::runtime_error("EVAL expects an expression");
+
+    std::map<std::string, Value_t> context;
+    if (fields.size() > 1) {
+        for (const auto &[name, value] : assignments(fields[1])) context[name] = value;
+    }
+
+    std::shared_ptr<Tape<Value_t>> compiled = tape("EVAL\n" + fields[0], {*expression(fields[0])});
+
+    return "OK " + format_value(compiled->eval(context));
+}
+
+std::string Server::handleDiff(const std::vector<std::string> &fields) {
+    if (fields.size() != 2) throw std::runtime_error("DIFF expects \"<expr> | <variable>\"");
+
+    return "OK " + derivative(fields[0], fields[1])->to_string();
+}
+
+std::string Server::handleGrad(const std::vector<std::string> &fields) {
+    if (fields.size() != 2) throw std::runtime_error("GRAD expects \"<expr> | var=value ...\"");
+
+    std::vector<std::pair<std::string, Value_t>> point = assignments(fields[1]);
+
+    std::map<std::string, Value_t> context;
+    std::string key = "GRAD\n" + fields[0];
+    std::vector<Expression<Value_t>> partials;
+
+    for (const auto &[name, value] : point) {
+        context[name] = value;
+        key += "\n" + name;
+        partials.push_back(*derivative(fields[0], name));
+    }
+
+    // Все частные производные вычисляются по одной ленте с общими подвыражениями.
+    std::shared_ptr<Tape<Value_t>> compiled = tape(key, partials);
+
+    std::string response = "OK";
+    for (Value_t value : compiled->eval_all(context)) {
+        response += " " + format_value(value);
+    }
+
+    return response;
+}
+
+std::string Server::handleBatch(const std::vector<std::string> &fields) {
+    if (fields.size() != 3) throw std::runtime_error("BATCH expects \"<expr> | <vars> | <point> ; <point> ...\"");
+
+    std::shared_ptr<Tape<Value_t>> compiled = tape("EVAL\n" + fields[0], {*expression(fields[0])});
+    std::vector<std::string> names = words(fields[1]);
+
+    // Позиции переменных ленты среди переменных запроса.
+    std::vector<size_t> positions;
+    for (const std::string &variable : compiled->variables()) {
+        size_t position = 0;
+        while (position < names.size() && names[position] != variable) position++;
+
+        if (position == names.size()) {
+            throw std::runtime_error("Variable \"" + variable + "\" not present in evaluation context");
+        }
+        positions.push_back(position);
+    }
+
+    std::vector<Value_t> variables(positions.size());
+    std::vector<Value_t> registers(compiled->size());
+    std::string response = "OK";
+
+    for (const std::string &point : split(fields[2], ';')) {
+        std::vector<std::string> values = words(point);
+        if (values.size() != names.size()) {
+            throw std::runtime_error("Point \"" + point + "\" has wrong number of values");
+        }
+
+        for (size_t i = 0; i < positions.size(); i++) {
+            variables[i] = std::stold(values[positions[i]]);
+        }
+
+        compiled->run(variables.data(), registers.data());
+        response += " " + format_value(registers[compiled->outputs()[0]]);
+    }
+
+    return response;
+}
\ No newline at end of file
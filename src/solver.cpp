@@ -0,0 +1,178 @@
+#include <solver.hpp>
+
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+
+namespace {
+
+bool finite(long double value) {
+    return std::isfinite(value);
+}
+
+bool finite(const std::complex<long double> &value) {
+    return std::isfinite(value.real()) && std::isfinite(value.imag());
+}
+
+// Стационарная точка - минимум при f''(x) > 0.
+bool minimum(long double curvature) {
+    return curvature > 0.0L;
+}
+
+// Комплексные стационарные точки не классифицируются.
+bool minimum(const std::complex<long double> &) {
+    return true;
+}
+
+// Выражения ленты итерации: g, g' и для минимума f.
+template <typename Value_t>
+std::vector<Expression<Value_t>> iteration(const Expression<Value_t> &expr, const std::string &variable,
+                                           std::map<std::string, Value_t> &parameters, SolveMode mode) {
+    // Переменная решателя не подставляется, даже если задана среди параметров.
+    std::map<std::string, Value_t> bound = parameters;
+    bound.erase(variable);
+
+    Expression<Value_t> function = expr.specialize(bound);
+    Expression<Value_t> derivative = function.diff(variable).prettify();
+
+    if (mode == SOLVE_ROOT) {
+        return {function, derivative};
+    }
+    return {derivative, derivative.diff(variable).prettify(), function};
+}
+
+} // namespace
+
+const char *solve_status_name(SolveStatus status) {
+    switch (status) {
+        case SOLVE_CONVERGED:   return "converged";
+        case SOLVE_DIVERGED:    return "diverged";
+        case SOLVE_EXHAUSTED:   return "exhausted";
+        case SOLVE_NOT_MINIMUM: return "not_minimum";
+    }
+    return "unknown";
+}
+
+std::string SolverStats::to_text() const {
+    size_t points = converged + diverged + exhausted + notMinimum;
+    char buffer[256];
+
+    snprintf(buffer, sizeof(buffer), "SOLVER[points=%llu converged=%llu diverged=%llu exhausted=%llu not_minimum=%llu mean_iterations=%.3f]\n",
+             static_cast<unsigned long long>(points), static_cast<unsigned long long>(converged),
+             static_cast<unsigned long long>(diverged), static_cast<unsigned long long>(exhausted),
+             static_cast<unsigned long long>(notMinimum), points > 0 ? double(iterations) / double(points) : 0.0);
+    return buffer;
+}
+
+template <typename Value_t>
+NewtonSolver<Value_t>::NewtonSolver(const Expression<Value_t> &expr, const std::string &variable,
+                                    std::map<std::string, Value_t> &parameters, const SolverOptions &options) :
+    options_ (options),
+    tape_    (iteration(expr, variable, parameters, options.mode))
+{
+    // На ленте может остаться только переменная решателя.
+    for (const std::string &name : tape_.variables()) {
+        if (name != variable) {
+            throw std::runtime_error("Variable \"" + name + "\" not present in evaluation context");
+        }
+    }
+}
+
+template <typename Value_t>
+std::vector<SolveResult<Value_t>> NewtonSolver<Value_t>::solve(const std::vector<Value_t> &starts) const {
+    std::vector<SolveResult<Value_t>> results(starts.size());
+    solve_range(starts, 0, starts.size(), results);
+    return results;
+}
+
+template <typename Value_t>
+std::vector<SolveResult<Value_t>> NewtonSolver<Value_t>::solve(const std::vector<Value_t> &starts, ThreadPool &pool) const {
+    std::vector<SolveResult<Value_t>> results(starts.size());
+    size_t batch = options_.batch > 0 ? options_.batch : 1;
+    size_t batches = (starts.size() + batch - 1) / batch;
+
+    // Пакеты записывают результаты в непересекающиеся части массива.
+    pool.parallel_for(batches, [&](size_t i) {
+        solve_range(starts, i * batch, std::min(starts.size(), (i + 1) * batch), results);
+    });
+    return results;
+}
+
+template <typename Value_t>
+void NewtonSolver<Value_t>::solve_range(const std::vector<Value_t> &starts, size_t first, size_t last,
+                                        std::vector<SolveResult<Value_t>> &results) const {
+    const std::vector<uint32_t> &outputs = tape_.outputs();
+    std::vector<Value_t> registers(tape_.size());
+
+    for (size_t i = first; i < last; i++) {
+        SolveResult<Value_t> &result = results[i];
+        result = SolveResult<Value_t>{starts[i], starts[i], Value_t(0.0), 0.0L, 0, SOLVE_EXHAUSTED};
+
+        Value_t x = starts[i];
+        while (result.iterations < options_.iterations) {
+            tape_.run(&x, registers.data());
+            Value_t g  = registers[outputs[0]];
+            Value_t dg = registers[outputs[1]];
+
+            if (g == Value_t(0.0)) {
+                result.status = SOLVE_CONVERGED;
+                break;
+            }
+            if (!finite(g) || !finite(dg) || dg == Value_t(0.0)) {
+                result.status = SOLVE_DIVERGED;
+                break;
+            }
+
+            Value_t step = g / dg;
+            x -= step;
+            result.iterations++;
+
+            if (!finite(x)) {
+                result.status = SOLVE_DIVERGED;
+                break;
+            }
+            if (std::abs(step) <= options_.tolerance * (1.0L + std::abs(x))) {
+                result.status = SOLVE_CONVERGED;
+                break;
+            }
+        }
+
+        // Значение и невязка в найденной точке.
+        tape_.run(&x, registers.data());
+        result.x = x;
+        result.value = registers[outputs[options_.mode == SOLVE_ROOT ? 0 : 2]];
+        result.residual = std::abs(registers[outputs[0]]);
+
+        // Метод Ньютона для f' сходится и к максимумам: проверяем знак f''.
+        if (options_.mode == SOLVE_MINIMUM && result.status == SOLVE_CONVERGED && !minimum(registers[outputs[1]])) {
+            result.status = SOLVE_NOT_MINIMUM;
+        }
+    }
+}
+
+template <typename Value_t>
+SolverStats NewtonSolver<Value_t>::summarize(const std::vector<SolveResult<Value_t>> &results) {
+    SolverStats stats;
+
+    for (const SolveResult<Value_t> &result : results) {
+        switch (result.status) {
+            case SOLVE_CONVERGED:   stats.converged++;  break;
+            case SOLVE_DIVERGED:    stats.diverged++;   break;
+            case SOLVE_EXHAUSTED:   stats.exhausted++;  break;
+            case SOLVE_NOT_MINIMUM: stats.notMinimum++; break;
+        }
+        stats.iterations += result.iterations;
+    }
+
+    return stats;
+}
+
+template <typename Value_t>
+const Tape<Value_t> &NewtonSolver<Value_t>::tape() const {
+    return tape_;
+}
+
+template class NewtonSolver<long double>;
+template class NewtonSolver<std::complex<long double>>;
\ No newline at end of file
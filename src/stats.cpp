@@ -0,0 +1,252 @@
+#include <stats.hpp>
+
+#include <new>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <complex>
+#include <algorithm>
+
+#include <sys/resource.h>
+
+//==========================//
+// Подсчёт выделений памяти //
+//==========================//
+
+namespace {
+
+// Счётчики одного потока в отдельной строке кеша. Поток пишет только в свои счётчики,
+// поэтому достаточно атомарных чтения и записи без блокировки шины.
+struct alignas(64) CounterSlot {
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> bytes;
+};
+
+// Счётчики потоков; потоки сверх SHARED_SLOT используют общий последний счётчик
+// с атомарным сложением. Счётчики завершившихся потоков остаются в сумме.
+constexpr size_t COUNTER_SLOTS = 256;
+constexpr size_t SHARED_SLOT = COUNTER_SLOTS - 1;
+
+CounterSlot counterSlots[COUNTER_SLOTS];
+std::atomic<size_t> nextSlot{0};
+thread_local CounterSlot *ownSlot = nullptr;
+
+void *count_allocation(void *pointer, size_t size) {
+    CounterSlot *slot = ownSlot;
+    if (slot == nullptr) {
+        slot = ownSlot = &counterSlots[std::min(nextSlot.fetch_add(1, std::memory_order_relaxed), SHARED_SLOT)];
+    }
+
+    if (slot == &counterSlots[SHARED_SLOT]) {
+        slot->count.fetch_add(1, std::memory_order_relaxed);
+        slot->bytes.fetch_add(size, std::memory_order_relaxed);
+    }
+    else {
+        slot->count.store(slot->count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        slot->bytes.store(slot->bytes.load(std::memory_order_relaxed) + size, std::memory_order_relaxed);
+    }
+
+    return pointer;
+}
+
+void *counted_allocate(size_t size) {
+    return count_allocation(std::malloc(size == 0 ? 1 : size), size);
+}
+
+void *counted_allocate(size_t size, std::align_val_t alignment) {
+    // Размер для aligned_alloc должен быть кратен выравниванию.
+    size_t align = static_cast<size_t>(alignment);
+    size_t rounded = (std::max<size_t>(size, 1) + align - 1) / align * align;
+
+    return count_allocation(std::aligned_alloc(align, rounded), size);
+}
+
+} // namespace
+
+void *operator new(size_t size) {
+    void *pointer = counted_allocate(size);
+    if (pointer == nullptr) throw std::bad_alloc();
+    return pointer;
+}
+
+void *operator new[](size_t size) {
+    void *pointer = counted_allocate(size);
+    if (pointer == nullptr) throw std::bad_alloc();
+    return pointer;
+}
+
+void *operator new(size_t size, const std::nothrow_t&) noexcept {
+    return counted_allocate(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return counted_allocate(size);
+}
+
+void *operator new(size_t size, std::align_val_t alignment) {
+    void *pointer = counted_allocate(size, alignment);
+    if (pointer == nullptr) throw std::bad_alloc();
+    return pointer;
+}
+
+void *operator new[](size_t size, std::align_val_t alignment) {
+    void *pointer = counted_allocate(size, alignment);
+    if (pointer == nullptr) throw std::bad_alloc();
+    return pointer;
+}
+
+void *operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return counted_allocate(size, alignment);
+}
+
+void *operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return counted_allocate(size, alignment);
+}
+
+void operator delete(void *pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer, size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, std::align_val_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer, std::align_val_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, size_t, std::align_val_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer, size_t, std::align_val_t) noexcept {
+    std::free(pointer);
+}
+
+AllocationCounters allocation_counters() {
+    AllocationCounters total{0, 0};
+    for (const CounterSlot &slot : counterSlots) {
+        total.count += slot.count.load(std::memory_order_relaxed);
+        total.bytes += slot.bytes.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+uint64_t peak_memory() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+
+    // В Linux ru_maxrss измеряется в килобайтах.
+    return uint64_t(usage.ru_maxrss) * 1024;
+}
+
+//=============//
+// Класс Stats //
+//=============//
+
+Stats::Stats(bool enabled) :
+    enabled_ (enabled),
+    phases_  ()
+{}
+
+Stats::Start Stats::begin() {
+    return Start{std::chrono::steady_clock::now(), allocation_counters()};
+}
+
+void Stats::end(const std::string &name, const Start &start) {
+    auto finish = std::chrono::steady_clock::now();
+    AllocationCounters allocations = allocation_counters();
+
+    phases_.push_back(PhaseStats{
+        name,
+        std::chrono::duration<double, std::milli>(finish - start.time).count(),
+        allocations.count - start.allocations.count,
+        allocations.bytes - start.allocations.bytes,
+        false,
+        0,
+        0,
+        0
+    });
+}
+
+template <typename Value_t>
+void Stats::measure(const Expression<Value_t> &expr) {
+    if (!enabled_ || phases_.empty()) return;
+
+    ExpressionMetrics metrics = expr.metrics();
+
+    PhaseStats &phase = phases_.back();
+    phase.hasExpression = true;
+    phase.nodes = metrics.nodes;
+    phase.uniqueNodes = metrics.uniqueNodes;
+    phase.depth = metrics.depth;
+}
+
+template void Stats::measure(const Expression<long double> &expr);
+template void Stats::measure(const Expression<std::complex<long double>> &expr);
+
+const std::vector<PhaseStats> &Stats::phases() const {
+    return phases_;
+}
+
+std::string Stats::to_text() const {
+    std::string text;
+    char buffer[256];
+
+    for (const PhaseStats &phase : phases_) {
+        snprintf(buffer, sizeof(buffer), "STATS[phase=%s ms=%.3f allocations=%llu bytes=%llu",
+                 phase.name.c_str(), phase.ms, static_cast<unsigned long long>(phase.allocations),
+                 static_cast<unsigned long long>(phase.bytes));
+        text += buffer;
+
+        if (phase.hasExpression) {
+            snprintf(buffer, sizeof(buffer), " nodes=%llu unique=%llu depth=%llu",
+                     static_cast<unsigned long long>(phase.nodes),
+                     static_cast<unsigned long long>(phase.uniqueNodes),
+                     static_cast<unsigned long long>(phase.depth));
+            text += buffer;
+        }
+        text += "]\n";
+    }
+
+    snprintf(buffer, sizeof(buffer), "STATS[peak_memory=%llu]\n", static_cast<unsigned long long>(peak_memory()));
+    return text + buffer;
+}
+
+std::string Stats::to_json() const {
+    std::string json = "{\"phases\": [";
+    char buffer[256];
+
+    for (size_t i = 0; i < phases_.size(); i++) {
+        const PhaseStats &phase = phases_[i];
+
+        snprintf(buffer, sizeof(buffer), "%s{\"phase\": \"%s\", \"ms\": %.6f, \"allocations\": %llu, \"bytes\": %llu",
+                 i == 0 ? "" : ", ", phase.name.c_str(), phase.ms,
+                 static_cast<unsigned long long>(phase.allocations), static_cast<unsigned long long>(phase.bytes));
+        json += buffer;
+
+        if (phase.hasExpression) {
+            snprintf(buffer, sizeof(buffer), ", \"nodes\": %llu, \"unique_nodes\": %llu, \"depth\": %llu",
+                     static_cast<unsigned long long>(phase.nodes),
+                     static_cast<unsigned long long>(phase.uniqueNodes),
+                     static_cast<unsigned long long>(phase.depth));
+            json += buffer;
+        }
+        json += "}";
+    }
+
+    snprintf(buffer, sizeof(buffer), "], \"peak_memory\": %llu}", static_cast<unsigned long long>(peak_memory()));
+    return json + buffer;
+}
\ No newline at end of file
@@ -0,0 +1,103 @@
+#include <symbols.hpp>
+
+#include <unordered_map>
+#include <deque>
+#include <stdexcept>
+#include <shared_mutex>
+#include <mutex>
+#include <algorithm>
+
+//==============//
+// Таблица имён //
+//==============//
+
+namespace {
+
+struct SymbolTable {
+    std::shared_mutex mutex;
+    std::unordered_map<std::string, uint32_t> ids;
+    // Имена по номерам; добавление в deque не перемещает уже добавленные имена.
+    std::deque<std::string> names;
+};
+
+SymbolTable &symbol_table() {
+    // Таблица создаётся при первом обращении и не разрушается, так как выражения
+    // могут обращаться к ней из деструкторов статических объектов.
+    static SymbolTable *table = new SymbolTable();
+    return *table;
+}
+
+// Последнее найденное в этом потоке имя: дифференцирование ищет одно имя в каждом узле.
+thread_local std::string lastName;
+thread_local uint32_t lastId = UINT32_MAX;
+
+} // namespace
+
+uint32_t intern_symbol(const std::string &name) {
+    uint32_t id;
+    if (find_symbol(name, id)) return id;
+
+    SymbolTable &table = symbol_table();
+    std::unique_lock<std::shared_mutex> lock(table.mutex);
+
+    auto [iter, inserted] = table.ids.try_emplace(name, static_cast<uint32_t>(table.ids.size()));
+    if (inserted) {
+        table.names.push_back(name);
+    }
+    return iter->second;
+}
+
+bool find_symbol(const std::string &name, uint32_t &id) {
+    if (lastId != UINT32_MAX && lastName == name) {
+        id = lastId;
+        return true;
+    }
+
+    SymbolTable &table = symbol_table();
+    std::shared_lock<std::shared_mutex> lock(table.mutex);
+
+    auto iter = table.ids.find(name);
+    if (iter == table.ids.end()) return false;
+
+    // Отсутствие имени не запоминается: оно может быть добавлено позже.
+    lastName = name;
+    lastId = iter->second;
+    id = iter->second;
+    return true;
+}
+
+const std::string &symbol_name(uint32_t id) {
+    SymbolTable &table = symbol_table();
+    std::shared_lock<std::shared_mutex> lock(table.mutex);
+
+    if (id >= table.names.size()) {
+        throw std::out_of_range("Unknown symbol id " + std::to_string(id));
+    }
+    return table.names[id];
+}
+
+//===================//
+// Класс VariableSet //
+//===================//
+
+VariableSet::VariableSet() :
+    bits_ (0)
+{}
+
+VariableSet::VariableSet(uint32_t id) :
+    bits_ (uint64_t(1) << std::min(id, EXACT_IDS))
+{}
+
+VariableSet VariableSet::united(const VariableSet &other) const {
+    VariableSet result;
+    result.bits_ = bits_ | other.bits_;
+    return result;
+}
+
+bool VariableSet::may_contain(uint32_t id) const {
+    return (bits_ >> std::min(id, EXACT_IDS)) & 1;
+}
+
+bool VariableSet::empty() const {
+    return bits_ == 0;
+}
\ No newline at end of file
@@ -0,0 +1,519 @@
+#include <tape.hpp>
+
+#include <stdexcept>
+#include <cmath>
+#include <complex>
+#include <algorithm>
+#include <type_traits>
+
+bool operator==(const TapeInstruction &left, const TapeInstruction &right) {
+    return left.type == right.type && left.left == right.left && left.right == right.right;
+}
+
+size_t TapeInstructionHash::operator()(const TapeInstruction &instr) const {
+    uint64_t hash = (uint64_t(instr.left) << 32 | instr.right) * 0x9e3779b97f4a7c15ULL;
+    return static_cast<size_t>(hash ^ (hash >> 29) ^ instr.type);
+}
+
+namespace {
+
+// Одновременное вычисление синуса и косинуса.
+// Значения совпадают с отдельными вызовами sin и cos, которыми вычисляют узлы
+// остальные вычислители; sincos из glibc используется, только если эти вызовы
+// сами вычисляются в double, иначе вызываются sin и cos.
+void sincos_pair(long double argument, long double &sine, long double &cosine) {
+#ifdef __GLIBC__
+    if constexpr (std::is_same_v<decltype(sin(argument)), double>) {
+        double s = 0.0;
+        double c = 0.0;
+        sincos(static_cast<double>(argument), &s, &c);
+
+        sine   = s;
+        cosine = c;
+        return;
+    }
+#endif
+    sine   = sin(argument);
+    cosine = cos(argument);
+}
+
+void sincos_pair(const std::complex<long double> &argument,
+                 std::complex<long double> &sine, std::complex<long double> &cosine) {
+    sine   = sin(argument);
+    cosine = cos(argument);
+}
+
+} // namespace
+
+template <typename Value_t>
+Tape<Value_t>::Tape(const Expression<Value_t> &expr) :
+    Tape(std::vector<Expression<Value_t>>{expr})
+{}
+
+template <typename Value_t>
+Tape<Value_t>::Tape(const std::vector<Expression<Value_t>> &exprs) :
+    code_      (),
+    constants_ (),
+    variables_ (),
+    outputs_   (),
+    partners_  ()
+{
+    std::unordered_map<const ExpressionImpl<Value_t>*, uint32_t> recorded;
+    std::unordered_map<std::string, uint32_t> variableIndex;
+    std::unordered_map<TapeInstruction, uint32_t, TapeInstructionHash> numbered;
+
+    for (const Expression<Value_t> &expr : exprs) {
+        outputs_.push_back(record(expr.impl(), recorded, variableIndex, numbered));
+    }
+
+    pair_trigonometry();
+}
+
+template <typename Value_t>
+Tape<Value_t>::Tape(const Expression<Value_t> &expr, std::map<std::string, Value_t> &bound) :
+    Tape(expr.specialize(bound))
+{}
+
+template <typename Value_t>
+Tape<Value_t>::Tape(std::vector<TapeInstruction> code, std::vector<Value_t> constants,
+                    std::vector<std::string> variables, std::vector<uint32_t> outputs) :
+    code_      (std::move(code)),
+    constants_ (std::move(constants)),
+    variables_ (std::move(variables)),
+    outputs_   (std::move(outputs)),
+    partners_  ()
+{
+    for (size_t i = 0; i < code_.size(); i++) {
+        const TapeInstruction &instr = code_[i];
+
+        bool valid = true;
+        switch (instr.type) {
+            case NODE_VALUE:    valid = instr.left < constants_.size();              break;
+            case NODE_VARIABLE: valid = instr.left < variables_.size();              break;
+            case NODE_ADD:
+            case NODE_SUB:
+            case NODE_MUL:
+            case NODE_DIV:
+            case NODE_POW:      valid = instr.left < i && instr.right < i;           break;
+            case NODE_SIN:
+            case NODE_COS:
+            case NODE_LN:
+            case NODE_EXP:      valid = instr.left < i;                              break;
+            default:            valid = false;                                       break;
+        }
+
+        if (!valid) {
+            throw std::runtime_error("Malformed tape instruction " + std::to_string(i));
+        }
+    }
+
+    for (uint32_t output : outputs_) {
+        if (output >= code_.size()) {
+            throw std::runtime_error("Tape output " + std::to_string(output) + " is out of range");
+        }
+    }
+
+    pair_trigonometry();
+}
+
+template <typename Value_t>
+uint32_t Tape<Value_t>::record(const std::shared_ptr<ExpressionImpl<Value_t>> &root,
+                               std::unordered_map<const ExpressionImpl<Value_t>*, uint32_t> &recorded,
+                               std::unordered_map<std::string, uint32_t> &variableIndex,
+                               std::unordered_map<TapeInstruction, uint32_t, TapeInstructionHash> &numbered) {
+    // Обход в глубину с явным стеком: узел записывается после всех своих операндов.
+    std::vector<const ExpressionImpl<Value_t>*> stack{root.get()};
+
+    while (!stack.empty()) {
+        const ExpressionImpl<Value_t> *node = stack.back();
+
+        if (recorded.contains(node)) {
+            stack.pop_back();
+            continue;
+        }
+
+        // Откладываем запись узла, пока не записаны его операнды.
+        bool ready = true;
+        for (size_t i = 0; i < node->arity(); i++) {
+            const ExpressionImpl<Value_t> *operand = node->operand(i).get();
+
+            if (!recorded.contains(operand)) {
+                stack.push_back(operand);
+                ready = false;
+            }
+        }
+        if (!ready) continue;
+
+        stack.pop_back();
+
+        TapeInstruction instruction{node->type(), 0, 0};
+
+        if (node->type() == NODE_VALUE) {
+            instruction.left = static_cast<uint32_t>(constants_.size());
+            constants_.push_back(static_cast<const Value<Value_t>*>(node)->value());
+        }
+        else if (node->type() == NODE_VARIABLE) {
+            const std::string &name = static_cast<const Variable<Value_t>*>(node)->name();
+
+            auto [iter, inserted] = variableIndex.try_emplace(name, static_cast<uint32_t>(variables_.size()));
+            if (inserted) {
+                variables_.push_back(name);
+            }
+            instruction.left = iter->second;
+        }
+        else {
+            instruction.left  = recorded.at(node->operand(0).get());
+            instruction.right = (node->arity() == 2) ? recorded.at(node->operand(1).get()) : 0;
+        }
+
+        // Операция над уже записанными операндами (как и повторная переменная) не записывается заново.
+        auto [iter, inserted] = numbered.try_emplace(instruction, static_cast<uint32_t>(code_.size()));
+        if (inserted) {
+            code_.push_back(instruction);
+        }
+        recorded.emplace(node, iter->second);
+    }
+
+    return recorded.at(root.get());
+}
+
+template <typename Value_t>
+void Tape<Value_t>::pair_trigonometry() {
+    partners_.assign(code_.size(), NO_PARTNER);
+
+    // Первые sin и cos каждого аргумента.
+    std::unordered_map<uint32_t, uint32_t> sines;
+    std::unordered_map<uint32_t, uint32_t> cosines;
+
+    for (size_t i = 0; i < code_.size(); i++) {
+        const TapeInstruction &instr = code_[i];
+
+        if (instr.type == NODE_SIN) sines.try_emplace(instr.left, static_cast<uint32_t>(i));
+        if (instr.type == NODE_COS) cosines.try_emplace(instr.left, static_cast<uint32_t>(i));
+    }
+
+    for (const auto &[argument, sine] : sines) {
+        auto iter = cosines.find(argument);
+        if (iter == cosines.end()) continue;
+
+        partners_[sine]         = iter->second;
+        partners_[iter->second] = sine;
+    }
+}
+
+template <typename Value_t>
+std::vector<Value_t> Tape<Value_t>::bind(std::map<std::string, Value_t> &context) const {
+    std::vector<Value_t> values;
+    values.reserve(variables_.size());
+
+    for (const std::string &name : variables_) {
+        auto iter = context.find(name);
+
+        if (iter == context.end()) {
+            throw std::runtime_error("Variable \"" + name + "\" not present in evaluation context");
+        }
+
+        values.push_back(iter->second);
+    }
+
+    return values;
+}
+
+template <typename Value_t>
+void Tape<Value_t>::run(const Value_t *variables, Value_t *registers) const {
+    for (size_t i = 0; i < code_.size(); i++) {
+        execute(i, variables, registers);
+    }
+}
+
+template <typename Value_t>
+void Tape<Value_t>::run(const Value_t *variables, Value_t *registers, const std::vector<uint32_t> &indices) const {
+    for (uint32_t i : indices) {
+        execute(i, variables, registers);
+    }
+}
+
+template <typename Value_t>
+void Tape<Value_t>::execute(size_t i, const Value_t *variables, Value_t *registers) const {
+    const TapeInstruction &instr = code_[i];
+
+    switch (instr.type) {
+        case NODE_VALUE:    registers[i] = constants_[instr.left];                              break;
+        case NODE_VARIABLE: registers[i] = variables[instr.left];                               break;
+        case NODE_ADD:      registers[i] = registers[instr.left] + registers[instr.right];      break;
+        case NODE_SUB:      registers[i] = registers[instr.left] - registers[instr.right];      break;
+        case NODE_MUL:      registers[i] = registers[instr.left] * registers[instr.right];      break;
+        case NODE_DIV:      registers[i] = registers[instr.left] / registers[instr.right];      break;
+        case NODE_POW:      registers[i] = power(registers[instr.left], registers[instr.right]); break;
+        case NODE_SIN:
+        case NODE_COS: {
+            uint32_t partner = partners_[i];
+            if (partner == NO_PARTNER) {
+                registers[i] = instr.type == NODE_SIN ? sin(registers[instr.left]) : cos(registers[instr.left]);
+            }
+            // Первая инструкция пары записывает оба значения, вторая пропускается.
+            else if (partner > i) {
+                Value_t &sine   = instr.type == NODE_SIN ? registers[i] : registers[partner];
+                Value_t &cosine = instr.type == NODE_SIN ? registers[partner] : registers[i];
+                sincos_pair(registers[instr.left], sine, cosine);
+            }
+            break;
+        }
+        case NODE_LN:       registers[i] = log(registers[instr.left]);                          break;
+        case NODE_EXP:      registers[i] = exp(registers[instr.left]);                          break;
+    }
+}
+
+// Показатель степени - неотрицательное целое число (для возведения нулевого основания умножением).
+template <typename Value_t>
+static bool is_natural_power(const Value_t &exponent, uint64_t &power) {
+    long double real = std::real(exponent);
+    if (std::imag(exponent) != 0 || real < 0 || real > 1024 || real != std::floor(real)) return false;
+
+    power = static_cast<uint64_t>(real);
+    return true;
+}
+
+template <typename Value_t>
+std::vector<Value_t> Tape<Value_t>::taylor(const std::string &by, std::map<std::string, Value_t> &context,
+                                           size_t order) const {
+    std::vector<Value_t> values = bind(context);
+    const size_t terms = order + 1;
+
+    // Ряд i-й инструкции занимает series[i * terms, (i + 1) * terms).
+    std::vector<Value_t> series(code_.size() * terms, Value_t(0.0));
+    // Вспомогательные ряды для sin/cos и возведения в степень.
+    std::vector<Value_t> first(terms), second(terms), third(terms);
+
+    // Произведение рядов a * b в result (result не совпадает с a и b).
+    auto multiply = [terms](const Value_t *a, const Value_t *b, Value_t *result) {
+        for (size_t n = 0; n < terms; n++) {
+            Value_t sum = 0.0;
+            for (size_t j = 0; j <= n; j++) sum += a[j] * b[n - j];
+            result[n] = sum;
+        }
+    };
+
+    // Экспонента ряда: e' = u' * e.
+    auto exponent = [terms](const Value_t *u, Value_t *e) {
+        e[0] = exp(u[0]);
+        for (size_t n = 1; n < terms; n++) {
+            Value_t sum = 0.0;
+            for (size_t j = 1; j <= n; j++) sum += Value_t(j) * u[j] * e[n - j];
+            e[n] = sum / Value_t(n);
+        }
+    };
+
+    // Логарифм ряда: u = e^l, l' = u' / u.
+    auto logarithm = [terms](const Value_t *u, Value_t *l) {
+        l[0] = log(u[0]);
+        for (size_t n = 1; n < terms; n++) {
+            Value_t sum = 0.0;
+            for (size_t j = 1; j < n; j++) sum += Value_t(j) * l[j] * u[n - j];
+            l[n] = (u[n] - sum / Value_t(n)) / u[0];
+        }
+    };
+
+    // Синус и косинус ряда вычисляются совместно: s' = u' * c, c' = -u' * s.
+    auto sincos = [terms](const Value_t *u, Value_t *s, Value_t *c) {
+        s[0] = sin(u[0]);
+        c[0] = cos(u[0]);
+        for (size_t n = 1; n < terms; n++) {
+            Value_t sinSum = 0.0;
+            Value_t cosSum = 0.0;
+            for (size_t j = 1; j <= n; j++) {
+                sinSum += Value_t(j) * u[j] * c[n - j];
+                cosSum += Value_t(j) * u[j] * s[n - j];
+            }
+            s[n] = sinSum / Value_t(n);
+            c[n] = -cosSum / Value_t(n);
+        }
+    };
+
+    for (size_t i = 0; i < code_.size(); i++) {
+        const TapeInstruction &instr = code_[i];
+
+        Value_t *result = &series[i * terms];
+        const Value_t *left  = &series[instr.left * terms];
+        const Value_t *right = &series[instr.right * terms];
+
+        switch (instr.type) {
+            case NODE_VALUE:
+                result[0] = constants_[instr.left];
+                break;
+            case NODE_VARIABLE:
+                result[0] = values[instr.left];
+                if (order > 0 && variables_[instr.left] == by) result[1] = 1.0;
+                break;
+            case NODE_ADD:
+                for (size_t n = 0; n < terms; n++) result[n] = left[n] + right[n];
+                break;
+            case NODE_SUB:
+                for (size_t n = 0; n < terms; n++) result[n] = left[n] - right[n];
+                break;
+            case NODE_MUL:
+                multiply(left, right, result);
+                break;
+            case NODE_DIV:
+                // left = result * right.
+                for (size_t n = 0; n < terms; n++) {
+                    Value_t sum = left[n];
+                    for (size_t j = 1; j <= n; j++) sum -= right[j] * result[n - j];
+                    result[n] = sum / right[0];
+                }
+                break;
+            case NODE_POW: {
+                bool constantExponent = true;
+                for (size_t n = 1; n < terms; n++) constantExponent = constantExponent && right[n] == Value_t(0.0);
+
+                uint64_t power = 0;
+                if (constantExponent && left[0] != Value_t(0.0)) {
+                    // p = u^r, u * p' = r * u' * p.
+                    Value_t r = right[0];
+                    result[0] = pow(left[0], r);
+                    for (size_t n = 1; n < terms; n++) {
+                        Value_t sum = 0.0;
+                        for (size_t j = 1; j <= n; j++) {
+                            sum += (r * Value_t(j) - Value_t(n - j)) * left[j] * result[n - j];
+                        }
+                        result[n] = sum / (Value_t(n) * left[0]);
+                    }
+                }
+                else if (constantExponent && is_natural_power(right[0], power)) {
+                    // Нулевое основание: возведение в степень последовательным умножением.
+                    std::fill(first.begin(), first.end(), Value_t(0.0));
+                    first[0] = 1.0;
+                    for (uint64_t k = 0; k < power; k++) {
+                        multiply(first.data(), left, second.data());
+                        first.swap(second);
+                    }
+                    std::copy(first.begin(), first.end(), result);
+                }
+                else {
+                    // u^v = exp(v * ln(u)).
+                    logarithm(left, first.data());
+                    multiply(right, first.data(), second.data());
+                    exponent(second.data(), result);
+                }
+                break;
+            }
+            case NODE_SIN:
+                sincos(left, result, third.data());
+                break;
+            case NODE_COS:
+                sincos(left, third.data(), result);
+                break;
+            case NODE_LN:
+                logarithm(left, result);
+                break;
+            case NODE_EXP:
+                exponent(left, result);
+                break;
+        }
+    }
+
+    size_t output = outputs_.at(0);
+    return std::vector<Value_t>(series.begin() + output * terms, series.begin() + (output + 1) * terms);
+}
+
+template <typename Value_t>
+Value_t Tape<Value_t>::eval(std::map<std::string, Value_t> &context) const {
+    std::vector<Value_t> values = bind(context);
+    std::vector<Value_t> registers(code_.size());
+
+    run(values.data(), registers.data());
+
+    return registers[outputs_.at(0)];
+}
+
+template <typename Value_t>
+std::vector<Value_t> Tape<Value_t>::eval_all(std::map<std::string, Value_t> &context) const {
+    std::vector<Value_t> values = bind(context);
+    std::vector<Value_t> registers(code_.size());
+
+    run(values.data(), registers.data());
+
+    std::vector<Value_t> results;
+    results.reserve(outputs_.size());
+    for (uint32_t output : outputs_) {
+        results.push_back(registers[output]);
+    }
+
+    return results;
+}
+
+template <typename Value_t>
+std::vector<Expression<Value_t>> Tape<Value_t>::expressions() const {
+    // Каждая инструкция превращается ровно в один узел, поэтому общие подвыражения сохраняются.
+    std::vector<std::shared_ptr<ExpressionImpl<Value_t>>> nodes(code_.size());
+
+    for (size_t i = 0; i < code_.size(); i++) {
+        const TapeInstruction &instr = code_[i];
+
+        if (instr.type == NODE_VALUE) {
+            nodes[i] = std::make_shared<Value<Value_t>>(constants_[instr.left]);
+            continue;
+        }
+        if (instr.type == NODE_VARIABLE) {
+            nodes[i] = std::make_shared<Variable<Value_t>>(variables_[instr.left]);
+            continue;
+        }
+
+        const std::shared_ptr<ExpressionImpl<Value_t>> &left  = nodes[instr.left];
+        const std::shared_ptr<ExpressionImpl<Value_t>> &right = nodes[instr.right];
+
+        switch (instr.type) {
+            case NODE_ADD: nodes[i] = std::make_shared<OperationAdd<Value_t>>(left, right); break;
+            case NODE_SUB: nodes[i] = std::make_shared<OperationSub<Value_t>>(left, right); break;
+            case NODE_MUL: nodes[i] = std::make_shared<OperationMul<Value_t>>(left, right); break;
+            case NODE_DIV: nodes[i] = std::make_shared<OperationDiv<Value_t>>(left, right); break;
+            case NODE_POW: nodes[i] = make_power(left, right);                             break;
+            case NODE_SIN: nodes[i] = std::make_shared<OperationSin<Value_t>>(left);        break;
+            case NODE_COS: nodes[i] = std::make_shared<OperationCos<Value_t>>(left);        break;
+            case NODE_LN:  nodes[i] = std::make_shared<OperationLn<Value_t>>(left);         break;
+            case NODE_EXP: nodes[i] = std::make_shared<OperationExp<Value_t>>(left);        break;
+            default:                                                                        break;
+        }
+    }
+
+    std::vector<Expression<Value_t>> exprs;
+    exprs.reserve(outputs_.size());
+    for (uint32_t output : outputs_) {
+        exprs.emplace_back(nodes[output]);
+    }
+
+    return exprs;
+}
+
+template <typename Value_t>
+size_t Tape<Value_t>::size() const {
+    return code_.size();
+}
+
+template <typename Value_t>
+const std::vector<TapeInstruction> &Tape<Value_t>::code() const {
+    return code_;
+}
+
+template <typename Value_t>
+const std::vector<Value_t> &Tape<Value_t>::constants() const {
+    return constants_;
+}
+
+template <typename Value_t>
+const std::vector<std::string> &Tape<Value_t>::variables() const {
+    return variables_;
+}
+
+template <typename Value_t>
+const std::vector<uint32_t> &Tape<Value_t>::outputs() const {
+    return outputs_;
+}
+
+template <typename Value_t>
+const std::vector<uint32_t> &Tape<Value_t>::partners() const {
+    return partners_;
+}
+
+template class Tape<long double>;
+template class Tape<std::complex<long double>>;
\ No newline at end of file
@@ -1,7 +1,41 @@
 #include <expression.hpp>
+#include <tape.hpp>
+#include <complex_batch.hpp>
+#include <serialize.hpp>
+#include <hash.hpp>
+#include <diff_cache.hpp>
+#include <thread_pool.hpp>
+#include <fork_join.hpp>
+#include <jacobian.hpp>
+#include <closure.hpp>
+#include <polynomial.hpp>
+#include <incremental.hpp>
+#include <solver.hpp>
+#include <frozen.hpp>
+#include <server.hpp>
+#include <generator.hpp>
+#include <stats.hpp>
+#include <profiler.hpp>
+#include <lexer.hpp>
+#include <parser.hpp>
 #include <gtest/gtest.h>
 #include <map>
 #include <string>
+#include <vector>
+#include <filesystem>
+#include <fstream>
+#include <atomic>
+#include <set>
+#include <limits>
+#include <thread>
+#include <chrono>
+#include <cstring>
+#include <cstddef>
+
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
 
 using namespace std;
 
@@ -115,6 +149,1101 @@ TEST_F(ExpressionTest, ToString) {
     EXPECT_EQ(expr.to_string(), "(x + 5.000000)");
 }
 
+// Test Tape
+TEST_F(ExpressionTest, TapeEvaluation) {
+    Expression<long double> x = m_var<long double>("x");
+    Expression<long double> shared = x * x;
+    Expression<long double> expr = shared + shared.sin() + (x ^ m_val<long double>(3.0L));
+    Tape<long double> tape(expr);
+    map<string, long double> context = {{"x", 1.5L}};
+    EXPECT_DOUBLE_EQ(tape.eval(context), expr.eval(context));
+    EXPECT_EQ(tape.size(), 7u); // x, x*x, sin, +, 3, ^, + (shared subtree recorded once)
+}
+
+TEST_F(ExpressionTest, TapeSharesOperationsAndFusesSinCos) {
+    Expression<long double> x = m_var<long double>("x");
+    Expression<long double> y = m_var<long double>("y");
+
+    // The same operations built twice are recorded once; sin and cos of one argument are paired.
+    Expression<long double> expr = (x * y).sin() * (m_var<long double>("x") * y).cos() + x.exp();
+    Tape<long double> tape(expr);
+    EXPECT_EQ(tape.size(), 8u); // x, y, x*y, sin, cos, *, exp, +
+
+    size_t paired = 0;
+    for (size_t i = 0; i < tape.size(); i++) {
+        if (tape.partners()[i] != Tape<long double>::NO_PARTNER) {
+            paired++;
+            EXPECT_EQ(tape.partners()[tape.partners()[i]], i);
+        }
+    }
+    EXPECT_EQ(paired, 2u);
+
+    map<string, long double> context = {{"x", 0.7L}, {"y", -1.3L}};
+    EXPECT_EQ(tape.eval(context), expr.eval(context));
+
+    // exp(x) of the function and of its derivative is computed once.
+    Tape<long double> both(vector<Expression<long double>>{expr, expr.diff("x")});
+    vector<long double> values = both.eval_all(context);
+    EXPECT_EQ(values[0], expr.eval(context));
+    EXPECT_EQ(values[1], expr.diff("x").eval(context));
+    size_t exponents = 0;
+    for (const TapeInstruction &instr : both.code()) {
+        if (instr.type == NODE_EXP) exponents++;
+    }
+    EXPECT_EQ(exponents, 1u);
+
+    // The fused complex batch path matches separate sin and cos.
+    using Complex = std::complex<long double>;
+    Expression<Complex> s = m_var<Complex>("s");
+    Expression<Complex> trig = s.sin() * s.sin() + s.cos();
+    ComplexBatch<double> points;
+    for (int i = 1; i <= 50; i++) {
+        points.re.push_back(0.1 * i);
+        points.im.push_back(-0.05 * i);
+    }
+    map<string, ComplexBatch<double>> inputs = {{"s", points}};
+    ComplexBatchEvaluator<double> evaluator(trig, COMPLEX_FAST);
+    ComplexBatch<double> result;
+    evaluator.eval(inputs, result);
+    for (size_t i = 0; i < points.size(); i++) {
+        map<string, Complex> point = {{"s", Complex(points.re[i], points.im[i])}};
+        Complex expected = trig.eval(point);
+        EXPECT_NEAR(result.re[i], static_cast<double>(expected.real()), 1e-9 * std::max(1.0L, abs(expected)));
+        EXPECT_NEAR(result.im[i], static_cast<double>(expected.imag()), 1e-9 * std::max(1.0L, abs(expected)));
+    }
+}
+
+// Test ComplexBatchEvaluator
+TEST_F(ExpressionTest, ComplexBatchEvaluation) {
+    using Complex = std::complex<long double>;
+    Expression<Complex> s = m_var<Complex>("s");
+    Expression<Complex> expr = m_val<Complex>(Complex(2.0L, 0.0L)) /
+        ((s ^ m_val<Complex>(Complex(2.0L, 0.0L))) + s * m_val<Complex>(Complex(0.5L, 0.0L)) + m_val<Complex>(Complex(1.0L, 0.0L)))
+        + (s.exp() * s.sin()).ln();
+
+    ComplexBatch<double> points;
+    for (int i = 1; i <= 300; i++) {
+        points.re.push_back(0.1 * (i % 7));
+        points.im.push_back(0.01 * i);
+    }
+    map<string, ComplexBatch<double>> inputs = {{"s", points}};
+
+    for (ComplexMode mode : {COMPLEX_STRICT, COMPLEX_FAST}) {
+        ComplexBatchEvaluator<double> evaluator(expr, mode);
+        ComplexBatch<double> result;
+        evaluator.eval(inputs, result);
+
+        ASSERT_EQ(result.size(), points.size());
+        for (size_t i = 0; i < points.size(); i++) {
+            map<string, Complex> context = {{"s", Complex(points.re[i], points.im[i])}};
+            Complex expected = expr.eval(context);
+            EXPECT_NEAR(result.re[i], static_cast<double>(expected.real()), 1e-9);
+            EXPECT_NEAR(result.im[i], static_cast<double>(expected.imag()), 1e-9);
+        }
+    }
+
+    // A zero base with a negative or complex exponent is a pole in both modes, as in std::pow.
+    map<string, ComplexBatch<double>> origin = {{"s", ComplexBatch<double>{{0.0}, {0.0}}}};
+    for (Complex exponent : {Complex(-1.0L, 0.0L), Complex(-2.5L, 0.0L), Complex(-1.0L, 1.0L), Complex(0.0L, 1.0L),
+                             Complex(2.0L, 0.0L), Complex(0.5L, 1.0L)}) {
+        std::complex<double> expected = std::pow(std::complex<double>(0.0, 0.0), std::complex<double>(exponent));
+
+        for (ComplexMode mode : {COMPLEX_STRICT, COMPLEX_FAST}) {
+            ComplexBatch<double> result;
+            ComplexBatchEvaluator<double>(s ^ m_val<Complex>(exponent), mode).eval(origin, result);
+
+            EXPECT_EQ(std::isinf(result.re[0]), std::isinf(expected.real())) << exponent;
+            EXPECT_EQ(std::isnan(result.re[0]), std::isnan(expected.real())) << exponent;
+            EXPECT_EQ(std::isnan(result.im[0]), std::isnan(expected.imag())) << exponent;
+            if (std::isfinite(expected.real())) {
+                EXPECT_EQ(result.re[0], expected.real()) << exponent;
+            }
+        }
+    }
+}
+
+// Test binary serialization
+TEST_F(ExpressionTest, BinaryRoundTrip) {
+    Expression<long double> x = m_var<long double>("x");
+    Expression<long double> y = m_var<long double>("y");
+    Expression<long double> shared = (x * y).sin();
+    Expression<long double> expr = shared * shared + (x ^ y) / y.ln();
+    vector<Expression<long double>> exprs = {expr, expr.diff("x"), expr.diff("y")};
+
+    string path = (filesystem::temp_directory_path() / "differentiator_test.sdx").string();
+    save_binary(path, exprs);
+
+    BinaryImage<long double> image(path);
+    ASSERT_EQ(image.size(), exprs.size());
+    EXPECT_EQ(image.tape().size(), Tape<long double>(exprs).size());
+
+    vector<Expression<long double>> loaded = image.expressions();
+    map<string, long double> context = {{"x", 1.25L}, {"y", 2.5L}};
+    for (size_t i = 0; i < exprs.size(); i++) {
+        EXPECT_EQ(loaded[i].to_string(), exprs[i].to_string());
+        EXPECT_DOUBLE_EQ(loaded[i].eval(context), exprs[i].eval(context));
+    }
+
+    // shared * shared is restored as a node with one operand used twice.
+    const auto &product = loaded[0].impl()->operand(0);
+    EXPECT_EQ(product->operand(0), product->operand(1));
+
+    filesystem::remove(path);
+}
+
+TEST_F(ExpressionTest, BinaryRejectsMalformedFile) {
+    string path = (filesystem::temp_directory_path() / "differentiator_bad.sdx").string();
+    ofstream(path, ios::binary) << string(64, 'x');
+
+    EXPECT_THROW(BinaryImage<long double>{path}, runtime_error);
+
+    // Section sizes that wrap around size_t must be rejected, not mapped
+    save_binary(path, vector<Expression<long double>>{m_var<long double>("x").sin()});
+    {
+        fstream file(path, ios::binary | ios::in | ios::out);
+        uint64_t namesSize = numeric_limits<uint64_t>::max() - 8;
+        file.seekp(offsetof(BinaryHeader, names_size));
+        file.write(reinterpret_cast<const char*>(&namesSize), sizeof(namesSize));
+    }
+    EXPECT_THROW(BinaryImage<long double>{path}, runtime_error);
+    filesystem::remove(path);
+}
+
+// Test structural hash
+TEST_F(ExpressionTest, StructuralHashIgnoresSharing) {
+    Expression<long double> x = m_var<long double>("x");
+    Expression<long double> shared = x.sin();
+    Expression<long double> first = shared * shared;
+    Expression<long double> second = x.sin() * x.sin();
+    EXPECT_EQ(structural_hash(first), structural_hash(second));
+    EXPECT_TRUE(structurally_equal(first, second));
+    EXPECT_NE(structural_hash(first), structural_hash(x.cos() * x.sin()));
+    EXPECT_FALSE(structurally_equal(first, x.cos() * x.sin()));
+}
+
+// Test DiffCache
+TEST_F(ExpressionTest, DiffCacheHitsAcrossInstances) {
+    filesystem::path directory = filesystem::temp_directory_path() / "differentiator_cache_test";
+    filesystem::remove_all(directory);
+
+    Expression<long double> expr = (m_var<long double>("x") * m_var<long double>("y")).sin();
+    map<string, long double> context = {{"x", 0.5L}, {"y", 2.0L}};
+    {
+        DiffCache<long double> cache(directory.string());
+        Expression<long double> first = cache.diff(expr, "x");
+        Expression<long double> second = cache.diff(expr, "x");
+        cache.diff(expr, "y");
+        EXPECT_EQ(first.to_string(), second.to_string());
+        EXPECT_EQ(cache.stats().hits, 1u);
+        EXPECT_EQ(cache.stats().misses, 2u);
+    }
+    {
+        DiffCache<long double> cache(directory.string());
+        Expression<long double> cached = cache.diff(expr, "x");
+        EXPECT_EQ(cache.stats().hits, 1u);
+        EXPECT_EQ(cache.stats().misses, 0u);
+        EXPECT_DOUBLE_EQ(cached.eval(context), expr.diff("x").eval(context));
+
+        // Prettifying a known derivative shares the entry of the prettified diff.
+        EXPECT_EQ(cache.prettify(expr, "x", expr.diff("x")).to_string(), cached.to_string());
+        EXPECT_EQ(cache.stats().hits, 2u);
+    }
+
+    filesystem::remove_all(directory);
+}
+
+TEST_F(ExpressionTest, DiffCacheComparesSimplifyLevel) {
+    filesystem::path directory = filesystem::temp_directory_path() / "differentiator_cache_level";
+    filesystem::remove_all(directory);
+
+    Expression<long double> expr = m_var<long double>("x") * m_var<long double>("x");
+    {
+        DiffCache<long double> cache(directory.string());
+        cache.diff(expr, "x", SIMPLIFY_PRETTIFY);
+    }
+
+    // Move the prettified entry to the key the unsimplified lookup uses,
+    // as a hash collision between levels would
+    filesystem::path entry = filesystem::directory_iterator(directory)->path();
+    uint64_t hash = stoull(entry.stem().string(), nullptr, 16) - SIMPLIFY_PRETTIFY + SIMPLIFY_NONE;
+    char key[17];
+    snprintf(key, sizeof(key), "%016llx", static_cast<unsigned long long>(hash));
+    filesystem::rename(entry, directory / (string(key) + ".sdx"));
+
+    DiffCache<long double> cache(directory.string());
+    Expression<long double> raw = cache.diff(expr, "x", SIMPLIFY_NONE);
+    EXPECT_EQ(cache.stats().hits, 0u);
+    EXPECT_EQ(raw.to_string(), expr.diff("x").to_string());
+
+    filesystem::remove_all(directory);
+}
+
+TEST_F(ExpressionTest, DiffCacheEvictsLeastRecentlyUsed) {
+    filesystem::path directory = filesystem::temp_directory_path() / "differentiator_cache_evict";
+    filesystem::remove_all(directory);
+
+    Expression<long double> expr = m_var<long double>("x").exp() * m_var<long double>("y");
+    DiffCache<long double> cache(directory.string(), 1);
+    cache.diff(expr, "x");
+    cache.diff(expr, "y");
+    EXPECT_EQ(cache.stats().evictions, 2u);
+    EXPECT_EQ(cache.stats().bytes, 0u);
+
+    filesystem::remove_all(directory);
+}
+
+// Test ThreadPool
+TEST_F(ExpressionTest, ThreadPoolRunsAllTasks) {
+    ThreadPool pool(4, 2);
+    atomic<int> counter{0};
+    for (int i = 0; i < 100; i++) {
+        pool.submit([&counter] { counter++; });
+    }
+    pool.wait();
+    EXPECT_EQ(counter.load(), 100);
+}
+
+TEST_F(ExpressionTest, DiffAllMatchesSerialDiff) {
+    Expression<long double> x = m_var<long double>("x");
+    Expression<long double> y = m_var<long double>("y");
+    Expression<long double> expr = (x * y).sin() + (x ^ y) - y.exp() / x;
+    vector<string> vars = {"x", "y", "z", "x"};
+
+    ThreadPool pool(3);
+    vector<Expression<long double>> partials = expr.diff_all(vars, pool);
+    ASSERT_EQ(partials.size(), vars.size());
+    for (size_t i = 0; i < vars.size(); i++) {
+        EXPECT_EQ(partials[i].to_string(), expr.diff(vars[i]).prettify().to_string());
+    }
+
+    EXPECT_THROW(pool.parallel_for(10, [](size_t i) { if (i == 7) throw runtime_error("task"); }), runtime_error);
+}
+
+// Test dependency sets
+TEST_F(ExpressionTest, DiffSkipsIndependentSubtrees) {
+    Expression<long double> x = m_var<long double>("x");
+    Expression<long double> y = m_var<long double>("y");
+    Expression<long double> independent = (y.sin() * y + m_val<long double>(3.0L)).exp();
+
+    EXPECT_TRUE((x * independent).impl()->depends_on("x"));
+    EXPECT_FALSE(independent.impl()->depends_on("x"));
+    EXPECT_FALSE(independent.impl()->depends_on("never_used_name"));
+    EXPECT_EQ(independent.diff("x").impl(), ExpressionImpl<long double>::zero());
+
+    // Only the live half of the product rule is built.
+    EXPECT_EQ((independent * x).diff("x").to_string(), "(" + independent.to_string() + " * 1.000000)");
+    EXPECT_EQ((x * m_val<long double>(2.0L) + y).diff("x").to_string(), "(1.000000 * 2.000000)");
+
+    // A constant exponent does not produce ln of a negative base.
+    map<string, long double> context = {{"x", -2.0L}};
+    EXPECT_EQ((x ^ m_val<long double>(3.0L)).diff("x").eval(context), 12.0L);
+
+    // Small ids are exact, large ids share one bit and only filter.
+    VariableSet low(3);
+    VariableSet high(200);
+    VariableSet both = low.united(high);
+    EXPECT_TRUE(both.may_contain(3) && both.may_contain(200) && both.may_contain(1000));
+    EXPECT_FALSE(both.may_contain(4) || both.may_contain(62));
+    EXPECT_FALSE(low.may_contain(200));
+    EXPECT_TRUE(VariableSet().empty());
+    EXPECT_EQ(sizeof(VariableSet), sizeof(uint64_t));
+}
+
+TEST_F(ExpressionTest, ManyVariablesKeepMemoryLinear) {
+    // Enough names that most ids fall past the exact part of VariableSet.
+    const size_t count = 100000;
+    vector<Expression<long double>> vars;
+    for (size_t i = 0; i < count; i++) {
+        vars.push_back(Expression<long double>("many_" + to_string(i)));
+    }
+
+    rusage before{};
+    getrusage(RUSAGE_SELF, &before);
+
+    Expression<long double> sum = vars[0];
+    for (size_t i = 1; i < count; i++) {
+        sum += vars[i];
+    }
+
+    rusage after{};
+    getrusage(RUSAGE_SELF, &after);
+    // Per-node free-variable sets grew as count^2 / 16 bytes (over 600 MB here).
+    EXPECT_LT(after.ru_maxrss - before.ru_maxrss, 64L * 1024);
+
+    // Membership of large ids is answered by walking the subtree.
+    EXPECT_TRUE(sum.impl()->depends_on("many_" + to_string(count / 2)));
+    EXPECT_FALSE(sum.impl()->depends_on("x_not_in_sum"));
+    EXPECT_FALSE(vars[7].impl()->depends_on("many_" + to_string(count / 2)));
+
+    map<string, long double> context = {{"many_12345", 2.0L}};
+    Expression<long double> derivative = sum.diff("many_12345");
+    EXPECT_EQ(derivative.to_string(), "1.000000");
+    EXPECT_EQ((sum * vars[3]).diff("many_99999").to_string(), "(1.000000 * " + vars[3].to_string() + ")");
+
+    // Concurrent diffs by different large ids share the nodes but keep no state in them.
+    Expression<long double> squares = vars[0];
+    for (size_t i = 1; i < 2000; i++) {
+        squares += vars[i] * vars[i];
+    }
+    vector<string> names;
+    for (size_t i = 1000; i < 1016; i++) {
+        names.push_back("many_" + to_string(i));
+    }
+    vector<Expression<long double>> all = squares.diff_all(names);
+    for (size_t i = 0; i < names.size(); i++) {
+        EXPECT_EQ(all[i].to_string(), squares.diff(names[i]).prettify().to_string());
+        EXPECT_EQ(all[i].to_string(), "(" + names[i] + " + " + names[i] + ")");
+    }
+}
+
+// Test interned variable names
+TEST_F(ExpressionTest, VariablesShareInternedNames) {
+    Variable<long double> first("interned_name");
+    Variable<long double> second("interned_name");
+    EXPECT_EQ(first.id(), second.id());
+    EXPECT_EQ(&first.name(), &second.name());
+    EXPECT_EQ(symbol_name(first.id()), "interned_name");
+    EXPECT_EQ(Variable<long double>(first.id()).to_string(), "interned_name");
+    EXPECT_THROW(symbol_name(UINT32_MAX), out_of_range);
+
+    // Derivatives by id and by name agree; an unknown name is not added to the table.
+    Expression<long double> x = m_var<long double>("x");
+    Expression<long double> expr = x * x.sin() + m_var<long double>("y");
+    EXPECT_EQ(Expression<long double>(expr.impl()->diff(intern_symbol("x"))).to_string(), expr.diff("x").to_string());
+    EXPECT_EQ(expr.diff("name_never_interned").impl(), ExpressionImpl<long double>::zero());
+    uint32_t unknown;
+    EXPECT_FALSE(find_symbol("name_never_interned", unknown));
+
+    // Concurrent interning gives every name exactly one id.
+    vector<uint32_t> ids(8 * 100);
+    ThreadPool pool(4);
+    pool.parallel_for(ids.size(), [&](size_t i) { ids[i] = intern_symbol("concurrent_" + to_string(i % 100)); });
+    for (size_t i = 0; i < ids.size(); i++) {
+        EXPECT_EQ(ids[i], ids[i % 100]);
+        EXPECT_EQ(symbol_name(ids[i]), "concurrent_" + to_string(i % 100));
+    }
+}
+
+// Test Taylor series
+TEST_F(ExpressionTest, TaylorMatchesRepeatedDiff) {
+    Expression<long double> x = m_var<long double>("x");
+    Expression<long double> y = m_var<long double>("y");
+    Expression<long double> expr = (x * y).sin() * x.cos() + (x + y).ln() / x.exp() - (x ^ y) + (y ^ x) -
+                                   (x ^ m_val<long double>(2.5L));
+    map<string, long double> context = {{"x", 1.3L}, {"y", 0.7L}};
+
+    vector<long double> coefficients = expr.taylor("x", context, 5);
+    ASSERT_EQ(coefficients.size(), 6u);
+
+    Expression<long double> derivative = expr;
+    long double factorial = 1.0L;
+    for (size_t j = 0; j < coefficients.size(); j++) {
+        if (j > 0) {
+            derivative = derivative.diff("x").prettify();
+            factorial *= j;
+        }
+        long double expected = derivative.eval(context);
+        EXPECT_NEAR(coefficients[j] * factorial, expected, 1e-12L * (1.0L + std::fabs(expected))) << j;
+    }
+
+    // A zero base with a natural exponent is expanded by multiplication.
+    map<string, long double> origin = {{"x", 0.0L}};
+    EXPECT_EQ((x ^ m_val<long double>(3.0L)).taylor("x", origin, 4), (vector<long double>{0.0L, 0.0L, 0.0L, 1.0L, 0.0L}));
+}
+
+// Test specialize
+TEST_F(ExpressionTest, SpecializeFoldsBoundParameters) {
+    Expression<long double> x = m_var<long double>("x");
+    Expression<long double> y = m_var<long double>("y");
+    map<string, long double> parameters;
+    Expression<long double> expr = x * y;
+    for (int i = 0; i < 30; i++) {
+        string name = "p" + to_string(i);
+        parameters[name] = 0.1L * i;
+        Expression<long double> p = m_var<long double>(name.c_str());
+        expr = expr + (p * p + p.sin()) * x - p / (p + m_val<long double>(1.0L)) * y;
+    }
+
+    Expression<long double> specialized = expr.specialize(parameters);
+    EXPECT_EQ(specialized.free_variables(), (set<string>{"x", "y"}));
+    EXPECT_EQ(specialized.to_string(), expr.substitute(parameters).prettify().to_string());
+
+    map<string, long double> free = {{"x", 1.5L}, {"y", -0.5L}};
+    map<string, long double> full = parameters;
+    full.insert(free.begin(), free.end());
+
+    Tape<long double> tape(expr, parameters);
+    EXPECT_EQ(tape.variables().size(), 2u);
+    EXPECT_LT(tape.size(), Tape<long double>(expr).size() / 3 * 2);
+    // No instruction is left with only constant operands.
+    for (const TapeInstruction &instr : tape.code()) {
+        if (instr.type == NODE_VALUE || instr.type == NODE_VARIABLE) continue;
+        bool unary = instr.type >= NODE_SIN;
+        EXPECT_FALSE(tape.code()[instr.left].type == NODE_VALUE &&
+                     (unary || tape.code()[instr.right].type == NODE_VALUE));
+    }
+    EXPECT_NEAR(tape.eval(free), expr.eval(full), 1e-15L);
+
+    // Shared subexpressions stay shared.
+    Expression<long double> shared = (x + m_val<long double>(1.0L)).sin();
+    EXPECT_EQ((shared * shared).specialize(parameters).unique_node_count(), 5u);
+}
+
+// Test ClosureEvaluator
+TEST_F(ExpressionTest, ClosureEvaluatorMatchesEval) {
+    Expression<long double> x = m_var<long double>("x");
+    Expression<long double> y = m_var<long double>("y");
+    Expression<long double> shared = (x * m_val<long double>(2.0L)).sin();
+    Expression<long double> expr = shared * shared + (y ^ x) / (m_val<long double>(3.0L) - x).exp() +
+                                   (x + y).ln() - y.cos() + (m_val<long double>(2.0L) ^ y);
+    map<string, long double> context = {{"x", 0.75L}, {"y", 1.25L}};
+
+    ClosureEvaluator<long double> closures(expr);
+    EXPECT_EQ(closures.eval(context), expr.eval(context));
+    EXPECT_EQ(closures.size(), 15u);
+
+    // Caller-provided registers give the same value as the per-thread buffer.
+    vector<long double> values;
+    for (const string &name : closures.variables()) values.push_back(context.at(name));
+    vector<long double> registers(closures.size());
+    EXPECT_EQ(closures.eval(values.data(), registers.data()), expr.eval(context));
+    EXPECT_EQ(closures.eval(values.data()), expr.eval(context));
+
+    ClosureEvaluator<long double> leaf(x);
+    EXPECT_EQ(leaf.eval(context), 0.75L);
+    EXPECT_EQ(ClosureEvaluator<long double>(m_val<long double>(4.0L)).eval(context), 4.0L);
+
+    GeneratorOptions options;
+    options.seed = 5;
+    options.nodes = 300;
+    options.variables = 3;
+    options.sharing = 0.2;
+    ExpressionGenerator generator(options);
+    Expression<long double> random = generator.expression();
+    map<string, long double> point = generator.point();
+    long double expected = random.eval(point);
+    long double actual = ClosureEvaluator<long double>(random).eval(point);
+    EXPECT_TRUE(actual == expected || (std::isnan(actual) && std::isnan(expected)));
+
+    map<string, long double> missing;
+    EXPECT_THROW(closures.eval(missing), runtime_error);
+}
+
+// Test OperationPowConst
+TEST_F(ExpressionTest, ConstantExponentPower) {
+    Expression<long double> x = m_var<long double>("x");
+    Expression<long double> y = m_var<long double>("y");
+
+    // A numeric exponent produces the dedicated node with the plain power rule.
+    Expression<long double> cube = x ^ m_val<long double>(3.0L);
+    ASSERT_NE(dynamic_pointer_cast<OperationPowConst<long double>>(cube.impl()), nullptr);
+    EXPECT_EQ(cube.impl()->type(), NODE_POW);
+    EXPECT_EQ(cube.diff("x").to_string(), "(3.000000 * (x ^ 2.000000))");
+    EXPECT_EQ((x ^ m_val<long double>(2.0L)).diff("x").to_string(), "(2.000000 * x)");
+    EXPECT_EQ(((x * y) ^ m_val<long double>(2.0L)).diff("x").to_string(), "((2.000000 * (x * y)) * (1.000000 * y))");
+    EXPECT_EQ(dynamic_pointer_cast<OperationPowConst<long double>>((x ^ y).impl()), nullptr);
+
+    // No ln(x) term: the derivative is finite for negative and zero bases.
+    map<string, long double> negative = {{"x", -2.0L}};
+    EXPECT_EQ(cube.diff("x").eval(negative), 12.0L);
+    map<string, long double> zero = {{"x", 0.0L}};
+    EXPECT_EQ(cube.diff("x").eval(zero), 0.0L);
+
+    // Integer and half-integer exponents.
+    EXPECT_EQ(power(-2.0L, 10.0L), 1024.0L);
+    EXPECT_EQ(power(2.0L, -3.0L), 0.125L);
+    EXPECT_EQ(power(4.0L, 2.5L), 32.0L);
+    EXPECT_EQ(power(4.0L, -0.5L), 0.5L);
+    EXPECT_EQ(power(0.0L, 0.0L), 1.0L);
+    EXPECT_NEAR(power(1.7L, 0.3L), pow(1.7L, 0.3L), 1e-18L);
+    EXPECT_NEAR(abs(power(complex<long double>(1.0L, 2.0L), complex<long double>(3.0L))
+                    - pow(complex<long double>(1.0L, 2.0L), 3.0L)), 0.0L, 1e-15L);
+
+    // Substitution and prettify keep the node; tapes rebuild it.
+    map<string, long double> context = {{"y", 2.0L}};
+    Expression<long double> substituted = (x ^ y).substitute(context);
+    EXPECT_NE(dynamic_pointer_cast<OperationPowConst<long double>>(substituted.prettify().impl()), nullptr);
+    EXPECT_NE(dynamic_pointer_cast<OperationPowConst<long double>>(Tape<long double>(cube).expressions()[0].impl()), nullptr);
+}
+
+// Test Polynomial and horner_form
+TEST_F(ExpressionTest, PolynomialHornerForm) {
+    Expression<long double> x = m_var<long double>("x");
+    Expression<long double> y = m_var<long double>("y");
+    Expression<long double> expr = (x ^ m_val<long double>(3.0L)) * m_val<long double>(2.0L) -
+                                   (x - m_val<long double>(1.0L)) * (x + m_val<long double>(1.0L)) +
+                                   x / m_val<long double>(4.0L);
+
+    Polynomial<long double> polynomial("", {});
+    ASSERT_TRUE(Polynomial<long double>::recognize(expr, polynomial));
+    EXPECT_EQ(polynomial.variable(), "x");
+    EXPECT_EQ(polynomial.coefficients(), (vector<long double>{1.0L, 0.25L, -1.0L, 2.0L}));
+
+    long double points[] = {-1.5L, 0.25L, 0.5L, 2.0L};
+    long double results[4];
+    polynomial.eval(points, results, 4);
+    for (size_t i = 0; i < 4; i++) {
+        map<string, long double> context = {{"x", points[i]}};
+        EXPECT_NEAR(polynomial.eval(points[i]), expr.eval(context), 1e-15L);
+        EXPECT_NEAR(polynomial.eval_estrin(points[i]), expr.eval(context), 1e-15L);
+        EXPECT_EQ(results[i], polynomial.eval(points[i]));
+        EXPECT_NEAR(polynomial.derivative().eval(points[i]), expr.diff("x").eval(context), 1e-15L);
+    }
+    EXPECT_EQ(polynomial.derivative().coefficients(), (vector<long double>{0.25L, -2.0L, 6.0L}));
+
+    map<string, long double> zero = {{"x", 0.0L}};
+    EXPECT_EQ(horner_form(expr).diff("x").eval(zero), 0.25L);
+
+    // Non-polynomial and multivariate expressions are rejected.
+    EXPECT_FALSE(Polynomial<long double>::recognize(x.sin() + x, polynomial));
+    EXPECT_FALSE(Polynomial<long double>::recognize(x * y, polynomial));
+    EXPECT_FALSE(Polynomial<long double>::recognize(m_val<long double>(1.0L) / x, polynomial));
+    EXPECT_FALSE(Polynomial<long double>::recognize(x ^ m_val<long double>(0.5L), polynomial));
+
+    // Polynomial subtrees are rewritten without pow, the rest of the tree is kept.
+    Expression<long double> mixed = (expr * y).sin() + (m_val<long double>(2.0L) ^ m_val<long double>(3.0L));
+    Expression<long double> horner = horner_form(mixed);
+    EXPECT_EQ(horner.to_string().find("^"), string::npos);
+    map<string, long double> context = {{"x", 0.3L}, {"y", -1.7L}};
+    EXPECT_NEAR(horner.eval(context), mixed.eval(context), 1e-15L);
+    EXPECT_NEAR(horner.diff("x").eval(context), mixed.diff("x").eval(context), 1e-15L);
+    EXPECT_LT(horner.unique_node_count(), mixed.unique_node_count());
+
+    // Factored polynomials are not expanded: (x - 1)^20 near its root keeps full accuracy.
+    Expression<long double> factored = (x - m_val<long double>(1.0L)) ^ m_val<long double>(20.0L);
+    Expression<long double> product = (x - m_val<long double>(1.0L)) * (x + m_val<long double>(1.0L)) * x;
+    EXPECT_TRUE(structurally_equal(horner_form(factored), factored));
+    EXPECT_TRUE(structurally_equal(horner_form(product), product));
+    map<string, long double> nearRoot = {{"x", 1.001L}};
+    long double exact = powl(0.001L, 20);
+    EXPECT_NEAR(horner_form(factored).eval(nearRoot) / exact, 1.0L, 1e-12L);
+    EXPECT_NEAR(horner_form(factored + x * x).eval(nearRoot), factored.eval(nearRoot) + 1.001L * 1.001L, 1e-15L);
+}
+
+TEST_F(ExpressionTest, ForkJoinMatchesSerial) {
+    GeneratorOptions options;
+    options.seed = 11;
+    options.nodes = 1000;
+    options.depth = 40;
+    options.variables = 3;
+    options.sharing = 0.1;
+    Expression<long double> expr = ExpressionGenerator(options).expression();
+
+    ForkJoinPool pool(4);
+    for (uint64_t grain : {1u, 16u, 4096u}) {
+        Expression<long double> derivative = expr.diff("x", pool, grain);
+        EXPECT_EQ(derivative.to_string(), expr.diff("x").to_string());
+        EXPECT_EQ(derivative.prettify(pool, grain).to_string(), expr.diff("x").prettify().to_string());
+    }
+
+    std::atomic<int> calls{0};
+    pool.run([&] {
+        pool.fork_join([&] { calls++; }, [&] { calls++; });
+    });
+    EXPECT_EQ(calls.load(), 2);
+    EXPECT_THROW(pool.run([&] {
+        pool.fork_join([] {}, [] { throw runtime_error("task"); });
+    }), runtime_error);
+}
+
+// Test Expression builders
+TEST_F(ExpressionTest, RvalueOperatorsAndBalancedSum) {
+    const Expression<long double> x = m_var<long double>("x");
+    const Expression<long double> y = m_var<long double>("y");
+
+    // Operators and functions are usable on const expressions and with a number on the left.
+    EXPECT_EQ((x + y).to_string(), "(x + y)");
+    EXPECT_EQ((2.0L * x.sin() - 1.0L / y).to_string(), "((2.000000 * sin(x)) - (1.000000 / y))");
+    EXPECT_EQ((2.0L ^ x).to_string(), "(2.000000 ^ x)");
+
+    // Temporaries and compound assignment move their operands instead of sharing them.
+    Expression<long double> term = x * y;
+    const ExpressionImpl<long double> *node = term.impl().get();
+    Expression<long double> sum = std::move(term) + y;
+    EXPECT_EQ(sum.impl()->operand(0).get(), node);
+    EXPECT_EQ(sum.impl()->operand(0).use_count(), 1);
+    Expression<long double> accumulated = x;
+    accumulated += y;
+    accumulated *= x;
+    EXPECT_EQ(accumulated.to_string(), "((x + y) * x)");
+    EXPECT_EQ(accumulated.impl().use_count(), 1);
+    EXPECT_EQ(accumulated.impl()->operand(0).use_count(), 1);
+
+    // Balanced sums have logarithmic depth and evaluate like the left-folded chain.
+    vector<Expression<long double>> terms;
+    Expression<long double> chain(0.0L);
+    for (int i = 1; i <= 1000; i++) {
+        Expression<long double> item = Expression<long double>(1.0L / i) * (x ^ m_val<long double>(i % 4));
+        chain += item;
+        terms.push_back(item);
+    }
+    map<string, long double> context = {{"x", 0.5L}, {"y", 3.0L}};
+    Expression<long double> balanced = Expression<long double>::sum(terms);
+    EXPECT_EQ(balanced.depth(), 10u + 3u);
+    EXPECT_EQ(balanced.unique_node_count(), chain.unique_node_count() - 2);
+    EXPECT_NEAR(balanced.eval(context), chain.eval(context), 1e-15L);
+
+    EXPECT_EQ(Expression<long double>::sum({}).to_string(), "0.000000");
+    EXPECT_EQ(Expression<long double>::product({}).to_string(), "1.000000");
+    EXPECT_EQ(Expression<long double>::product({x}).to_string(), "x");
+    EXPECT_EQ(Expression<long double>::product({x, y, x}).to_string(), "((x * y) * x)");
+    EXPECT_EQ(Expression<long double>::sum({x, y, x, y, x}).to_string(), "(((x + y) + (x + y)) + x)");
+}
+
+// Test traversals and destruction of expressions deeper than the recursion limit
+TEST_F(ExpressionTest, DeepExpressionIsStackSafe) {
+    Expression<long double> x = m_var<long double>("x");
+    map<string, long double> context = {{"x", 2.0L}};
+
+    // Below and above the limit the iterative traversal agrees with the recursive one.
+    Expression<long double> medium = m_val<long double>(1.0L);
+    for (int i = 0; i < 1500; i++) {
+        medium = (i % 3 == 0) ? medium * x.sin() : medium + Expression<long double>(i % 7) * x;
+    }
+    EXPECT_GT(medium.depth(), Expression<long double>::MAX_RECURSION_DEPTH);
+    EXPECT_EQ(medium.to_string(), medium.impl()->to_string());
+    EXPECT_EQ(medium.eval(context), medium.impl()->eval(context));
+    EXPECT_EQ(medium.diff("x").to_string(), medium.impl()->diff("x")->to_string());
+    EXPECT_EQ(medium.prettify().to_string(), medium.impl()->prettify()->to_string());
+    EXPECT_EQ(medium.substitute(context).to_string(), medium.impl()->substitute(context)->to_string());
+
+    // A chain this deep overflows the stack with recursive traversals and destructors.
+    Expression<long double> deep = m_val<long double>(0.0L);
+    for (int i = 0; i < 300000; i++) {
+        deep += x;
+    }
+    EXPECT_EQ(deep.depth(), 300001u);
+    EXPECT_EQ(deep.eval(context), 600000.0L);
+    EXPECT_EQ(deep.diff("x").eval(context), 300000.0L);
+    EXPECT_EQ(deep.substitute(context).eval(context), 600000.0L);
+    EXPECT_EQ(deep.prettify().depth(), 300000u);
+    EXPECT_EQ(deep.to_string().size(), 300000u * 6 + 8);
+
+    ClosureEvaluator<long double> closure(deep);
+    EXPECT_EQ(closure.eval(context), 600000.0L);
+
+    Profiler<long double> profiler(deep);
+    EXPECT_EQ(profiler.eval(context), 600000.0L);
+    EXPECT_EQ(profiler.by_type()[NODE_ADD].calls, 300000u);
+}
+
+// Test IncrementalEvaluator
+TEST_F(ExpressionTest, IncrementalEvaluatorRecomputesDirtyPath) {
+    Expression<long double> x = m_var<long double>("x");
+    Expression<long double> y = m_var<long double>("y");
+    Expression<long double> z = m_var<long double>("z");
+    Expression<long double> expr = (x * y).sin() + (z ^ m_val<long double>(2.0L)) * z.cos() + (x + m_val<long double>(1.0L)).ln();
+    map<string, long double> context = {{"x", 0.5L}, {"y", 1.5L}, {"z", 2.0L}};
+
+    IncrementalEvaluator<long double> incremental(expr, context);
+    EXPECT_EQ(incremental.value(), expr.eval(context));
+
+    // Only the instructions depending on z are recomputed.
+    context["z"] = -1.25L;
+    incremental.set("z", -1.25L);
+    EXPECT_EQ(incremental.value(), expr.eval(context));
+    EXPECT_EQ(incremental.recomputed(), 6u);
+
+    context["x"] = 2.0L;
+    context["y"] = 0.25L;
+    incremental.set("x", 3.0L);
+    incremental.set("x", 2.0L);
+    incremental.set("y", 0.25L);
+    incremental.set("unused", 7.0L);
+    EXPECT_EQ(incremental.value(), expr.eval(context));
+    EXPECT_EQ(incremental.recomputed(), 8u);
+
+    // More than 64 variables spans several dependency blocks.
+    for (size_t variables : {6u, 150u}) {
+        GeneratorOptions options;
+        options.seed = 9;
+        options.nodes = 400;
+        options.variables = variables;
+        options.sharing = 0.2;
+        ExpressionGenerator generator(options);
+        Expression<long double> random = generator.expression();
+        map<string, long double> point = generator.point();
+        IncrementalEvaluator<long double> model(random, point);
+        for (auto &[name, value] : point) {
+            value += 0.125L;
+            model.set(name, value);
+            long double expected = random.eval(point);
+            long double actual = model.value();
+            EXPECT_TRUE(actual == expected || (std::isnan(actual) && std::isnan(expected)));
+        }
+    }
+
+    map<string, long double> missing = {{"x", 1.0L}};
+    EXPECT_THROW(IncrementalEvaluator<long double>(expr, missing), runtime_error);
+}
+
+// Test NewtonSolver
+TEST_F(ExpressionTest, NewtonSolverRootsAndMinima) {
+    Expression<long double> x = m_var<long double>("x");
+    Expression<long double> a = m_var<long double>("a");
+    map<string, long double> parameters = {{"a", 2.0L}};
+
+    // Roots of x^2 - a from both sides; f'(0) = 0 stops the iteration.
+    NewtonSolver<long double> roots((x ^ m_val<long double>(2.0L)) - a, "x", parameters);
+    EXPECT_EQ(roots.tape().variables(), (vector<string>{"x"}));
+    vector<SolveResult<long double>> results = roots.solve({1.0L, -3.0L, 0.0L});
+    EXPECT_EQ(results[0].status, SOLVE_CONVERGED);
+    EXPECT_NEAR(results[0].x, sqrtl(2.0L), 1e-18L);
+    EXPECT_NEAR(results[1].x, -sqrtl(2.0L), 1e-18L);
+    EXPECT_LT(results[0].residual, 1e-17L);
+    EXPECT_EQ(results[2].status, SOLVE_DIVERGED);
+
+    SolverStats stats = NewtonSolver<long double>::summarize(results);
+    EXPECT_EQ(stats.converged, 2u);
+    EXPECT_EQ(stats.diverged, 1u);
+    EXPECT_EQ(stats.iterations, results[0].iterations + results[1].iterations);
+
+    // Minimum of (x - a)^2 + exp(x) is where 2 (x - a) + exp(x) = 0.
+    SolverOptions options;
+    options.mode = SOLVE_MINIMUM;
+    options.batch = 3;
+    NewtonSolver<long double> minimum(((x - a) ^ m_val<long double>(2.0L)) + x.exp(), "x", parameters, options);
+    vector<long double> starts;
+    for (int i = 0; i < 20; i++) starts.push_back(-5.0L + 0.5L * i);
+
+    ThreadPool pool(3);
+    vector<SolveResult<long double>> parallel = minimum.solve(starts, pool);
+    vector<SolveResult<long double>> serial = minimum.solve(starts);
+    for (size_t i = 0; i < starts.size(); i++) {
+        EXPECT_EQ(parallel[i].status, SOLVE_CONVERGED);
+        EXPECT_EQ(parallel[i].x, serial[i].x);
+        EXPECT_EQ(parallel[i].start, starts[i]);
+        EXPECT_NEAR(2.0L * (parallel[i].x - 2.0L) + expl(parallel[i].x), 0.0L, 1e-15L);
+        EXPECT_NEAR(parallel[i].value, (parallel[i].x - 2.0L) * (parallel[i].x - 2.0L) + expl(parallel[i].x), 1e-15L);
+    }
+
+    // A maximum of a concave function is a stationary point but not a minimum.
+    NewtonSolver<long double> concave(m_val<long double>(0.0L) - x * x, "x", parameters, options);
+    vector<SolveResult<long double>> maxima = concave.solve({1.0L, -0.5L});
+    EXPECT_EQ(maxima[0].status, SOLVE_NOT_MINIMUM);
+    EXPECT_EQ(maxima[1].status, SOLVE_NOT_MINIMUM);
+    EXPECT_EQ(maxima[0].x, 0.0L);
+    EXPECT_EQ(NewtonSolver<long double>::summarize(maxima).notMinimum, 2u);
+
+    // Too few iterations and unbound variables.
+    SolverOptions short_options;
+    short_options.iterations = 1;
+    EXPECT_EQ(NewtonSolver<long double>(x.cos() - x, "x", parameters, short_options).solve({10.0L})[0].status, SOLVE_EXHAUSTED);
+    EXPECT_THROW(NewtonSolver<long double>(x * m_var<long double>("b"), "x", parameters), runtime_error);
+}
+
+// Test FrozenExpression
+TEST_F(ExpressionTest, FrozenExpressionMatchesTree) {
+    Expression<long double> x = m_var<long double>("x");
+    Expression<long double> y = m_var<long double>("y");
+    Expression<long double> shared = (x * y).sin();
+    Expression<long double> expr = shared * shared + (x ^ m_val<long double>(3.0L)) / y.ln() - (x ^ y) +
+                                   (m_val<long double>(2.0L) + m_val<long double>(3.0L)) * y.exp() * x.cos();
+    map<string, long double> context = {{"x", 0.7L}, {"y", 1.3L}};
+
+    FrozenExpression<long double> frozen(expr);
+    EXPECT_EQ(frozen.size(), expr.unique_node_count());
+    EXPECT_EQ(frozen.variables().size(), 2u);
+    EXPECT_LT(frozen.byte_footprint(), expr.byte_footprint());
+    EXPECT_TRUE(structurally_equal(frozen.expression(), expr));
+    EXPECT_EQ(frozen.eval(context), expr.eval(context));
+    vector<long double> registers(frozen.size());
+    vector<long double> values;
+    for (uint32_t id : frozen.variables()) values.push_back(context.at(symbol_name(id)));
+    EXPECT_EQ(frozen.eval(values.data(), registers.data()), expr.eval(context));
+    EXPECT_EQ(frozen.prettify().expression().to_string(), expr.prettify().to_string());
+
+    for (const string &by : vector<string>{"x", "y", "z"}) {
+        FrozenExpression<long double> derivative = frozen.diff(by);
+        EXPECT_EQ(derivative.expression().to_string(), expr.diff(by).to_string());
+        EXPECT_EQ(derivative.prettify().expression().to_string(), expr.diff(by).prettify().to_string());
+        EXPECT_EQ(derivative.prettify().eval(context), expr.diff(by).prettify().eval(context));
+    }
+
+    // Generated expressions with shared subexpressions and every operation.
+    for (uint64_t seed = 1; seed <= 10; seed++) {
+        GeneratorOptions options;
+        options.seed = seed;
+        options.nodes = 60;
+        options.depth = 8;
+        options.variables = 2;
+        options.sharing = 0.3;
+        ExpressionGenerator generator(options);
+        Expression<long double> generated = generator.expression();
+        const string &by = generator.variables()[0];
+
+        FrozenExpression<long double> derivative = FrozenExpression<long double>(generated).diff(by).prettify();
+        EXPECT_TRUE(structurally_equal(derivative.expression(), generated.diff(by).prettify()))
+            << ExpressionGenerator::text(generated);
+    }
+}
+
+// Test SparseJacobian
+TEST_F(ExpressionTest, SparseJacobianPattern) {
+    Expression<long double> x = m_var<long double>("x");
+    Expression<long double> y = m_var<long double>("y");
+    Expression<long double> z = m_var<long double>("z");
+    Expression<long double> a = m_var<long double>("a");
+    vector<Expression<long double>> functions = {x * y, z.sin(), m_val<long double>(2.0L), a * z + x};
+
+    ThreadPool pool(2);
+    SparseJacobian<long double> jacobian(functions, {"x", "y", "z"}, pool);
+    EXPECT_EQ(jacobian.rows(), 4u);
+    EXPECT_EQ(jacobian.cols(), 3u);
+    EXPECT_EQ(jacobian.row_offsets(), (vector<size_t>{0, 2, 3, 3, 5}));
+    EXPECT_EQ(jacobian.columns(), (vector<size_t>{0, 1, 2, 0, 2}));
+    EXPECT_EQ(jacobian.row_indices(), (vector<size_t>{0, 0, 1, 3, 3}));
+
+    SparseJacobian<long double> serial(functions, {"x", "y", "z"});
+    for (size_t k = 0; k < jacobian.nonzeros(); k++) {
+        EXPECT_EQ(jacobian.derivatives()[k].to_string(), serial.derivatives()[k].to_string());
+    }
+
+    map<string, long double> context = {{"x", 2.0L}, {"y", 3.0L}, {"z", 0.0L}, {"a", 5.0L}};
+    vector<long double> values = jacobian.eval(context);
+    EXPECT_EQ(values, (vector<long double>{3.0L, 2.0L, 1.0L, 1.0L, 5.0L}));
+
+    // The parameter "a" is not a Jacobian variable, so batch evaluation rejects it.
+    EXPECT_THROW(jacobian.eval_batch({{1.0L, 2.0L, 3.0L}}), runtime_error);
+    SparseJacobian<long double> closed({x * y, z.sin()}, {"x", "y", "z"});
+    vector<vector<long double>> batch = closed.eval_batch({{2.0L, 3.0L, 0.0L}, {1.0L, 4.0L, 0.0L}});
+    EXPECT_EQ(batch, (vector<vector<long double>>{{3.0L, 2.0L, 1.0L}, {4.0L, 1.0L, 1.0L}}));
+}
+
+// Test Server protocol
+TEST_F(ExpressionTest, ServerProtocol) {
+    Server server("unused.sock", 1);
+    EXPECT_EQ(server.handle("EVAL x * y + 1 | x=2 y=3"), "OK 7");
+    EXPECT_EQ(server.handle("DIFF x * y | x"), "OK y");
+    EXPECT_EQ(server.handle("GRAD x * y + x | x=2 y=3"), "OK 4 2");
+    EXPECT_EQ(server.handle("BATCH x - y | y x | 1 2 ; 5 3"), "OK 1 -2");
+    EXPECT_EQ(server.handle("EVAL x * y + 1 | x=1 y=1"), "OK 2");
+    EXPECT_EQ(server.handle("EVAL x +"), "ERR Got unexpected token \"\" of type 11");
+    EXPECT_EQ(server.handle("NOPE"), "ERR Unknown command \"NOPE\"");
+    EXPECT_EQ(server.handle("STATS").compare(0, 7, "OK hits"), 0);
+}
+
+TEST_F(ExpressionTest, ServerQueuesRequestsNotConnections) {
+    string path = (filesystem::temp_directory_path() / "differentiator_server_test.sock").string();
+    Server server(path, 1, 4);
+    thread runner([&server] { server.run(); });
+
+    auto connect_client = [&path] {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+        int client = socket(AF_UNIX, SOCK_STREAM, 0);
+        while (connect(client, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            this_thread::sleep_for(chrono::milliseconds(10));
+        }
+        // A reply that never arrives fails the test instead of hanging it.
+        timeval timeout{5, 0};
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        return client;
+    };
+    auto exchange = [](int client, const string &request, size_t lines = 1) {
+        send(client, request.data(), request.size(), MSG_NOSIGNAL);
+        string reply;
+        char chunk[256];
+        while (size_t(count(reply.begin(), reply.end(), '\n')) < lines) {
+            ssize_t received = recv(client, chunk, sizeof(chunk), 0);
+            if (received <= 0) break;
+            reply.append(chunk, size_t(received));
+        }
+        return reply;
+    };
+
+    // With one worker an idle open connection does not block other clients,
+    // and pipelined requests are answered in order.
+    int first = connect_client();
+    int second = connect_client();
+    EXPECT_EQ(exchange(first, "EVAL x + 1 | x=1\n"), "OK 2\n");
+    EXPECT_EQ(exchange(second, "EVAL x * 3 | x=2\nDIFF x * y | x\n", 2), "OK 6\nOK y\n");
+    EXPECT_EQ(exchange(first, "EVAL x - 1 | x=1\n"), "OK 0\n");
+
+    // A request without a newline is cut off at the size limit and the connection
+    // is closed (reset, if the rest of the request was left unread).
+    string endless(Server::MAX_REQUEST_SIZE + 4096, 'x');
+    string reply = exchange(second, endless);
+    EXPECT_EQ(reply.compare(0, 4, "ERR "), 0);
+    char rest;
+    EXPECT_LE(recv(second, &rest, 1, 0), 0);
+
+    close(first);
+    close(second);
+    server.stop();
+    runner.join();
+}
+
+TEST_F(ExpressionTest, ServerKeepsServingWhileClientDoesNotRead) {
+    string path = (filesystem::temp_directory_path() / "differentiator_server_stall.sock").string();
+    Server server(path, 2, 4);
+    thread runner([&server] { server.run(); });
+
+    auto connect_client = [&path] {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+        int client = socket(AF_UNIX, SOCK_STREAM, 0);
+        while (connect(client, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            this_thread::sleep_for(chrono::milliseconds(10));
+        }
+        timeval timeout{5, 0};
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        return client;
+    };
+
+    // The first client pipelines far more replies than the socket buffers hold and never reads them.
+    int stalled = connect_client();
+    thread flooder([stalled] {
+        string request = "DIFF x * x * x * x * x * x * x * x * x * x | x\n";
+        string flood;
+        for (int i = 0; i < 100000; i++) flood += request;
+        for (size_t sent = 0; sent < flood.size();) {
+            ssize_t written = send(stalled, flood.data() + sent, flood.size() - sent, MSG_NOSIGNAL);
+            if (written <= 0) break;
+            sent += size_t(written);
+        }
+    });
+    this_thread::sleep_for(chrono::milliseconds(200));
+
+    // Another client is still answered.
+    int other = connect_client();
+    string request = "EVAL x + 1 | x=1\n";
+    send(other, request.data(), request.size(), MSG_NOSIGNAL);
+    char reply[16] = {};
+    EXPECT_EQ(recv(other, reply, sizeof(reply) - 1, 0), 5);
+    EXPECT_STREQ(reply, "OK 2\n");
+
+    // Closing the stalled client unblocks its sender and lets the server stop.
+    shutdown(stalled, SHUT_RDWR);
+    flooder.join();
+    close(stalled);
+    close(other);
+    server.stop();
+    runner.join();
+}
+
+// Test ExpressionGenerator
+TEST_F(ExpressionTest, GeneratorTextRoundTrip) {
+    GeneratorOptions options;
+    options.seed = 7;
+    options.nodes = 500;
+    options.depth = 12;
+    options.variables = 3;
+    options.sharing = 0.2;
+
+    Expression<long double> first = ExpressionGenerator(options).expression();
+    Expression<long double> second = ExpressionGenerator(options).expression();
+    EXPECT_EQ(structural_hash(first), structural_hash(second));
+    EXPECT_EQ(first.unique_node_count(), options.nodes);
+
+    // The parsed text has no shared subexpressions.
+    Lexer lexer{ExpressionGenerator::text(first)};
+    Parser<long double> parser{lexer};
+    Expression<long double> parsed = parser.parseExpression();
+    EXPECT_TRUE(structurally_equal(parsed, first));
+    EXPECT_GT(parsed.unique_node_count(), options.nodes);
+}
+
+TEST_F(ExpressionTest, GeneratorDerivativeMatchesNumeric) {
+    for (uint64_t seed = 1; seed <= 20; seed++) {
+        GeneratorOptions options;
+        options.seed = seed;
+        options.nodes = 40;
+        options.depth = 8;
+        options.variables = 2;
+
+        ExpressionGenerator generator(options);
+        Expression<long double> expr = generator.expression();
+        DerivativeCheck check = generator.check_derivative(expr, expr.diff("x").prettify(), "x", 10);
+        EXPECT_EQ(check.mismatches, 0u) << ExpressionGenerator::text(expr);
+        EXPECT_EQ(check.points + check.skipped, 10u);
+    }
+}
+
+// Test Stats
+TEST_F(ExpressionTest, StatsMeasuresPhases) {
+    Stats stats;
+    vector<Token> tokens = stats.phase("lex", [] { return Lexer{"sin(x) * sin(x)"}.tokenize(); });
+    EXPECT_EQ(tokens.size(), 10u);
+    EXPECT_EQ(tokens.back().type, TOK_EOF);
+
+    Lexer lexer{tokens};
+    Parser<long double> parser{lexer};
+    Expression<long double> expr = stats.phase("parse", [&] { return parser.parseExpression(); });
+    stats.measure(expr);
+
+    ASSERT_EQ(stats.phases().size(), 2u);
+    EXPECT_EQ(stats.phases()[1].name, "parse");
+    EXPECT_GT(stats.phases()[1].allocations, 0u);
+    EXPECT_EQ(stats.phases()[1].nodes, 5u);
+    EXPECT_EQ(stats.phases()[1].depth, 3u);
+
+    // Allocations on other threads and over-aligned allocations are counted.
+    struct alignas(64) Aligned { char data[64]; };
+    Stats threaded;
+    threaded.phase("threads", [] {
+        thread([] { delete new Aligned; }).join();
+    });
+    EXPECT_GE(threaded.phases()[0].allocations, 1u);
+    EXPECT_GE(threaded.phases()[0].bytes, sizeof(Aligned));
+
+    // A disabled collector only runs the phases.
+    Stats disabled(false);
+    EXPECT_EQ(disabled.phase("parse", [] { return 42; }), 42);
+    disabled.measure(expr);
+    EXPECT_TRUE(disabled.phases().empty());
+}
+
+// Test Expression metrics
+TEST_F(ExpressionTest, ExpressionMetrics) {
+    Expression<long double> shared = m_var<long double>("x").sin();
+    Expression<long double> expr = shared * shared + m_var<long double>("y");
+    EXPECT_EQ(expr.node_count(), 7u);
+    EXPECT_EQ(expr.unique_node_count(), 5u);
+    EXPECT_EQ(expr.depth(), 4u);
+    EXPECT_EQ(expr.free_variables(), (set<string>{"x", "y"}));
+    EXPECT_EQ(expr.histogram()[NODE_SIN], 1u);
+    EXPECT_EQ(expr.histogram()[NODE_VARIABLE], 2u);
+    EXPECT_GT(expr.byte_footprint(), (shared * shared).byte_footprint());
+
+    // The single-value accessors agree with the combined pass.
+    Expression<long double> mixed = expr.diff("x") * m_val<long double>(2.0L) + expr.ln();
+    ExpressionMetrics metrics = mixed.metrics();
+    EXPECT_EQ(mixed.node_count(), metrics.nodes);
+    EXPECT_EQ(mixed.unique_node_count(), metrics.uniqueNodes);
+    EXPECT_EQ(mixed.depth(), metrics.depth);
+    EXPECT_EQ(mixed.free_variables(), metrics.freeVariables);
+    EXPECT_EQ(mixed.histogram(), metrics.histogram);
+    EXPECT_EQ(mixed.byte_footprint(), metrics.bytes);
+}
+
+// Test Profiler
+TEST_F(ExpressionTest, ProfilerCountsCalls) {
+    Expression<long double> x = m_var<long double>("x");
+    Expression<long double> shared = x.sin();
+    Expression<long double> expr = (x ^ m_val<long double>(2.0L)) + shared * shared;
+    map<string, long double> context = {{"x", 0.5L}};
+
+    Profiler<long double> profiler(expr);
+    for (int i = 0; i < 3; i++) {
+        EXPECT_EQ(profiler.eval(context), expr.eval(context));
+    }
+
+    map<NodeType, ProfileCounters> types = profiler.by_type();
+    EXPECT_EQ(types[NODE_ADD].calls, 3u);
+    EXPECT_EQ(types[NODE_SIN].calls, 6u);
+    EXPECT_EQ(types[NODE_VARIABLE].calls, 9u);
+    EXPECT_EQ(profiler.by_node()[shared.impl().get()].calls, 6u);
+    EXPECT_GE(types[NODE_ADD].cycles, types[NODE_ADD].selfCycles);
+
+    string folded = profiler.folded();
+    EXPECT_NE(folded.find("OperationAdd;OperationMul#1;OperationSin#1;Variable#0 "), string::npos);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
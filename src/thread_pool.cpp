@@ -0,0 +1,149 @@
+#include <thread_pool.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <exception>
+
+ThreadPool::ThreadPool(size_t workers, size_t capacity) :
+    workers_   (),
+    queue_     (),
+    capacity_  (capacity == 0 ? 1 : capacity),
+    active_    (0),
+    stopping_  (false),
+    mutex_     (),
+    available_ (),
+    space_     (),
+    idle_      ()
+{
+    if (workers == 0) {
+        workers = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    workers_.reserve(workers);
+    for (size_t i = 0; i < workers; i++) {
+        workers_.emplace_back([this] { work(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    available_.notify_all();
+    space_.notify_all();
+
+    for (std::thread &worker : workers_) {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    space_.wait(lock, [this] { return queue_.size() < capacity_ || stopping_; });
+    queue_.push_back(std::move(task));
+
+    lock.unlock();
+    available_.notify_one();
+}
+
+bool ThreadPool::try_submit(std::function<void()> task) {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    if (queue_.size() >= capacity_ || stopping_) {
+        return false;
+    }
+    queue_.push_back(std::move(task));
+
+    lock.unlock();
+    available_.notify_one();
+    return true;
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    idle_.wait(lock, [this] { return queue_.empty() && active_ == 0; });
+}
+
+void ThreadPool::parallel_for(size_t count, const std::function<void(size_t)> &body) {
+    if (count == 0) return;
+
+    // Состояние разделяется с задачами, которые могут начаться уже после возврата из функции:
+    // такие задачи не получают индексов и не обращаются к body.
+    struct State {
+        std::atomic<size_t> next{0};
+        std::mutex mutex;
+        std::condition_variable finished;
+        size_t done = 0;
+        std::exception_ptr error;
+    };
+    std::shared_ptr<State> state = std::make_shared<State>();
+
+    auto run = [state, &body, count] {
+        size_t index;
+        while ((index = state->next.fetch_add(1)) < count) {
+            std::exception_ptr error;
+            try {
+                body(index);
+            }
+            catch (...) {
+                error = std::current_exception();
+            }
+
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (error && !state->error) state->error = error;
+            if (++state->done == count) state->finished.notify_all();
+        }
+    };
+
+    // Помощники ставятся без ожидания: при заполненной очереди работу выполнит вызывающий поток.
+    for (size_t i = 1; i < std::min(count, workers_.size() + 1); i++) {
+        if (!try_submit(run)) break;
+    }
+    run();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished.wait(lock, [&] { return state->done == count; });
+
+    if (state->error) std::rethrow_exception(state->error);
+}
+
+size_t ThreadPool::size() const {
+    return workers_.size();
+}
+
+void ThreadPool::work() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+
+            available_.wait(lock, [this] { return !queue_.empty() || stopping_; });
+            // Оставшиеся в очереди задачи выполняются до завершения работы пула.
+            if (queue_.empty()) return;
+
+            task = std::move(queue_.front());
+            queue_.pop_front();
+            active_++;
+        }
+        space_.notify_one();
+
+        // Исключение в задаче не должно завершать работу исполнителя.
+        try {
+            task();
+        }
+        catch (...) {
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            active_--;
+            if (queue_.empty() && active_ == 0) {
+                idle_.notify_all();
+            }
+        }
+    }
+}
\ No newline at end of file